@@ -1,3 +1,14 @@
 @echo off
-g++ -std=c++17 -O2 src\aes.cpp src\cbc.cpp src\main.cpp -o aes_tool.exe
+set CORE=src\aes.cpp src\aes_ni.cpp src\aes_bitslice.cpp src\cpu_features.cpp src\cbc.cpp src\cbc_parallel.cpp src\thread_pool.cpp src\file_io.cpp src\pipeline.cpp src\async_io.cpp src\batch.cpp src\key_cache.cpp src\server.cpp src\ctr.cpp src\gcm.cpp
+set PERF=src\cycle_counter.cpp src\perf_stats.cpp src\perf_counters.cpp src\perf_env.cpp src\perf.cpp
+set FLAGS=-std=c++17 -O2 -pthread
+g++ %FLAGS% %CORE% src\main.cpp -o aes_tool.exe
 echo Built aes_tool.exe
+
+rem aes_perf --json ghi lai co build va commit: truyen vao luc build (ngoai git repo thi bo trong)
+set GIT_HASH=
+for /f %%i in ('git describe --always --dirty 2^>NUL') do set GIT_HASH=%%i
+set HASH_DEF=
+if defined GIT_HASH set HASH_DEF=-DAES_PERF_GIT_HASH=\"%GIT_HASH%\"
+g++ %FLAGS% "-DAES_PERF_BUILD_FLAGS=\"%FLAGS%\"" %HASH_DEF% %CORE% %PERF% -o aes_perf.exe
+echo Built aes_perf.exe
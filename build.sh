@@ -1,3 +1,12 @@
 #!/bin/bash
-g++ -std=c++17 -O2 src/aes.cpp src/cbc.cpp src/main.cpp -o aes_tool
+CORE="src/aes.cpp src/aes_ni.cpp src/aes_bitslice.cpp src/cpu_features.cpp src/cbc.cpp src/cbc_parallel.cpp src/thread_pool.cpp src/file_io.cpp src/pipeline.cpp src/async_io.cpp src/batch.cpp src/key_cache.cpp src/server.cpp src/ctr.cpp src/gcm.cpp"
+PERF="src/cycle_counter.cpp src/perf_stats.cpp src/perf_counters.cpp src/perf_env.cpp src/perf.cpp"
+FLAGS="-std=c++17 -O2 -pthread"
+g++ $FLAGS $CORE src/main.cpp -o aes_tool
 echo "Built aes_tool"
+
+# aes_perf --json ghi lại cờ build và commit: truyền vào lúc build (ngoài git repo thì bỏ trống)
+GIT_HASH=$(git describe --always --dirty 2>/dev/null)
+g++ $FLAGS -DAES_PERF_BUILD_FLAGS="\"$FLAGS\"" ${GIT_HASH:+-DAES_PERF_GIT_HASH="\"$GIT_HASH\""} \
+    $CORE $PERF -o aes_perf
+echo "Built aes_perf"
@@ -1,8 +1,12 @@
 #include "aes.h"
+#include "aes_ni.h"
+#include "aes_bitslice.h"
+#include <array>
 #include <cstring> // memcpy
+#include <stdexcept>
 
 // S-box chuẩn AES
-static const uint8_t sbox[256] = {
+static constexpr uint8_t sbox[256] = {
     0x63, 0x7c, 0x77, 0x7b, 0xf2, 0x6b, 0x6f, 0xc5, 0x30, 0x01, 0x67, 0x2b, 0xfe, 0xd7, 0xab, 0x76,
     0xca, 0x82, 0xc9, 0x7d, 0xfa, 0x59, 0x47, 0xf0, 0xad, 0xd4, 0xa2, 0xaf, 0x9c, 0xa4, 0x72, 0xc0,
     0xb7, 0xfd, 0x93, 0x26, 0x36, 0x3f, 0xf7, 0xcc, 0x34, 0xa5, 0xe5, 0xf1, 0x71, 0xd8, 0x31, 0x15,
@@ -20,25 +24,110 @@ static const uint8_t sbox[256] = {
     0xe1, 0xf8, 0x98, 0x11, 0x69, 0xd9, 0x8e, 0x94, 0x9b, 0x1e, 0x87, 0xe9, 0xce, 0x55, 0x28, 0xdf,
     0x8c, 0xa1, 0x89, 0x0d, 0xbf, 0xe6, 0x42, 0x68, 0x41, 0x99, 0x2d, 0x0f, 0xb0, 0x54, 0xbb, 0x16};
 
-// inverse S-box
-static uint8_t inv_sbox[256];
-
 // Rcon (chỉ dùng 1..10)
 static const uint8_t Rcon[11] = {
     0x00,
     0x01, 0x02, 0x04, 0x08, 0x10,
     0x20, 0x40, 0x80, 0x1B, 0x36};
 
-// Khởi tạo inv_sbox (chỉ chạy 1 lần)
-static bool init_inv_sbox()
+// ===== Bảng sinh lúc compile từ sbox =====
+
+static constexpr uint8_t ct_xtime(uint8_t a)
+{
+    return static_cast<uint8_t>((a << 1) ^ ((a & 0x80) ? 0x1B : 0x00));
+}
+
+static constexpr uint8_t ct_gf_mul(uint8_t a, uint8_t b)
+{
+    uint8_t res = 0;
+    for (int i = 0; i < 8; ++i)
+    {
+        if (b & 1)
+            res ^= a;
+        a = ct_xtime(a);
+        b >>= 1;
+    }
+    return res;
+}
+
+static constexpr std::array<uint8_t, 256> makeInvSbox()
 {
+    std::array<uint8_t, 256> inv{};
     for (int i = 0; i < 256; ++i)
     {
-        inv_sbox[sbox[i]] = static_cast<uint8_t>(i);
+        inv[sbox[i]] = static_cast<uint8_t>(i);
     }
-    return true;
+    return inv;
+}
+
+// inverse S-box
+static constexpr std::array<uint8_t, 256> inv_sbox = makeInvSbox();
+
+static constexpr uint32_t pack(uint8_t b0, uint8_t b1, uint8_t b2, uint8_t b3)
+{
+    return (static_cast<uint32_t>(b0) << 24) | (static_cast<uint32_t>(b1) << 16) |
+           (static_cast<uint32_t>(b2) << 8) | static_cast<uint32_t>(b3);
+}
+
+static constexpr uint32_t rotr32(uint32_t x, int n)
+{
+    return (x >> n) | (x << (32 - n));
+}
+
+// Te[k][x] = cột MixColumns của SubBytes(x) đặt ở hàng k (Te1..Te3 = Te0 xoay phải 8/16/24 bit)
+// Td[k][x] tương tự với InvMixColumns(InvSubBytes(x))
+struct TTables
+{
+    uint32_t Te[4][256];
+    uint32_t Td[4][256];
+};
+
+static constexpr TTables makeTTables()
+{
+    TTables t{};
+    for (int x = 0; x < 256; ++x)
+    {
+        uint8_t s = sbox[x];
+        uint32_t te = pack(ct_gf_mul(s, 0x02), s, s, ct_gf_mul(s, 0x03));
+
+        uint8_t si = inv_sbox[x];
+        uint32_t td = pack(ct_gf_mul(si, 0x0e), ct_gf_mul(si, 0x09),
+                           ct_gf_mul(si, 0x0d), ct_gf_mul(si, 0x0b));
+
+        t.Te[0][x] = te;
+        t.Td[0][x] = td;
+        for (int k = 1; k < 4; ++k)
+        {
+            t.Te[k][x] = rotr32(te, 8 * k);
+            t.Td[k][x] = rotr32(td, 8 * k);
+        }
+    }
+    return t;
+}
+
+static constexpr TTables ttables = makeTTables();
+
+static constexpr const uint32_t *Te0 = ttables.Te[0];
+static constexpr const uint32_t *Te1 = ttables.Te[1];
+static constexpr const uint32_t *Te2 = ttables.Te[2];
+static constexpr const uint32_t *Te3 = ttables.Te[3];
+static constexpr const uint32_t *Td0 = ttables.Td[0];
+static constexpr const uint32_t *Td1 = ttables.Td[1];
+static constexpr const uint32_t *Td2 = ttables.Td[2];
+static constexpr const uint32_t *Td3 = ttables.Td[3];
+
+static inline uint32_t load32be(const uint8_t *p)
+{
+    return pack(p[0], p[1], p[2], p[3]);
+}
+
+static inline void store32be(uint8_t *p, uint32_t v)
+{
+    p[0] = static_cast<uint8_t>(v >> 24);
+    p[1] = static_cast<uint8_t>(v >> 16);
+    p[2] = static_cast<uint8_t>(v >> 8);
+    p[3] = static_cast<uint8_t>(v);
 }
-static bool inv_sbox_initialized = init_inv_sbox();
 
 // Truy cập state: dùng layout column-major
 // state[4*c + r] với r,c ∈ {0..3}
@@ -132,14 +221,10 @@ static void InvShiftRows(uint8_t state[16])
         get(3, c) = row3_rot[c];
 }
 
-static uint8_t xtime(uint8_t a)
+// nhân {02} trong GF(2^8), không rẽ nhánh
+static inline uint8_t xtime(uint8_t a)
 {
-    uint16_t x = static_cast<uint16_t>(a) << 1;
-    if (x & 0x100)
-    {
-        x ^= 0x11B;
-    }
-    return static_cast<uint8_t>(x & 0xFF);
+    return static_cast<uint8_t>((a << 1) ^ (0x1B & -(a >> 7)));
 }
 
 static void MixColumns(uint8_t state[16])
@@ -162,45 +247,28 @@ static void MixColumns(uint8_t state[16])
     }
 }
 
-static uint8_t gf_mul(uint8_t a, uint8_t b)
-{
-    uint8_t res = 0;
-    for (int i = 0; i < 8; ++i)
-    {
-        if (b & 1)
-        {
-            res ^= a;
-        }
-        uint8_t hi = a & 0x80;
-        a <<= 1;
-        if (hi)
-        {
-            a ^= 0x1B;
-        }
-        b >>= 1;
-    }
-    return res;
-}
-
+// InvMixColumns chỉ dùng xtime (không còn gf_mul bit-serial):
+// ma trận InvMixColumns = MixColumns x (05, 00, 04, 00) (circulant), nên
+// nhân trước với {04}·(a0^a2), {04}·(a1^a3) rồi gọi MixColumns.
 static void InvMixColumns(uint8_t state[16])
 {
     for (int c = 0; c < 4; ++c)
     {
         int idx = 4 * c;
-        uint8_t a0 = state[idx + 0];
-        uint8_t a1 = state[idx + 1];
-        uint8_t a2 = state[idx + 2];
-        uint8_t a3 = state[idx + 3];
+        uint8_t u = xtime(xtime(state[idx + 0] ^ state[idx + 2]));
+        uint8_t v = xtime(xtime(state[idx + 1] ^ state[idx + 3]));
 
-        uint8_t s0 = gf_mul(a0, 0x0e) ^ gf_mul(a1, 0x0b) ^ gf_mul(a2, 0x0d) ^ gf_mul(a3, 0x09);
-        uint8_t s1 = gf_mul(a0, 0x09) ^ gf_mul(a1, 0x0e) ^ gf_mul(a2, 0x0b) ^ gf_mul(a3, 0x0d);
-        uint8_t s2 = gf_mul(a0, 0x0d) ^ gf_mul(a1, 0x09) ^ gf_mul(a2, 0x0e) ^ gf_mul(a3, 0x0b);
-        uint8_t s3 = gf_mul(a0, 0x0b) ^ gf_mul(a1, 0x0d) ^ gf_mul(a2, 0x09) ^ gf_mul(a3, 0x0e);
+        uint8_t a0 = state[idx + 0] ^ u;
+        uint8_t a1 = state[idx + 1] ^ v;
+        uint8_t a2 = state[idx + 2] ^ u;
+        uint8_t a3 = state[idx + 3] ^ v;
 
-        state[idx + 0] = s0;
-        state[idx + 1] = s1;
-        state[idx + 2] = s2;
-        state[idx + 3] = s3;
+        // MixColumns trên cột đã nhân trước
+        uint8_t t = a0 ^ a1 ^ a2 ^ a3;
+        state[idx + 0] = a0 ^ t ^ xtime(a0 ^ a1);
+        state[idx + 1] = a1 ^ t ^ xtime(a1 ^ a2);
+        state[idx + 2] = a2 ^ t ^ xtime(a2 ^ a3);
+        state[idx + 3] = a3 ^ t ^ xtime(a3 ^ a0);
     }
 }
 
@@ -225,13 +293,102 @@ static void SubWord(uint8_t w[4])
 
 // --- AES128 implementation ---
 
-AES128::AES128(const uint8_t key[16])
+static AES128::Backend detectBestBackend()
+{
+    if (aesniAvailable())
+        return AES128::Backend::AesNi;
+    // không có AES-NI: ưu tiên engine constant-time
+    return bitsliceAvailable() ? AES128::Backend::Bitslice : AES128::Backend::TTable;
+}
+
+static AES128::Backend g_defaultBackend = detectBestBackend();
+
+void AES128::setDefaultBackend(Backend backend)
+{
+    if (backend == Backend::Auto)
+    {
+        g_defaultBackend = detectBestBackend();
+        return;
+    }
+    if (!isBackendAvailable(backend))
+    {
+        throw std::runtime_error(std::string("AES backend not available on this CPU: ") +
+                                 backendName(backend));
+    }
+    g_defaultBackend = backend;
+}
+
+AES128::Backend AES128::defaultBackend()
+{
+    return g_defaultBackend;
+}
+
+bool AES128::isBackendAvailable(Backend backend)
+{
+    if (backend == Backend::AesNi)
+        return aesniAvailable();
+    if (backend == Backend::Bitslice)
+        return bitsliceAvailable();
+    return true;
+}
+
+const char *AES128::backendName(Backend backend)
+{
+    switch (backend)
+    {
+    case Backend::Auto:
+        return "auto";
+    case Backend::Byte:
+        return "byte";
+    case Backend::TTable:
+        return "ttable";
+    case Backend::AesNi:
+        return "aesni";
+    case Backend::Bitslice:
+        return "bitslice";
+    }
+    return "unknown";
+}
+
+AES128::Backend AES128::parseBackend(const std::string &name)
+{
+    const Backend all[] = {Backend::Auto, Backend::Byte, Backend::TTable, Backend::AesNi,
+                           Backend::Bitslice};
+    for (Backend b : all)
+    {
+        if (name == backendName(b))
+            return b;
+    }
+    throw std::runtime_error("Unknown AES backend: " + name +
+                             " (expected auto|byte|ttable|aesni|bitslice)");
+}
+
+AES128::AES128(const uint8_t key[16], Backend backend)
+    : engine(backend == Backend::Auto ? g_defaultBackend : backend)
 {
+    if (!isBackendAvailable(engine))
+    {
+        throw std::runtime_error(std::string("AES backend not available on this CPU: ") +
+                                 backendName(engine));
+    }
     keyExpansion(key);
 }
 
 void AES128::keyExpansion(const uint8_t key[16])
 {
+    if (engine == Backend::AesNi)
+    {
+        // AESKEYGENASSIST + AESIMC, cùng layout roundKeys/decRoundKeys
+        aesniExpandKey(key, roundKeys, decRoundKeys);
+        return;
+    }
+    if (engine == Backend::Bitslice)
+    {
+        // SubWord qua mạch S-box, không tra bảng; dec dùng chung roundKeys
+        bitsliceExpandKey(key, roundKeys, bitsliceKeys);
+        return;
+    }
+
     // AES-128: Nk=4, Nr=10, Nb=4, tổng 44 word = 176 byte
     uint8_t w[44][4];
 
@@ -274,9 +431,146 @@ void AES128::keyExpansion(const uint8_t key[16])
             roundKeys[idx++] = w[i][j];
         }
     }
+
+    // decRoundKeys: round 0 và 10 giữ nguyên, round 1..9 qua InvMixColumns
+    // (chỉ tính 1 lần cho mỗi key)
+    std::memcpy(decRoundKeys, roundKeys, 176);
+    for (int round = 1; round <= 9; ++round)
+    {
+        InvMixColumns(decRoundKeys + round * 16);
+    }
+
+    for (int i = 0; i < 44; ++i)
+    {
+        encWords[i] = load32be(roundKeys + 4 * i);
+        decWords[i] = load32be(decRoundKeys + 4 * i);
+    }
 }
 
 void AES128::encryptBlock(const uint8_t in[16], uint8_t out[16]) const
+{
+    switch (engine)
+    {
+    case Backend::AesNi:
+        aesniEncryptBlock(roundKeys, in, out);
+        break;
+    case Backend::Bitslice:
+        bitsliceEncryptBlocks(bitsliceKeys, in, out, 1);
+        break;
+    case Backend::TTable:
+        encryptBlockTTable(in, out);
+        break;
+    default:
+        encryptBlockByte(in, out);
+        break;
+    }
+}
+
+void AES128::decryptBlock(const uint8_t in[16], uint8_t out[16]) const
+{
+    switch (engine)
+    {
+    case Backend::AesNi:
+        aesniDecryptBlock(decRoundKeys, in, out);
+        break;
+    case Backend::Bitslice:
+        bitsliceDecryptBlocks(bitsliceKeys, in, out, 1);
+        break;
+    case Backend::TTable:
+        decryptBlockTTable(in, out);
+        break;
+    default:
+        decryptBlockByte(in, out);
+        break;
+    }
+}
+
+void AES128::encryptBlocks(const uint8_t *in, uint8_t *out, std::size_t nblocks) const
+{
+    switch (engine)
+    {
+    case Backend::AesNi:
+        aesniEncryptBlocks(roundKeys, in, out, nblocks);
+        return;
+    case Backend::Bitslice:
+        bitsliceEncryptBlocks(bitsliceKeys, in, out, nblocks);
+        return;
+    case Backend::TTable:
+        for (; nblocks >= 4; nblocks -= 4, in += 64, out += 64)
+        {
+            encryptBlocks4TTable(in, out);
+        }
+        break;
+    default:
+        break;
+    }
+
+    for (; nblocks > 0; --nblocks, in += 16, out += 16)
+    {
+        encryptBlock(in, out);
+    }
+}
+
+void AES128::decryptBlocks(const uint8_t *in, uint8_t *out, std::size_t nblocks) const
+{
+    switch (engine)
+    {
+    case Backend::AesNi:
+        aesniDecryptBlocks(decRoundKeys, in, out, nblocks);
+        return;
+    case Backend::Bitslice:
+        bitsliceDecryptBlocks(bitsliceKeys, in, out, nblocks);
+        return;
+    case Backend::TTable:
+        for (; nblocks >= 4; nblocks -= 4, in += 64, out += 64)
+        {
+            decryptBlocks4TTable(in, out);
+        }
+        break;
+    default:
+        break;
+    }
+
+    for (; nblocks > 0; --nblocks, in += 16, out += 16)
+    {
+        decryptBlock(in, out);
+    }
+}
+
+void AES128::encryptBlocksMulti(const AES128 *const ctx[], const uint8_t *const in[],
+                                uint8_t *const out[], std::size_t n)
+{
+    bool allAesNi = n > 0;
+    bool allBitslice = n > 0;
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        allAesNi = allAesNi && ctx[i]->engine == Backend::AesNi;
+        allBitslice = allBitslice && ctx[i]->engine == Backend::Bitslice;
+    }
+
+    if (allAesNi || allBitslice)
+    {
+        const uint8_t *keys[ParallelBlocks];
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            keys[i] = ctx[i]->roundKeys;
+        }
+        if (allAesNi)
+            aesniEncryptBlocksMulti(keys, in, out, n);
+        else
+            bitsliceEncryptBlocksMulti(keys, in, out, n);
+        return;
+    }
+
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        ctx[i]->encryptBlock(in[i], out[i]);
+    }
+}
+
+// ===== Byte engine (bản gốc) =====
+
+void AES128::encryptBlockByte(const uint8_t in[16], uint8_t out[16]) const
 {
     uint8_t state[16];
     std::memcpy(state, in, 16);
@@ -301,27 +595,191 @@ void AES128::encryptBlock(const uint8_t in[16], uint8_t out[16]) const
     std::memcpy(out, state, 16);
 }
 
-void AES128::decryptBlock(const uint8_t in[16], uint8_t out[16]) const
+// Equivalent inverse cipher (FIPS-197 5.3.5): cùng thứ tự bước như encrypt,
+// round key 1..9 đã qua InvMixColumns sẵn (decRoundKeys, tính 1 lần trong keyExpansion).
+void AES128::decryptBlockByte(const uint8_t in[16], uint8_t out[16]) const
 {
     uint8_t state[16];
     std::memcpy(state, in, 16);
 
     // Round 10
-    AddRoundKey(state, roundKeys, 10);
+    AddRoundKey(state, decRoundKeys, 10);
 
     // Rounds 9..1
     for (int round = 9; round >= 1; --round)
     {
-        InvShiftRows(state);
         InvSubBytes(state);
-        AddRoundKey(state, roundKeys, round);
+        InvShiftRows(state);
         InvMixColumns(state);
+        AddRoundKey(state, decRoundKeys, round);
     }
 
     // Round 0
-    InvShiftRows(state);
     InvSubBytes(state);
-    AddRoundKey(state, roundKeys, 0);
+    InvShiftRows(state);
+    AddRoundKey(state, decRoundKeys, 0);
 
     std::memcpy(out, state, 16);
 }
+
+// ===== T-table engine =====
+// state = 4 word big-endian (mỗi word 1 cột); mỗi round gộp
+// SubBytes + ShiftRows + MixColumns + AddRoundKey thành 16 lần tra bảng.
+
+void AES128::encryptBlockTTable(const uint8_t in[16], uint8_t out[16]) const
+{
+    const uint32_t *rk = encWords;
+
+    uint32_t s0 = load32be(in + 0) ^ rk[0];
+    uint32_t s1 = load32be(in + 4) ^ rk[1];
+    uint32_t s2 = load32be(in + 8) ^ rk[2];
+    uint32_t s3 = load32be(in + 12) ^ rk[3];
+    uint32_t t0, t1, t2, t3;
+
+    // Rounds 1..9
+    for (int round = 1; round <= 9; ++round)
+    {
+        rk += 4;
+        t0 = Te0[s0 >> 24] ^ Te1[(s1 >> 16) & 0xff] ^ Te2[(s2 >> 8) & 0xff] ^ Te3[s3 & 0xff] ^ rk[0];
+        t1 = Te0[s1 >> 24] ^ Te1[(s2 >> 16) & 0xff] ^ Te2[(s3 >> 8) & 0xff] ^ Te3[s0 & 0xff] ^ rk[1];
+        t2 = Te0[s2 >> 24] ^ Te1[(s3 >> 16) & 0xff] ^ Te2[(s0 >> 8) & 0xff] ^ Te3[s1 & 0xff] ^ rk[2];
+        t3 = Te0[s3 >> 24] ^ Te1[(s0 >> 16) & 0xff] ^ Te2[(s1 >> 8) & 0xff] ^ Te3[s2 & 0xff] ^ rk[3];
+        s0 = t0;
+        s1 = t1;
+        s2 = t2;
+        s3 = t3;
+    }
+
+    // Round 10: không có MixColumns -> dùng sbox trực tiếp
+    rk += 4;
+    t0 = pack(sbox[s0 >> 24], sbox[(s1 >> 16) & 0xff], sbox[(s2 >> 8) & 0xff], sbox[s3 & 0xff]) ^ rk[0];
+    t1 = pack(sbox[s1 >> 24], sbox[(s2 >> 16) & 0xff], sbox[(s3 >> 8) & 0xff], sbox[s0 & 0xff]) ^ rk[1];
+    t2 = pack(sbox[s2 >> 24], sbox[(s3 >> 16) & 0xff], sbox[(s0 >> 8) & 0xff], sbox[s1 & 0xff]) ^ rk[2];
+    t3 = pack(sbox[s3 >> 24], sbox[(s0 >> 16) & 0xff], sbox[(s1 >> 8) & 0xff], sbox[s2 & 0xff]) ^ rk[3];
+
+    store32be(out + 0, t0);
+    store32be(out + 4, t1);
+    store32be(out + 8, t2);
+    store32be(out + 12, t3);
+}
+
+void AES128::decryptBlockTTable(const uint8_t in[16], uint8_t out[16]) const
+{
+    // equivalent inverse cipher: round key 9..1 lấy từ decWords
+    const uint32_t *rk = decWords + 40;
+
+    uint32_t s0 = load32be(in + 0) ^ rk[0];
+    uint32_t s1 = load32be(in + 4) ^ rk[1];
+    uint32_t s2 = load32be(in + 8) ^ rk[2];
+    uint32_t s3 = load32be(in + 12) ^ rk[3];
+    uint32_t t0, t1, t2, t3;
+
+    // Rounds 9..1
+    for (int round = 9; round >= 1; --round)
+    {
+        rk -= 4;
+        t0 = Td0[s0 >> 24] ^ Td1[(s3 >> 16) & 0xff] ^ Td2[(s2 >> 8) & 0xff] ^ Td3[s1 & 0xff] ^ rk[0];
+        t1 = Td0[s1 >> 24] ^ Td1[(s0 >> 16) & 0xff] ^ Td2[(s3 >> 8) & 0xff] ^ Td3[s2 & 0xff] ^ rk[1];
+        t2 = Td0[s2 >> 24] ^ Td1[(s1 >> 16) & 0xff] ^ Td2[(s0 >> 8) & 0xff] ^ Td3[s3 & 0xff] ^ rk[2];
+        t3 = Td0[s3 >> 24] ^ Td1[(s2 >> 16) & 0xff] ^ Td2[(s1 >> 8) & 0xff] ^ Td3[s0 & 0xff] ^ rk[3];
+        s0 = t0;
+        s1 = t1;
+        s2 = t2;
+        s3 = t3;
+    }
+
+    // Round 0: InvShiftRows + InvSubBytes + AddRoundKey
+    rk -= 4;
+    t0 = pack(inv_sbox[s0 >> 24], inv_sbox[(s3 >> 16) & 0xff], inv_sbox[(s2 >> 8) & 0xff], inv_sbox[s1 & 0xff]) ^ rk[0];
+    t1 = pack(inv_sbox[s1 >> 24], inv_sbox[(s0 >> 16) & 0xff], inv_sbox[(s3 >> 8) & 0xff], inv_sbox[s2 & 0xff]) ^ rk[1];
+    t2 = pack(inv_sbox[s2 >> 24], inv_sbox[(s1 >> 16) & 0xff], inv_sbox[(s0 >> 8) & 0xff], inv_sbox[s3 & 0xff]) ^ rk[2];
+    t3 = pack(inv_sbox[s3 >> 24], inv_sbox[(s2 >> 16) & 0xff], inv_sbox[(s1 >> 8) & 0xff], inv_sbox[s0 & 0xff]) ^ rk[3];
+
+    store32be(out + 0, t0);
+    store32be(out + 4, t1);
+    store32be(out + 8, t2);
+    store32be(out + 12, t3);
+}
+
+// 4 block xen kẽ: 4 chuỗi tra bảng độc lập cho mỗi round,
+// CPU chạy song song thay vì chờ từng block xong.
+
+void AES128::encryptBlocks4TTable(const uint8_t in[64], uint8_t out[64]) const
+{
+    const uint32_t *rk = encWords;
+    uint32_t s[4][4];
+    uint32_t t[4][4];
+
+    for (int b = 0; b < 4; ++b)
+    {
+        for (int c = 0; c < 4; ++c)
+        {
+            s[b][c] = load32be(in + 16 * b + 4 * c) ^ rk[c];
+        }
+    }
+
+    for (int round = 1; round <= 9; ++round)
+    {
+        rk += 4;
+        for (int b = 0; b < 4; ++b)
+        {
+            t[b][0] = Te0[s[b][0] >> 24] ^ Te1[(s[b][1] >> 16) & 0xff] ^ Te2[(s[b][2] >> 8) & 0xff] ^ Te3[s[b][3] & 0xff] ^ rk[0];
+            t[b][1] = Te0[s[b][1] >> 24] ^ Te1[(s[b][2] >> 16) & 0xff] ^ Te2[(s[b][3] >> 8) & 0xff] ^ Te3[s[b][0] & 0xff] ^ rk[1];
+            t[b][2] = Te0[s[b][2] >> 24] ^ Te1[(s[b][3] >> 16) & 0xff] ^ Te2[(s[b][0] >> 8) & 0xff] ^ Te3[s[b][1] & 0xff] ^ rk[2];
+            t[b][3] = Te0[s[b][3] >> 24] ^ Te1[(s[b][0] >> 16) & 0xff] ^ Te2[(s[b][1] >> 8) & 0xff] ^ Te3[s[b][2] & 0xff] ^ rk[3];
+        }
+        std::memcpy(s, t, sizeof(s));
+    }
+
+    rk += 4;
+    for (int b = 0; b < 4; ++b)
+    {
+        for (int c = 0; c < 4; ++c)
+        {
+            uint32_t v = pack(sbox[s[b][c] >> 24], sbox[(s[b][(c + 1) & 3] >> 16) & 0xff],
+                              sbox[(s[b][(c + 2) & 3] >> 8) & 0xff], sbox[s[b][(c + 3) & 3] & 0xff]) ^
+                         rk[c];
+            store32be(out + 16 * b + 4 * c, v);
+        }
+    }
+}
+
+void AES128::decryptBlocks4TTable(const uint8_t in[64], uint8_t out[64]) const
+{
+    const uint32_t *rk = decWords + 40;
+    uint32_t s[4][4];
+    uint32_t t[4][4];
+
+    for (int b = 0; b < 4; ++b)
+    {
+        for (int c = 0; c < 4; ++c)
+        {
+            s[b][c] = load32be(in + 16 * b + 4 * c) ^ rk[c];
+        }
+    }
+
+    for (int round = 9; round >= 1; --round)
+    {
+        rk -= 4;
+        for (int b = 0; b < 4; ++b)
+        {
+            t[b][0] = Td0[s[b][0] >> 24] ^ Td1[(s[b][3] >> 16) & 0xff] ^ Td2[(s[b][2] >> 8) & 0xff] ^ Td3[s[b][1] & 0xff] ^ rk[0];
+            t[b][1] = Td0[s[b][1] >> 24] ^ Td1[(s[b][0] >> 16) & 0xff] ^ Td2[(s[b][3] >> 8) & 0xff] ^ Td3[s[b][2] & 0xff] ^ rk[1];
+            t[b][2] = Td0[s[b][2] >> 24] ^ Td1[(s[b][1] >> 16) & 0xff] ^ Td2[(s[b][0] >> 8) & 0xff] ^ Td3[s[b][3] & 0xff] ^ rk[2];
+            t[b][3] = Td0[s[b][3] >> 24] ^ Td1[(s[b][2] >> 16) & 0xff] ^ Td2[(s[b][1] >> 8) & 0xff] ^ Td3[s[b][0] & 0xff] ^ rk[3];
+        }
+        std::memcpy(s, t, sizeof(s));
+    }
+
+    rk -= 4;
+    for (int b = 0; b < 4; ++b)
+    {
+        for (int c = 0; c < 4; ++c)
+        {
+            uint32_t v = pack(inv_sbox[s[b][c] >> 24], inv_sbox[(s[b][(c + 3) & 3] >> 16) & 0xff],
+                              inv_sbox[(s[b][(c + 2) & 3] >> 8) & 0xff], inv_sbox[s[b][(c + 1) & 3] & 0xff]) ^
+                         rk[c];
+            store32be(out + 16 * b + 4 * c, v);
+        }
+    }
+}
@@ -2,6 +2,7 @@
 
 #include <cstdint>
 #include <cstddef>
+#include <string>
 
 // Triển khai AES-128 (16-byte key, 10 rounds)
 class AES128
@@ -9,8 +10,19 @@ class AES128
 public:
     static constexpr std::size_t BlockSize = 16;
 
+    // Engine dùng để mã hoá/giải mã block
+    enum class Backend
+    {
+        Auto,   // chọn engine nhanh nhất hiện có (xem defaultBackend)
+        Byte,   // bản gốc: SubBytes/ShiftRows/MixColumns từng byte
+        TTable, // bảng tra 32-bit Te0..Te3 / Td0..Td3
+        AesNi,  // lệnh phần cứng AES-NI (x86, kiểm tra bằng CPUID)
+        Bitslice // 8 block/lượt bằng phép bit (SSE2/AVX2), constant-time
+    };
+
     // key: 16 byte
-    AES128(const uint8_t key[16]);
+    // Ném std::runtime_error nếu backend yêu cầu không chạy được trên CPU này
+    explicit AES128(const uint8_t key[16], Backend backend = Backend::Auto);
 
     // Mã hoá 1 block (16 byte)
     void encryptBlock(const uint8_t in[16], uint8_t out[16]) const;
@@ -18,8 +30,56 @@ public:
     // Giải mã 1 block (16 byte)
     void decryptBlock(const uint8_t in[16], uint8_t out[16]) const;
 
+    // Số block xử lý xen kẽ trong encryptBlocks/decryptBlocks
+    static constexpr std::size_t ParallelBlocks = 8;
+
+    // Số block nên gom cho mỗi lần gọi encryptBlocks/decryptBlocks
+    // (đủ cho bitslice AVX2 chạy 16 block/lượt)
+    static constexpr std::size_t BatchBlocks = 16;
+
+    // Mã hoá/giải mã nblocks block độc lập (ECB) liên tiếp trong bộ nhớ.
+    // Các block được xử lý xen kẽ (AES-NI: 8, T-table: 4, bitslice: 8 hoặc 16)
+    // để pipeline luôn đầy.
+    // in và out được phép trùng nhau (in-place).
+    void encryptBlocks(const uint8_t *in, uint8_t *out, std::size_t nblocks) const;
+    void decryptBlocks(const uint8_t *in, uint8_t *out, std::size_t nblocks) const;
+
+    // Multi-buffer: mã hoá 1 block cho mỗi lane, mỗi lane có key riêng
+    // (ctx[i] mã hoá in[i] -> out[i]), n <= ParallelBlocks.
+    // Nếu mọi ctx đều là AesNi (hoặc đều là Bitslice) thì n lane chạy cùng lúc.
+    static void encryptBlocksMulti(const AES128 *const ctx[], const uint8_t *const in[],
+                                   uint8_t *const out[], std::size_t n);
+
+    // Engine thực sự được dùng (không bao giờ là Auto)
+    Backend backend() const { return engine; }
+
+    // Backend mà Backend::Auto sẽ chọn.
+    // Mặc định: AesNi nếu CPU hỗ trợ, ngược lại Bitslice (constant-time),
+    // TTable nếu compiler không có bitslice.
+    // setDefaultBackend(Auto) quay lại chọn tự động.
+    static void setDefaultBackend(Backend backend);
+    static Backend defaultBackend();
+
+    static bool isBackendAvailable(Backend backend);
+    static const char *backendName(Backend backend);
+
+    // "auto" / "byte" / "ttable" / "aesni" / "bitslice" -> Backend (ném lỗi nếu sai)
+    static Backend parseBackend(const std::string &name);
+
 private:
-    uint8_t roundKeys[176]; // 11 * 16
+    alignas(16) uint8_t roundKeys[176]; // 11 * 16
+    alignas(16) uint8_t decRoundKeys[176]; // InvMixColumns(roundKeys) cho round 1..9 (equivalent inverse cipher)
+    uint32_t encWords[44]; // roundKeys dạng word big-endian (TTable)
+    uint32_t decWords[44]; // decRoundKeys dạng word big-endian (TTable)
+    alignas(16) uint8_t bitsliceKeys[11 * 128]; // round key dạng bitslice (Bitslice)
+    Backend engine;
 
     void keyExpansion(const uint8_t key[16]);
+
+    void encryptBlockByte(const uint8_t in[16], uint8_t out[16]) const;
+    void decryptBlockByte(const uint8_t in[16], uint8_t out[16]) const;
+    void encryptBlockTTable(const uint8_t in[16], uint8_t out[16]) const;
+    void decryptBlockTTable(const uint8_t in[16], uint8_t out[16]) const;
+    void encryptBlocks4TTable(const uint8_t in[64], uint8_t out[64]) const;
+    void decryptBlocks4TTable(const uint8_t in[64], uint8_t out[64]) const;
 };
@@ -0,0 +1,668 @@
+#include "aes_bitslice.h"
+#include "cpu_features.h"
+
+#include <cstring>
+#include <stdexcept>
+
+#if defined(__GNUC__) || defined(__clang__)
+#define BITSLICE_COMPILED 1
+#endif
+
+#ifdef BITSLICE_COMPILED
+
+#if defined(__x86_64__) || defined(__i386__)
+#define BITSLICE_AVX2 1
+#define BITSLICE_AVX2_TARGET __attribute__((target("avx2")))
+#endif
+
+#if defined(__GNUC__) && !defined(__clang__)
+// Vec256 trả về từ hàm always_inline: GCC vẫn cảnh báo ABI dù không có lời gọi thật
+#pragma GCC diagnostic ignored "-Wpsabi"
+#endif
+
+#define BS_INLINE inline __attribute__((always_inline))
+
+// Dùng vector extension của GCC/Clang thay vì intrinsic: cùng 1 template
+// build ra SSE2 (x86-64, NEON trên ARM) cho Vec128 và AVX2 cho Vec256
+// khi được inline vào hàm có target("avx2").
+typedef uint32_t Vec128 __attribute__((vector_size(16)));
+typedef uint32_t Vec256 __attribute__((vector_size(32)));
+
+// Layout 1 slice (Vec128): lane 32-bit c = cột c của state, byte r trong lane = hàng r,
+// bit b trong byte = block b. Slice j giữ bit j của mọi byte.
+// -> load block theo thứ tự byte tự nhiên rồi chuyển vị bit (ortho) là xong.
+// Vec256: nửa thấp là block 0..7, nửa cao là block 8..15.
+template <class V>
+struct Lanes;
+
+template <>
+struct Lanes<Vec128>
+{
+    static constexpr std::size_t Blocks = 8;
+
+    // lane c <- lane (c + S) % 4
+    template <int S>
+    static BS_INLINE Vec128 rotateColumns(const Vec128 &x)
+    {
+#if defined(__clang__)
+        return __builtin_shufflevector(x, x, S % 4, (S + 1) % 4, (S + 2) % 4, (S + 3) % 4);
+#else
+        return __builtin_shuffle(x, Vec128{S % 4, (S + 1) % 4, (S + 2) % 4, (S + 3) % 4});
+#endif
+    }
+
+    static BS_INLINE Vec128 load(const uint8_t *in, std::size_t b)
+    {
+        Vec128 v;
+        std::memcpy(&v, in + 16 * b, 16);
+        return v;
+    }
+
+    static BS_INLINE void store(uint8_t *out, std::size_t b, const Vec128 &v)
+    {
+        std::memcpy(out + 16 * b, &v, 16);
+    }
+
+    static BS_INLINE Vec128 loadKey(const uint8_t *k)
+    {
+        Vec128 v;
+        std::memcpy(&v, k, 16);
+        return v;
+    }
+};
+
+template <>
+struct Lanes<Vec256>
+{
+    static constexpr std::size_t Blocks = 16;
+
+    template <int S>
+    static BS_INLINE Vec256 rotateColumns(const Vec256 &x)
+    {
+#if defined(__clang__)
+        return __builtin_shufflevector(x, x, S % 4, (S + 1) % 4, (S + 2) % 4, (S + 3) % 4,
+                                       4 + S % 4, 4 + (S + 1) % 4, 4 + (S + 2) % 4, 4 + (S + 3) % 4);
+#else
+        return __builtin_shuffle(x, Vec256{S % 4, (S + 1) % 4, (S + 2) % 4, (S + 3) % 4,
+                                           4 + S % 4, 4 + (S + 1) % 4, 4 + (S + 2) % 4, 4 + (S + 3) % 4});
+#endif
+    }
+
+    static BS_INLINE Vec256 load(const uint8_t *in, std::size_t b)
+    {
+        Vec256 v;
+        std::memcpy(&v, in + 16 * b, 16);
+        std::memcpy(reinterpret_cast<uint8_t *>(&v) + 16, in + 16 * (b + 8), 16);
+        return v;
+    }
+
+    static BS_INLINE void store(uint8_t *out, std::size_t b, const Vec256 &v)
+    {
+        std::memcpy(out + 16 * b, &v, 16);
+        std::memcpy(out + 16 * (b + 8), reinterpret_cast<const uint8_t *>(&v) + 16, 16);
+    }
+
+    // cùng round key cho cả 2 nhóm 8 block
+    static BS_INLINE Vec256 loadKey(const uint8_t *k)
+    {
+        Vec256 v;
+        std::memcpy(&v, k, 16);
+        std::memcpy(reinterpret_cast<uint8_t *>(&v) + 16, k, 16);
+        return v;
+    }
+};
+
+// ===== S-box: mạch Boyar–Peralta (113 cổng XOR/AND/XNOR) =====
+// q[j] = bit j. Dùng cho cả vector lẫn uint32_t (key schedule).
+
+template <class T>
+static BS_INLINE void bsSbox(T q[8])
+{
+    T x0 = q[7], x1 = q[6], x2 = q[5], x3 = q[4];
+    T x4 = q[3], x5 = q[2], x6 = q[1], x7 = q[0];
+
+    // lớp tuyến tính đầu
+    T y14 = x3 ^ x5;
+    T y13 = x0 ^ x6;
+    T y9 = x0 ^ x3;
+    T y8 = x0 ^ x5;
+    T t0 = x1 ^ x2;
+    T y1 = t0 ^ x7;
+    T y4 = y1 ^ x3;
+    T y12 = y13 ^ y14;
+    T y2 = y1 ^ x0;
+    T y5 = y1 ^ x6;
+    T y3 = y5 ^ y8;
+    T t1 = x4 ^ y12;
+    T y15 = t1 ^ x5;
+    T y20 = t1 ^ x1;
+    T y6 = y15 ^ x7;
+    T y10 = y15 ^ t0;
+    T y11 = y20 ^ y9;
+    T y7 = x7 ^ y11;
+    T y17 = y10 ^ y11;
+    T y19 = y10 ^ y8;
+    T y16 = t0 ^ y11;
+    T y21 = y13 ^ y16;
+    T y18 = x0 ^ y16;
+
+    // phần phi tuyến (nghịch đảo GF(2^4)^2)
+    T t2 = y12 & y15;
+    T t3 = y3 & y6;
+    T t4 = t3 ^ t2;
+    T t5 = y4 & x7;
+    T t6 = t5 ^ t2;
+    T t7 = y13 & y16;
+    T t8 = y5 & y1;
+    T t9 = t8 ^ t7;
+    T t10 = y2 & y7;
+    T t11 = t10 ^ t7;
+    T t12 = y9 & y11;
+    T t13 = y14 & y17;
+    T t14 = t13 ^ t12;
+    T t15 = y8 & y10;
+    T t16 = t15 ^ t12;
+    T t17 = t4 ^ t14;
+    T t18 = t6 ^ t16;
+    T t19 = t9 ^ t14;
+    T t20 = t11 ^ t16;
+    T t21 = t17 ^ y20;
+    T t22 = t18 ^ y19;
+    T t23 = t19 ^ y21;
+    T t24 = t20 ^ y18;
+
+    T t25 = t21 ^ t22;
+    T t26 = t21 & t23;
+    T t27 = t24 ^ t26;
+    T t28 = t25 & t27;
+    T t29 = t28 ^ t22;
+    T t30 = t23 ^ t24;
+    T t31 = t22 ^ t26;
+    T t32 = t31 & t30;
+    T t33 = t32 ^ t24;
+    T t34 = t23 ^ t33;
+    T t35 = t27 ^ t33;
+    T t36 = t24 & t35;
+    T t37 = t36 ^ t34;
+    T t38 = t27 ^ t36;
+    T t39 = t29 & t38;
+    T t40 = t25 ^ t39;
+
+    T t41 = t40 ^ t37;
+    T t42 = t29 ^ t33;
+    T t43 = t29 ^ t40;
+    T t44 = t33 ^ t37;
+    T t45 = t42 ^ t41;
+    T z0 = t44 & y15;
+    T z1 = t37 & y6;
+    T z2 = t33 & x7;
+    T z3 = t43 & y16;
+    T z4 = t40 & y1;
+    T z5 = t29 & y7;
+    T z6 = t42 & y11;
+    T z7 = t45 & y17;
+    T z8 = t41 & y10;
+    T z9 = t44 & y12;
+    T z10 = t37 & y3;
+    T z11 = t33 & y4;
+    T z12 = t43 & y13;
+    T z13 = t40 & y5;
+    T z14 = t29 & y2;
+    T z15 = t42 & y9;
+    T z16 = t45 & y14;
+    T z17 = t41 & y8;
+
+    // lớp tuyến tính cuối (đã gộp hằng số affine 0x63)
+    T t46 = z15 ^ z16;
+    T t47 = z10 ^ z11;
+    T t48 = z5 ^ z13;
+    T t49 = z9 ^ z10;
+    T t50 = z2 ^ z12;
+    T t51 = z2 ^ z5;
+    T t52 = z7 ^ z8;
+    T t53 = z0 ^ z3;
+    T t54 = z6 ^ z7;
+    T t55 = z16 ^ z17;
+    T t56 = z12 ^ t48;
+    T t57 = t50 ^ t53;
+    T t58 = z4 ^ t46;
+    T t59 = z3 ^ t54;
+    T t60 = t46 ^ t57;
+    T t61 = z14 ^ t57;
+    T t62 = t52 ^ t58;
+    T t63 = t49 ^ t58;
+    T t64 = z4 ^ t59;
+    T t65 = t61 ^ t62;
+    T t66 = z1 ^ t63;
+    T s0 = t59 ^ t63;
+    T s6 = t56 ^ ~t62;
+    T s7 = t48 ^ ~t60;
+    T t67 = t64 ^ t65;
+    T s3 = t53 ^ t66;
+    T s4 = t51 ^ t66;
+    T s5 = t47 ^ t65;
+    T s1 = t64 ^ ~s3;
+    T s2 = t55 ^ ~t67;
+
+    q[7] = s0;
+    q[6] = s1;
+    q[5] = s2;
+    q[4] = s3;
+    q[3] = s4;
+    q[2] = s5;
+    q[1] = s6;
+    q[0] = s7;
+}
+
+// Nghịch đảo phép affine của S-box: x -> A^-1(x ^ 0x63)
+// (bit i = x[i+2] ^ x[i+5] ^ x[i+7], chỉ số mod 8)
+template <class T>
+static BS_INLINE void bsInvAffine(T q[8])
+{
+    T q0 = ~q[0], q1 = ~q[1], q2 = q[2], q3 = q[3];
+    T q4 = q[4], q5 = ~q[5], q6 = ~q[6], q7 = q[7];
+    q[0] = q2 ^ q5 ^ q7;
+    q[1] = q3 ^ q6 ^ q0;
+    q[2] = q4 ^ q7 ^ q1;
+    q[3] = q5 ^ q0 ^ q2;
+    q[4] = q6 ^ q1 ^ q3;
+    q[5] = q7 ^ q2 ^ q4;
+    q[6] = q0 ^ q3 ^ q5;
+    q[7] = q1 ^ q4 ^ q6;
+}
+
+// InvSBox(y) = A^-1(S(A^-1(y ^ 63)) ^ 63): dùng lại mạch S-box thuận
+template <class T>
+static BS_INLINE void bsInvSbox(T q[8])
+{
+    bsInvAffine(q);
+    bsSbox(q);
+    bsInvAffine(q);
+}
+
+// ===== Các bước còn lại của round =====
+
+// Hàng r dịch trái r cột: cột c lấy byte hàng r của cột (c + r)
+template <class V>
+static BS_INLINE void bsShiftRows(V q[8])
+{
+    const V row0 = V{} + 0x000000FFu, row1 = V{} + 0x0000FF00u;
+    const V row2 = V{} + 0x00FF0000u, row3 = V{} + 0xFF000000u;
+    for (int j = 0; j < 8; ++j)
+    {
+        V x = q[j];
+        q[j] = (x & row0) |
+               (Lanes<V>::template rotateColumns<1>(x) & row1) |
+               (Lanes<V>::template rotateColumns<2>(x) & row2) |
+               (Lanes<V>::template rotateColumns<3>(x) & row3);
+    }
+}
+
+template <class V>
+static BS_INLINE void bsInvShiftRows(V q[8])
+{
+    const V row0 = V{} + 0x000000FFu, row1 = V{} + 0x0000FF00u;
+    const V row2 = V{} + 0x00FF0000u, row3 = V{} + 0xFF000000u;
+    for (int j = 0; j < 8; ++j)
+    {
+        V x = q[j];
+        q[j] = (x & row0) |
+               (Lanes<V>::template rotateColumns<3>(x) & row1) |
+               (Lanes<V>::template rotateColumns<2>(x) & row2) |
+               (Lanes<V>::template rotateColumns<1>(x) & row3);
+    }
+}
+
+// Xoay trong cột: byte hàng r lấy hàng (r + 1) (rot8) hoặc (r + 2) (rot16)
+template <class V>
+static BS_INLINE V bsRot8(const V &x)
+{
+    return (x >> 8) | (x << 24);
+}
+
+template <class V>
+static BS_INLINE V bsRot16(const V &x)
+{
+    return (x >> 16) | (x << 16);
+}
+
+// out[r] = {02}(a[r] ^ a[r+1]) ^ a[r+1] ^ a[r+2] ^ a[r+3]
+template <class V>
+static BS_INLINE void bsMixColumns(V q[8])
+{
+    V q0 = q[0], q1 = q[1], q2 = q[2], q3 = q[3];
+    V q4 = q[4], q5 = q[5], q6 = q[6], q7 = q[7];
+    V r0 = bsRot8(q0), r1 = bsRot8(q1), r2 = bsRot8(q2), r3 = bsRot8(q3);
+    V r4 = bsRot8(q4), r5 = bsRot8(q5), r6 = bsRot8(q6), r7 = bsRot8(q7);
+
+    q[0] = q7 ^ r7 ^ r0 ^ bsRot16(q0 ^ r0);
+    q[1] = q0 ^ r0 ^ q7 ^ r7 ^ r1 ^ bsRot16(q1 ^ r1);
+    q[2] = q1 ^ r1 ^ r2 ^ bsRot16(q2 ^ r2);
+    q[3] = q2 ^ r2 ^ q7 ^ r7 ^ r3 ^ bsRot16(q3 ^ r3);
+    q[4] = q3 ^ r3 ^ q7 ^ r7 ^ r4 ^ bsRot16(q4 ^ r4);
+    q[5] = q4 ^ r4 ^ r5 ^ bsRot16(q5 ^ r5);
+    q[6] = q5 ^ r5 ^ r6 ^ bsRot16(q6 ^ r6);
+    q[7] = q6 ^ r6 ^ r7 ^ bsRot16(q7 ^ r7);
+}
+
+// InvMixColumns = MixColumns sau bước a[r] ^= {04}(a[r] ^ a[r+2])
+// (cùng phân tích như InvMixColumns của engine byte)
+template <class V>
+static BS_INLINE void bsInvMixColumns(V q[8])
+{
+    V u[8];
+    for (int j = 0; j < 8; ++j)
+        u[j] = q[j] ^ bsRot16(q[j]);
+
+    // nhân {04} = xtime 2 lần: bit j dịch lên j+2, bit 6/7 tràn quay về qua 0x1B
+    V u6 = u[6], u7 = u[7];
+    q[0] ^= u6;
+    q[1] ^= u6 ^ u7;
+    q[2] ^= u[0] ^ u7;
+    q[3] ^= u[1] ^ u6;
+    q[4] ^= u[2] ^ u6 ^ u7;
+    q[5] ^= u[3] ^ u7;
+    q[6] ^= u[4];
+    q[7] ^= u[5];
+
+    bsMixColumns(q);
+}
+
+template <class V>
+static BS_INLINE void bsAddRoundKey(V q[8], const V k[8])
+{
+    for (int j = 0; j < 8; ++j)
+        q[j] ^= k[j];
+}
+
+// Chuyển vị ma trận bit 8x8 trong từng byte (swapmove):
+// vào q[b] = block b, ra q[j] = slice j (bit b của mỗi byte = block b). Tự nghịch đảo.
+template <class V>
+static BS_INLINE void bsOrtho(V q[8])
+{
+#define BS_SWAPMOVE(a, b, mask, n)                 \
+    do                                             \
+    {                                              \
+        V t = ((a >> n) ^ b) & (V{} + mask);       \
+        b ^= t;                                    \
+        a ^= t << n;                               \
+    } while (0)
+
+    BS_SWAPMOVE(q[0], q[1], 0x55555555u, 1);
+    BS_SWAPMOVE(q[2], q[3], 0x55555555u, 1);
+    BS_SWAPMOVE(q[4], q[5], 0x55555555u, 1);
+    BS_SWAPMOVE(q[6], q[7], 0x55555555u, 1);
+
+    BS_SWAPMOVE(q[0], q[2], 0x33333333u, 2);
+    BS_SWAPMOVE(q[1], q[3], 0x33333333u, 2);
+    BS_SWAPMOVE(q[4], q[6], 0x33333333u, 2);
+    BS_SWAPMOVE(q[5], q[7], 0x33333333u, 2);
+
+    BS_SWAPMOVE(q[0], q[4], 0x0F0F0F0Fu, 4);
+    BS_SWAPMOVE(q[1], q[5], 0x0F0F0F0Fu, 4);
+    BS_SWAPMOVE(q[2], q[6], 0x0F0F0F0Fu, 4);
+    BS_SWAPMOVE(q[3], q[7], 0x0F0F0F0Fu, 4);
+
+#undef BS_SWAPMOVE
+}
+
+template <class V>
+static BS_INLINE void bsEncrypt(V q[8], const V rk[11][8])
+{
+    bsAddRoundKey(q, rk[0]);
+    for (int round = 1; round < 10; ++round)
+    {
+        bsSbox(q);
+        bsShiftRows(q);
+        bsMixColumns(q);
+        bsAddRoundKey(q, rk[round]);
+    }
+    bsSbox(q);
+    bsShiftRows(q);
+    bsAddRoundKey(q, rk[10]);
+}
+
+template <class V>
+static BS_INLINE void bsDecrypt(V q[8], const V rk[11][8])
+{
+    bsAddRoundKey(q, rk[10]);
+    for (int round = 9; round > 0; --round)
+    {
+        bsInvShiftRows(q);
+        bsInvSbox(q);
+        bsAddRoundKey(q, rk[round]);
+        bsInvMixColumns(q);
+    }
+    bsInvShiftRows(q);
+    bsInvSbox(q);
+    bsAddRoundKey(q, rk[0]);
+}
+
+// Xử lý mọi nhóm đủ Lanes<V>::Blocks block, tiến in/out/nblocks tương ứng
+template <class V>
+static BS_INLINE void bsCryptGroups(const uint8_t *bs, const uint8_t *&in, uint8_t *&out,
+                                    std::size_t &nblocks, bool decrypt)
+{
+    constexpr std::size_t group = Lanes<V>::Blocks;
+    if (nblocks < group)
+        return;
+
+    V rk[11][8];
+    for (int round = 0; round <= 10; ++round)
+    {
+        for (int j = 0; j < 8; ++j)
+            rk[round][j] = Lanes<V>::loadKey(bs + 128 * round + 16 * j);
+    }
+
+    for (; nblocks >= group; nblocks -= group, in += 16 * group, out += 16 * group)
+    {
+        V q[8];
+        for (std::size_t b = 0; b < 8; ++b)
+            q[b] = Lanes<V>::load(in, b);
+        bsOrtho(q);
+
+        if (decrypt)
+            bsDecrypt(q, rk);
+        else
+            bsEncrypt(q, rk);
+
+        bsOrtho(q);
+        for (std::size_t b = 0; b < 8; ++b)
+            Lanes<V>::store(out, b, q[b]);
+    }
+}
+
+static void cryptGroups128(const uint8_t *bs, const uint8_t *&in, uint8_t *&out,
+                           std::size_t &nblocks, bool decrypt)
+{
+    bsCryptGroups<Vec128>(bs, in, out, nblocks, decrypt);
+}
+
+#ifdef BITSLICE_AVX2
+BITSLICE_AVX2_TARGET
+static void cryptGroups256(const uint8_t *bs, const uint8_t *&in, uint8_t *&out,
+                           std::size_t &nblocks, bool decrypt)
+{
+    bsCryptGroups<Vec256>(bs, in, out, nblocks, decrypt);
+}
+#endif
+
+// Xoá buffer tạm chứa plaintext / ciphertext / round key: ghi qua con trỏ volatile để
+// compiler không bỏ được lần ghi cuối trước khi buffer ra khỏi scope
+static void wipe(void *p, std::size_t len)
+{
+    volatile uint8_t *v = static_cast<volatile uint8_t *>(p);
+    while (len--)
+        *v++ = 0;
+}
+
+static void cryptBlocks(const uint8_t *bs, const uint8_t *in, uint8_t *out,
+                        std::size_t nblocks, bool decrypt)
+{
+#ifdef BITSLICE_AVX2
+    if (nblocks >= Lanes<Vec256>::Blocks && cpuFeatures().avx2)
+        cryptGroups256(bs, in, out, nblocks, decrypt);
+#endif
+    cryptGroups128(bs, in, out, nblocks, decrypt);
+
+    // phần dư: đệm cho đủ 1 nhóm 8 block
+    if (nblocks > 0)
+    {
+        uint8_t buf[Lanes<Vec128>::Blocks * 16] = {};
+        std::memcpy(buf, in, nblocks * 16);
+        const uint8_t *p = buf;
+        uint8_t *q = buf;
+        std::size_t n = Lanes<Vec128>::Blocks;
+        cryptGroups128(bs, p, q, n, decrypt);
+        std::memcpy(out, buf, nblocks * 16);
+        wipe(buf, sizeof(buf));
+    }
+}
+
+bool bitsliceAvailable()
+{
+    return true;
+}
+
+static const uint8_t Rcon[11] = {
+    0x00, 0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80, 0x1B, 0x36};
+
+// SubWord không tra bảng: 4 byte -> 8 slice uint32_t, qua mạch S-box
+static void subWordConstantTime(uint8_t w[4])
+{
+    uint32_t q[8] = {};
+    for (int j = 0; j < 8; ++j)
+    {
+        for (int i = 0; i < 4; ++i)
+            q[j] |= static_cast<uint32_t>((w[i] >> j) & 1) << i;
+    }
+    bsSbox(q);
+    for (int i = 0; i < 4; ++i)
+    {
+        uint8_t v = 0;
+        for (int j = 0; j < 8; ++j)
+            v |= static_cast<uint8_t>(((q[j] >> i) & 1) << j);
+        w[i] = v;
+    }
+}
+
+void bitsliceExpandKey(const uint8_t key[16], uint8_t enc[176], uint8_t bs[BitsliceKeySize])
+{
+    std::memcpy(enc, key, 16);
+    for (int i = 4; i < 44; ++i)
+    {
+        uint8_t temp[4];
+        std::memcpy(temp, enc + 4 * (i - 1), 4);
+        if (i % 4 == 0)
+        {
+            // RotWord + SubWord + Rcon
+            uint8_t t = temp[0];
+            temp[0] = temp[1];
+            temp[1] = temp[2];
+            temp[2] = temp[3];
+            temp[3] = t;
+            subWordConstantTime(temp);
+            temp[0] ^= Rcon[i / 4];
+        }
+        for (int j = 0; j < 4; ++j)
+            enc[4 * i + j] = enc[4 * (i - 4) + j] ^ temp[j];
+    }
+
+    // slice j của round r: byte k = 0xFF nếu bit j của byte k round key bằng 1
+    // (mọi block dùng chung key nên cả 8 bit của byte giống nhau)
+    for (int round = 0; round <= 10; ++round)
+    {
+        for (int j = 0; j < 8; ++j)
+        {
+            for (int k = 0; k < 16; ++k)
+            {
+                uint8_t bit = (enc[16 * round + k] >> j) & 1;
+                bs[128 * round + 16 * j + k] = static_cast<uint8_t>(0 - bit);
+            }
+        }
+    }
+}
+
+void bitsliceEncryptBlocks(const uint8_t bs[BitsliceKeySize], const uint8_t *in, uint8_t *out,
+                           std::size_t nblocks)
+{
+    cryptBlocks(bs, in, out, nblocks, false);
+}
+
+void bitsliceDecryptBlocks(const uint8_t bs[BitsliceKeySize], const uint8_t *in, uint8_t *out,
+                           std::size_t nblocks)
+{
+    cryptBlocks(bs, in, out, nblocks, true);
+}
+
+void bitsliceEncryptBlocksMulti(const uint8_t *const enc[], const uint8_t *const in[],
+                                uint8_t *const out[], std::size_t n)
+{
+    if (n == 0)
+        return;
+    if (n > Lanes<Vec128>::Blocks)
+        throw std::runtime_error("bitsliceEncryptBlocksMulti: too many lanes");
+
+    // round key lane b đặt vào vị trí block b rồi ortho như dữ liệu
+    // (lane trống dùng lại key của lane 0)
+    uint8_t keys[Lanes<Vec128>::Blocks * 16];
+    uint8_t data[Lanes<Vec128>::Blocks * 16] = {};
+    Vec128 rk[11][8];
+    for (int round = 0; round <= 10; ++round)
+    {
+        for (std::size_t b = 0; b < Lanes<Vec128>::Blocks; ++b)
+            std::memcpy(keys + 16 * b, enc[b < n ? b : 0] + 16 * round, 16);
+        for (std::size_t b = 0; b < 8; ++b)
+            rk[round][b] = Lanes<Vec128>::load(keys, b);
+        bsOrtho(rk[round]);
+    }
+
+    for (std::size_t b = 0; b < n; ++b)
+        std::memcpy(data + 16 * b, in[b], 16);
+
+    Vec128 q[8];
+    for (std::size_t b = 0; b < 8; ++b)
+        q[b] = Lanes<Vec128>::load(data, b);
+    bsOrtho(q);
+    bsEncrypt(q, rk);
+    bsOrtho(q);
+    for (std::size_t b = 0; b < 8; ++b)
+        Lanes<Vec128>::store(data, b, q[b]);
+
+    for (std::size_t b = 0; b < n; ++b)
+        std::memcpy(out[b], data + 16 * b, 16);
+    wipe(keys, sizeof(keys));
+    wipe(data, sizeof(data));
+}
+
+#else // BITSLICE_COMPILED
+
+// Compiler không có vector extension: backend bitslice không dùng được
+
+bool bitsliceAvailable()
+{
+    return false;
+}
+
+void bitsliceExpandKey(const uint8_t[16], uint8_t[176], uint8_t[BitsliceKeySize])
+{
+    throw std::runtime_error("bitslice backend not compiled in");
+}
+
+void bitsliceEncryptBlocks(const uint8_t[BitsliceKeySize], const uint8_t *, uint8_t *, std::size_t)
+{
+    throw std::runtime_error("bitslice backend not compiled in");
+}
+
+void bitsliceDecryptBlocks(const uint8_t[BitsliceKeySize], const uint8_t *, uint8_t *, std::size_t)
+{
+    throw std::runtime_error("bitslice backend not compiled in");
+}
+
+void bitsliceEncryptBlocksMulti(const uint8_t *const[], const uint8_t *const[],
+                                uint8_t *const[], std::size_t)
+{
+    throw std::runtime_error("bitslice backend not compiled in");
+}
+
+#endif // BITSLICE_COMPILED
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Backend bitslice (dùng nội bộ bởi AES128, xem aes.cpp)
+// Kiểu Käsper–Schwabe: 8 block xử lý cùng lúc, mỗi thanh ghi 128-bit giữ
+// 1 bit của mọi byte trong 8 block. S-box tính bằng mạch logic (Boyar–Peralta)
+// nên không có truy cập bảng phụ thuộc dữ liệu -> constant-time.
+// Có AVX2 thì chạy 16 block/lượt (2 nhóm 8 block trong 1 thanh ghi 256-bit).
+
+// Kích thước round key đã bitslice: 11 round * 8 slice * 16 byte
+constexpr std::size_t BitsliceKeySize = 11 * 8 * 16;
+
+// true nếu binary có engine bitslice (GCC/Clang vector extensions)
+bool bitsliceAvailable();
+
+// Key schedule constant-time (SubWord cũng qua mạch S-box).
+// enc: layout 176 byte giống AES128::roundKeys; bs: round key dạng bitslice.
+void bitsliceExpandKey(const uint8_t key[16], uint8_t enc[176], uint8_t bs[BitsliceKeySize]);
+
+// nblocks block độc lập (in/out được trùng nhau).
+// Lô lẻ (< 8 block) được đệm cho đủ 8 block nên thời gian không phụ thuộc dữ liệu.
+void bitsliceEncryptBlocks(const uint8_t bs[BitsliceKeySize], const uint8_t *in, uint8_t *out,
+                           std::size_t nblocks);
+
+// Giải mã theo inverse cipher chuẩn, dùng chung round key với mã hoá
+void bitsliceDecryptBlocks(const uint8_t bs[BitsliceKeySize], const uint8_t *in, uint8_t *out,
+                           std::size_t nblocks);
+
+// Multi-buffer: lane i dùng round key enc[i] (layout 176 byte), n <= 8.
+// Round key của các lane được bitslice chung 1 lượt như dữ liệu.
+void bitsliceEncryptBlocksMulti(const uint8_t *const enc[], const uint8_t *const in[],
+                                uint8_t *const out[], std::size_t n);
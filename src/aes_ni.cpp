@@ -0,0 +1,238 @@
+#include "aes_ni.h"
+#include "cpu_features.h"
+
+#include <stdexcept>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define AESNI_COMPILED 1
+#include <emmintrin.h>
+#include <wmmintrin.h>
+#endif
+
+#ifdef AESNI_COMPILED
+
+// GCC/Clang: bật AES-NI cho riêng các hàm này, phần còn lại vẫn build với -O2 thường
+#if defined(__GNUC__) || defined(__clang__)
+#define AESNI_TARGET __attribute__((target("aes,sse2")))
+#else
+#define AESNI_TARGET
+#endif
+
+bool aesniAvailable()
+{
+    return cpuFeatures().aesni && cpuFeatures().sse2;
+}
+
+AESNI_TARGET
+static inline __m128i expandStep(__m128i key, __m128i assist)
+{
+    // assist = AESKEYGENASSIST(prev) -> lấy word 3: SubWord(RotWord(w3)) ^ Rcon
+    assist = _mm_shuffle_epi32(assist, 0xff);
+    key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+    key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+    key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+    return _mm_xor_si128(key, assist);
+}
+
+// AESKEYGENASSIST cần Rcon là hằng số lúc compile
+#define AESNI_EXPAND(i, rcon) \
+    rk[i] = expandStep(rk[i - 1], _mm_aeskeygenassist_si128(rk[i - 1], rcon))
+
+AESNI_TARGET
+void aesniExpandKey(const uint8_t key[16], uint8_t enc[176], uint8_t dec[176])
+{
+    __m128i rk[11];
+    rk[0] = _mm_loadu_si128(reinterpret_cast<const __m128i *>(key));
+    AESNI_EXPAND(1, 0x01);
+    AESNI_EXPAND(2, 0x02);
+    AESNI_EXPAND(3, 0x04);
+    AESNI_EXPAND(4, 0x08);
+    AESNI_EXPAND(5, 0x10);
+    AESNI_EXPAND(6, 0x20);
+    AESNI_EXPAND(7, 0x40);
+    AESNI_EXPAND(8, 0x80);
+    AESNI_EXPAND(9, 0x1B);
+    AESNI_EXPAND(10, 0x36);
+
+    for (int r = 0; r <= 10; ++r)
+    {
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(enc + 16 * r), rk[r]);
+
+        // round 1..9 của decrypt schedule = InvMixColumns(round key)
+        __m128i d = (r == 0 || r == 10) ? rk[r] : _mm_aesimc_si128(rk[r]);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dec + 16 * r), d);
+    }
+}
+
+#undef AESNI_EXPAND
+
+AESNI_TARGET
+void aesniEncryptBlock(const uint8_t enc[176], const uint8_t in[16], uint8_t out[16])
+{
+    const __m128i *rk = reinterpret_cast<const __m128i *>(enc);
+    __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in));
+
+    s = _mm_xor_si128(s, _mm_loadu_si128(rk + 0));
+    for (int r = 1; r <= 9; ++r)
+    {
+        s = _mm_aesenc_si128(s, _mm_loadu_si128(rk + r));
+    }
+    s = _mm_aesenclast_si128(s, _mm_loadu_si128(rk + 10));
+
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(out), s);
+}
+
+AESNI_TARGET
+void aesniDecryptBlock(const uint8_t dec[176], const uint8_t in[16], uint8_t out[16])
+{
+    const __m128i *dk = reinterpret_cast<const __m128i *>(dec);
+    __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in));
+
+    s = _mm_xor_si128(s, _mm_loadu_si128(dk + 10));
+    for (int r = 9; r >= 1; --r)
+    {
+        s = _mm_aesdec_si128(s, _mm_loadu_si128(dk + r));
+    }
+    s = _mm_aesdeclast_si128(s, _mm_loadu_si128(dk + 0));
+
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(out), s);
+}
+
+// 8 block xen kẽ: AESENC có latency ~4 chu kỳ nhưng throughput 1/chu kỳ,
+// nên 8 chuỗi độc lập giữ cho đơn vị AES luôn bận.
+AESNI_TARGET
+void aesniEncryptBlocks(const uint8_t enc[176], const uint8_t *in, uint8_t *out, std::size_t nblocks)
+{
+    const __m128i *src = reinterpret_cast<const __m128i *>(in);
+    __m128i *dst = reinterpret_cast<__m128i *>(out);
+
+    __m128i rk[11];
+    for (int r = 0; r <= 10; ++r)
+        rk[r] = _mm_loadu_si128(reinterpret_cast<const __m128i *>(enc) + r);
+
+    for (; nblocks >= 8; nblocks -= 8, src += 8, dst += 8)
+    {
+        __m128i s[8];
+        for (int b = 0; b < 8; ++b)
+            s[b] = _mm_xor_si128(_mm_loadu_si128(src + b), rk[0]);
+        for (int r = 1; r <= 9; ++r)
+        {
+            for (int b = 0; b < 8; ++b)
+                s[b] = _mm_aesenc_si128(s[b], rk[r]);
+        }
+        for (int b = 0; b < 8; ++b)
+            _mm_storeu_si128(dst + b, _mm_aesenclast_si128(s[b], rk[10]));
+    }
+
+    for (; nblocks > 0; --nblocks, ++src, ++dst)
+    {
+        __m128i s = _mm_xor_si128(_mm_loadu_si128(src), rk[0]);
+        for (int r = 1; r <= 9; ++r)
+            s = _mm_aesenc_si128(s, rk[r]);
+        _mm_storeu_si128(dst, _mm_aesenclast_si128(s, rk[10]));
+    }
+}
+
+AESNI_TARGET
+void aesniDecryptBlocks(const uint8_t dec[176], const uint8_t *in, uint8_t *out, std::size_t nblocks)
+{
+    const __m128i *src = reinterpret_cast<const __m128i *>(in);
+    __m128i *dst = reinterpret_cast<__m128i *>(out);
+
+    __m128i dk[11];
+    for (int r = 0; r <= 10; ++r)
+        dk[r] = _mm_loadu_si128(reinterpret_cast<const __m128i *>(dec) + r);
+
+    for (; nblocks >= 8; nblocks -= 8, src += 8, dst += 8)
+    {
+        __m128i s[8];
+        for (int b = 0; b < 8; ++b)
+            s[b] = _mm_xor_si128(_mm_loadu_si128(src + b), dk[10]);
+        for (int r = 9; r >= 1; --r)
+        {
+            for (int b = 0; b < 8; ++b)
+                s[b] = _mm_aesdec_si128(s[b], dk[r]);
+        }
+        for (int b = 0; b < 8; ++b)
+            _mm_storeu_si128(dst + b, _mm_aesdeclast_si128(s[b], dk[0]));
+    }
+
+    for (; nblocks > 0; --nblocks, ++src, ++dst)
+    {
+        __m128i s = _mm_xor_si128(_mm_loadu_si128(src), dk[10]);
+        for (int r = 9; r >= 1; --r)
+            s = _mm_aesdec_si128(s, dk[r]);
+        _mm_storeu_si128(dst, _mm_aesdeclast_si128(s, dk[0]));
+    }
+}
+
+// Multi-buffer: mỗi lane là 1 stream khác key, round key đọc từ L1 mỗi round
+AESNI_TARGET
+void aesniEncryptBlocksMulti(const uint8_t *const enc[], const uint8_t *const in[],
+                             uint8_t *const out[], std::size_t n)
+{
+    __m128i s[8];
+    const __m128i *rk[8];
+
+    if (n > 8)
+        n = 8;
+
+    for (std::size_t b = 0; b < n; ++b)
+    {
+        rk[b] = reinterpret_cast<const __m128i *>(enc[b]);
+        s[b] = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(in[b])),
+                             _mm_loadu_si128(rk[b]));
+    }
+    for (int r = 1; r <= 9; ++r)
+    {
+        for (std::size_t b = 0; b < n; ++b)
+            s[b] = _mm_aesenc_si128(s[b], _mm_loadu_si128(rk[b] + r));
+    }
+    for (std::size_t b = 0; b < n; ++b)
+    {
+        s[b] = _mm_aesenclast_si128(s[b], _mm_loadu_si128(rk[b] + 10));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out[b]), s[b]);
+    }
+}
+
+#else
+
+// Kiến trúc không phải x86: không có AES-NI, AES128 sẽ không chọn backend này
+
+bool aesniAvailable()
+{
+    return false;
+}
+
+void aesniExpandKey(const uint8_t *, uint8_t *, uint8_t *)
+{
+    throw std::runtime_error("AES-NI backend not compiled for this architecture");
+}
+
+void aesniEncryptBlock(const uint8_t *, const uint8_t *, uint8_t *)
+{
+    throw std::runtime_error("AES-NI backend not compiled for this architecture");
+}
+
+void aesniDecryptBlock(const uint8_t *, const uint8_t *, uint8_t *)
+{
+    throw std::runtime_error("AES-NI backend not compiled for this architecture");
+}
+
+void aesniEncryptBlocks(const uint8_t *, const uint8_t *, uint8_t *, std::size_t)
+{
+    throw std::runtime_error("AES-NI backend not compiled for this architecture");
+}
+
+void aesniDecryptBlocks(const uint8_t *, const uint8_t *, uint8_t *, std::size_t)
+{
+    throw std::runtime_error("AES-NI backend not compiled for this architecture");
+}
+
+void aesniEncryptBlocksMulti(const uint8_t *const *, const uint8_t *const *,
+                             uint8_t *const *, std::size_t)
+{
+    throw std::runtime_error("AES-NI backend not compiled for this architecture");
+}
+
+#endif
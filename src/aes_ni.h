@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Backend AES-NI (dùng nội bộ bởi AES128, xem aes.cpp)
+// Layout round key giống AES128: 11 * 16 byte, round 0..10.
+// dec: equivalent inverse cipher, dec[r] = AESIMC(enc[r]) với r = 1..9.
+
+// true nếu binary có code AES-NI và CPU hỗ trợ
+bool aesniAvailable();
+
+void aesniExpandKey(const uint8_t key[16], uint8_t enc[176], uint8_t dec[176]);
+
+void aesniEncryptBlock(const uint8_t enc[176], const uint8_t in[16], uint8_t out[16]);
+
+void aesniDecryptBlock(const uint8_t dec[176], const uint8_t in[16], uint8_t out[16]);
+
+// nblocks block độc lập, 8 block xen kẽ mỗi vòng (in/out được trùng nhau)
+void aesniEncryptBlocks(const uint8_t enc[176], const uint8_t *in, uint8_t *out, std::size_t nblocks);
+
+void aesniDecryptBlocks(const uint8_t dec[176], const uint8_t *in, uint8_t *out, std::size_t nblocks);
+
+// Multi-buffer: lane i dùng round key enc[i] (layout 176 byte), n <= 8
+void aesniEncryptBlocksMulti(const uint8_t *const enc[], const uint8_t *const in[],
+                             uint8_t *const out[], std::size_t n);
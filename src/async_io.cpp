@@ -0,0 +1,805 @@
+#include "async_io.h"
+#include "file_io.h"
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <unistd.h>
+#else
+#include <io.h>
+#endif
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#include <sys/syscall.h>
+#if defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter)
+#define ASYNC_IO_URING 1
+#include <linux/io_uring.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/uio.h>
+#endif
+#endif
+#endif
+
+#ifndef O_BINARY
+#define O_BINARY 0
+#endif
+
+using Clock = std::chrono::steady_clock;
+
+// ===== tiện ích chung =====
+
+static int openInput(const std::string &path)
+{
+    int fd = ::open(path.c_str(), O_RDONLY | O_BINARY);
+    if (fd < 0)
+    {
+        throw std::runtime_error("Cannot open input file: " + path);
+    }
+    return fd;
+}
+
+static int openOutput(const std::string &path)
+{
+    int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_BINARY, 0644);
+    if (fd < 0)
+    {
+        throw std::runtime_error("Cannot open output file: " + path);
+    }
+    return fd;
+}
+
+IoBackend parseIoBackend(const std::string &name)
+{
+    if (name == "auto")
+        return IoBackend::Auto;
+    if (name == "blocking")
+        return IoBackend::Blocking;
+    if (name == "uring" || name == "io_uring")
+    {
+        if (!ioUringAvailable())
+        {
+            throw std::runtime_error("io_uring is not supported on this system");
+        }
+        return IoBackend::IoUring;
+    }
+    throw std::runtime_error("Unknown I/O backend: " + name + " (auto|blocking|uring)");
+}
+
+const char *ioBackendName(IoBackend backend)
+{
+    switch (backend)
+    {
+    case IoBackend::Auto:
+        return "auto";
+    case IoBackend::Blocking:
+        return "blocking";
+    case IoBackend::IoUring:
+        return "uring";
+    }
+    return "?";
+}
+
+// ===== Blocking: 1 worker = 1 file =====
+
+static void cipherFileBlocking(const BulkFileJob &job, PipelineCipher cipher, std::size_t chunkSize,
+                               std::atomic<uint64_t> &bytesIn, std::atomic<uint64_t> &bytesOut)
+{
+    int in = openInput(job.inPath);
+    int out = -1;
+    try
+    {
+        out = openOutput(job.outPath);
+        std::vector<uint8_t> inBuf(chunkSize);
+        std::vector<uint8_t> outBuf(chunkSize + 32);
+        const std::string readError = "Error reading input file: " + job.inPath;
+        const std::string writeError = "Error writing output file: " + job.outPath;
+        for (;;)
+        {
+            std::size_t n = readSomeFd(in, inBuf.data(), inBuf.size(), readError);
+            if (n == 0)
+                break;
+            bytesIn += n;
+            std::size_t m = cipher.update(inBuf.data(), n, outBuf.data());
+            writeAllFd(out, outBuf.data(), m, writeError);
+            bytesOut += m;
+        }
+        std::size_t m = cipher.final(outBuf.data());
+        writeAllFd(out, outBuf.data(), m, writeError);
+        bytesOut += m;
+
+        ::close(in);
+        in = -1;
+        int rc = ::close(out);
+        out = -1;
+        if (rc != 0)
+        {
+            throw std::runtime_error(writeError);
+        }
+    }
+    catch (...)
+    {
+        if (in >= 0)
+            ::close(in);
+        if (out >= 0)
+            ::close(out);
+        // không để lại file output dở dang
+        std::remove(job.outPath.c_str());
+        throw;
+    }
+}
+
+static BulkIoResult runBlocking(const std::vector<BulkFileJob> &jobs, const CipherFactory &factory,
+                                const BulkIoOptions &opt)
+{
+    std::atomic<uint64_t> bytesIn{0}, bytesOut{0};
+    std::atomic<bool> failed{false};
+
+    auto start = Clock::now();
+    {
+        ThreadPool pool(opt.threads);
+        for (const auto &job : jobs)
+        {
+            pool.submit([&, job]()
+                        {
+                            if (failed.load())
+                                return; // đã có file lỗi: bỏ các file còn lại
+                            try
+                            {
+                                cipherFileBlocking(job, factory(), opt.chunkSize, bytesIn, bytesOut);
+                            }
+                            catch (...)
+                            {
+                                failed = true;
+                                throw;
+                            } });
+        }
+        pool.wait();
+    }
+
+    BulkIoResult res;
+    res.backend = IoBackend::Blocking;
+    res.files = jobs.size();
+    res.bytesIn = bytesIn;
+    res.bytesOut = bytesOut;
+    res.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    return res;
+}
+
+// ===== io_uring =====
+
+#ifdef ASYNC_IO_URING
+
+namespace
+{
+
+// io_uring tối thiểu gọi thẳng syscall (không cần liburing)
+class Uring
+{
+public:
+    explicit Uring(unsigned entries)
+    {
+        io_uring_params p;
+        std::memset(&p, 0, sizeof(p));
+        fd = static_cast<int>(::syscall(__NR_io_uring_setup, entries, &p));
+        if (fd < 0)
+        {
+            throw std::runtime_error(std::string("io_uring_setup failed: ") + std::strerror(errno));
+        }
+
+        sqSize = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+        cqSize = p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe);
+        bool single = (p.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if (single)
+            sqSize = cqSize = std::max(sqSize, cqSize);
+
+        sqPtr = ::mmap(nullptr, sqSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                       fd, IORING_OFF_SQ_RING);
+        cqPtr = single ? sqPtr
+                       : ::mmap(nullptr, cqSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                                fd, IORING_OFF_CQ_RING);
+        sqesSize = p.sq_entries * sizeof(io_uring_sqe);
+        void *s = ::mmap(nullptr, sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                         fd, IORING_OFF_SQES);
+        if (sqPtr == MAP_FAILED || cqPtr == MAP_FAILED || s == MAP_FAILED)
+        {
+            if (s != MAP_FAILED)
+                ::munmap(s, sqesSize);
+            unmapRings();
+            ::close(fd);
+            throw std::runtime_error("io_uring mmap failed");
+        }
+        sqes = static_cast<io_uring_sqe *>(s);
+
+        auto *sq = static_cast<uint8_t *>(sqPtr);
+        sqHead = reinterpret_cast<unsigned *>(sq + p.sq_off.head);
+        sqTail = reinterpret_cast<unsigned *>(sq + p.sq_off.tail);
+        sqMask = *reinterpret_cast<unsigned *>(sq + p.sq_off.ring_mask);
+        sqArray = reinterpret_cast<unsigned *>(sq + p.sq_off.array);
+        sqEntries = p.sq_entries;
+        localTail = *sqTail;
+
+        auto *cq = static_cast<uint8_t *>(cqPtr);
+        cqHead = reinterpret_cast<unsigned *>(cq + p.cq_off.head);
+        cqTail = reinterpret_cast<unsigned *>(cq + p.cq_off.tail);
+        cqMask = *reinterpret_cast<unsigned *>(cq + p.cq_off.ring_mask);
+        cqes = reinterpret_cast<io_uring_cqe *>(cq + p.cq_off.cqes);
+    }
+
+    ~Uring()
+    {
+        ::munmap(sqes, sqesSize);
+        unmapRings();
+        ::close(fd);
+    }
+
+    Uring(const Uring &) = delete;
+    Uring &operator=(const Uring &) = delete;
+
+    // SQE trống (đã xoá 0); ném lỗi nếu SQ đầy
+    io_uring_sqe *getSqe()
+    {
+        unsigned head = __atomic_load_n(sqHead, __ATOMIC_ACQUIRE);
+        if (localTail - head >= sqEntries)
+        {
+            throw std::logic_error("io_uring submission queue full");
+        }
+        unsigned idx = localTail & sqMask;
+        io_uring_sqe *sqe = &sqes[idx];
+        std::memset(sqe, 0, sizeof(*sqe));
+        sqArray[idx] = idx;
+        ++localTail;
+        ++toSubmit;
+        return sqe;
+    }
+
+    // Gửi các SQE đã chuẩn bị, chờ tới khi có ít nhất waitNr CQE
+    void submitAndWait(unsigned waitNr)
+    {
+        __atomic_store_n(sqTail, localTail, __ATOMIC_RELEASE);
+        for (;;)
+        {
+            long ret = ::syscall(__NR_io_uring_enter, fd, toSubmit, waitNr,
+                                 waitNr > 0 ? IORING_ENTER_GETEVENTS : 0, nullptr, 0);
+            if (ret >= 0)
+            {
+                toSubmit -= static_cast<unsigned>(ret);
+                return;
+            }
+            if (errno != EINTR)
+            {
+                throw std::runtime_error(std::string("io_uring_enter failed: ") + std::strerror(errno));
+            }
+        }
+    }
+
+    // Lấy 1 CQE nếu có
+    bool popCqe(io_uring_cqe &out)
+    {
+        unsigned head = *cqHead;
+        if (head == __atomic_load_n(cqTail, __ATOMIC_ACQUIRE))
+            return false;
+        out = cqes[head & cqMask];
+        __atomic_store_n(cqHead, head + 1, __ATOMIC_RELEASE);
+        return true;
+    }
+
+private:
+    int fd = -1;
+    void *sqPtr = MAP_FAILED;
+    void *cqPtr = MAP_FAILED;
+    std::size_t sqSize = 0, cqSize = 0, sqesSize = 0;
+    io_uring_sqe *sqes = nullptr;
+    unsigned *sqHead = nullptr, *sqTail = nullptr, *sqArray = nullptr;
+    unsigned sqMask = 0, sqEntries = 0;
+    unsigned *cqHead = nullptr, *cqTail = nullptr;
+    unsigned cqMask = 0;
+    io_uring_cqe *cqes = nullptr;
+    unsigned localTail = 0;
+    unsigned toSubmit = 0;
+
+    void unmapRings()
+    {
+        if (cqPtr != MAP_FAILED && cqPtr != sqPtr)
+            ::munmap(cqPtr, cqSize);
+        if (sqPtr != MAP_FAILED)
+            ::munmap(sqPtr, sqSize);
+    }
+};
+
+struct FileState;
+
+// 1 chunk: đang đọc -> chờ tới lượt mã hoá -> đang mã hoá -> đang ghi -> trả về pool
+struct Chunk
+{
+    PipeBuffer *buf = nullptr;
+    FileState *file = nullptr;
+    uint64_t seq = 0;
+    uint64_t offset = 0;  // vị trí trong file input (đọc) / output (ghi)
+    std::size_t done = 0; // byte đã đọc / ghi (read/write ngắn thì gửi tiếp phần còn lại)
+    bool writing = false;
+    iovec iov;
+    std::exception_ptr error; // lỗi của worker mã hoá
+};
+
+struct FileState
+{
+    const BulkFileJob *job = nullptr;
+    PipelineCipher cipher;
+    int inFd = -1;
+    int outFd = -1;
+    uint64_t size = 0;
+    uint64_t readOffset = 0;
+    uint64_t nextReadSeq = 0;
+    uint64_t nextCipherSeq = 0;
+    uint64_t outOffset = 0;
+    bool readsQueued = false; // đã gửi lệnh đọc chunk cuối
+    bool cipherBusy = false;  // chunk của file này đang ở worker (chain phải tuần tự)
+    bool cipherDone = false;  // final() đã chạy
+    unsigned writesInFlight = 0;
+    std::map<uint64_t, Chunk *> ready; // đọc xong, chờ tới lượt mã hoá
+
+    ~FileState()
+    {
+        if (inFd >= 0)
+            ::close(inFd);
+        if (outFd >= 0)
+            ::close(outFd);
+    }
+};
+
+const uint64_t WakeupTag = 0; // user_data của lệnh đọc eventfd
+
+class UringBulk
+{
+public:
+    UringBulk(const std::vector<BulkFileJob> &jobs, const CipherFactory &factory,
+              const BulkIoOptions &opt)
+        : jobs(jobs), factory(factory), opt(opt),
+          buffers(opt.queueDepth, opt.chunkSize, 32),
+          ring(opt.queueDepth + 1),
+          pool(opt.threads)
+    {
+        chunks.resize(buffers.count());
+        for (std::size_t i = 0; i < chunks.size(); ++i)
+        {
+            chunks[i].buf = buffers.at(i);
+            freeChunks.push_back(&chunks[i]);
+        }
+        wakeFd = ::eventfd(0, EFD_CLOEXEC);
+        if (wakeFd < 0)
+        {
+            throw std::runtime_error("eventfd failed");
+        }
+    }
+
+    ~UringBulk()
+    {
+        // run() ném lỗi giữa chừng: chờ worker xong trước khi huỷ chunk / eventfd
+        try
+        {
+            pool.wait();
+        }
+        catch (...)
+        {
+        }
+        ::close(wakeFd);
+    }
+
+    BulkIoResult run()
+    {
+        auto start = Clock::now();
+        armWakeup();
+
+        for (;;)
+        {
+            retireFiles();
+            if (!error)
+            {
+                openFiles();
+                issueReads();
+                dispatchCiphers();
+            }
+
+            bool idle = opsInFlight == 0 && cipherTasks == 0;
+            if (error && idle)
+                break;
+            if (!error && active.empty() && nextJob == jobs.size())
+                break;
+            if (!error && idle)
+            {
+                // mọi chunk đều phải đang đọc, mã hoá hoặc ghi
+                throw std::logic_error("io_uring bulk: pipeline stalled");
+            }
+
+            ring.submitAndWait(1);
+            io_uring_cqe cqe;
+            while (ring.popCqe(cqe))
+                handleCompletion(cqe);
+        }
+
+        if (error)
+        {
+            // file chưa xong: đóng và xoá output dở dang
+            for (auto &f : active)
+            {
+                ::close(f->outFd);
+                f->outFd = -1;
+                std::remove(f->job->outPath.c_str());
+            }
+            active.clear();
+            std::rethrow_exception(error);
+        }
+
+        BulkIoResult res;
+        res.backend = IoBackend::IoUring;
+        res.files = filesDone;
+        res.bytesIn = bytesIn;
+        res.bytesOut = bytesOut;
+        res.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        return res;
+    }
+
+private:
+    const std::vector<BulkFileJob> &jobs;
+    const CipherFactory &factory;
+    BulkIoOptions opt;
+
+    BufferPool buffers;
+    std::vector<Chunk> chunks;
+    std::vector<Chunk *> freeChunks;
+    Uring ring;
+    ThreadPool pool;
+
+    int wakeFd = -1;
+    uint64_t wakeValue = 0;
+    iovec wakeIov;
+    std::mutex finishedMutex;
+    std::vector<Chunk *> finished; // worker -> vòng lặp chính
+
+    std::vector<std::unique_ptr<FileState>> active;
+    std::size_t nextJob = 0;
+    std::size_t filesDone = 0;
+    unsigned opsInFlight = 0; // read/write chưa có CQE (không tính eventfd)
+    unsigned cipherTasks = 0;
+    uint64_t bytesIn = 0;
+    uint64_t bytesOut = 0;
+    std::exception_ptr error;
+
+    void fail(std::exception_ptr e)
+    {
+        if (!error)
+            error = e;
+    }
+
+    void fail(const std::string &message)
+    {
+        fail(std::make_exception_ptr(std::runtime_error(message)));
+    }
+
+    void releaseChunk(Chunk *c)
+    {
+        c->file = nullptr;
+        c->error = nullptr;
+        freeChunks.push_back(c);
+    }
+
+    // worker báo xong qua eventfd; CQE của lệnh đọc này đánh thức vòng lặp chính
+    void armWakeup()
+    {
+        wakeIov.iov_base = &wakeValue;
+        wakeIov.iov_len = sizeof(wakeValue);
+        io_uring_sqe *sqe = ring.getSqe();
+        sqe->opcode = IORING_OP_READV;
+        sqe->fd = wakeFd;
+        sqe->addr = reinterpret_cast<uint64_t>(&wakeIov);
+        sqe->len = 1;
+        sqe->user_data = WakeupTag;
+    }
+
+    void submitIo(Chunk *c, uint8_t opcode, int fd, uint8_t *base, std::size_t total)
+    {
+        c->iov.iov_base = base + c->done;
+        c->iov.iov_len = total - c->done;
+        io_uring_sqe *sqe = ring.getSqe();
+        sqe->opcode = opcode;
+        sqe->fd = fd;
+        sqe->off = c->offset + c->done;
+        sqe->addr = reinterpret_cast<uint64_t>(&c->iov);
+        sqe->len = 1;
+        sqe->user_data = reinterpret_cast<uint64_t>(c);
+        ++opsInFlight;
+    }
+
+    void openFiles()
+    {
+        while (active.size() < opt.maxOpenFiles && nextJob < jobs.size())
+        {
+            std::unique_ptr<FileState> f(new FileState);
+            f->job = &jobs[nextJob++];
+            try
+            {
+                f->inFd = openInput(f->job->inPath);
+                struct stat st;
+                if (::fstat(f->inFd, &st) != 0 || !S_ISREG(st.st_mode))
+                {
+                    throw std::runtime_error("Not a regular file: " + f->job->inPath);
+                }
+                f->size = static_cast<uint64_t>(st.st_size);
+                f->outFd = openOutput(f->job->outPath);
+                f->cipher = factory();
+            }
+            catch (...)
+            {
+                fail(std::current_exception());
+                return;
+            }
+            active.push_back(std::move(f));
+        }
+    }
+
+    // Vòng tròn qua các file, mỗi lượt 1 chunk/file: hàng đợi thiết bị có read của nhiều file
+    void issueReads()
+    {
+        bool progress = true;
+        while (progress && !freeChunks.empty())
+        {
+            progress = false;
+            for (auto &f : active)
+            {
+                if (f->readsQueued || freeChunks.empty())
+                    continue;
+
+                Chunk *c = freeChunks.back();
+                freeChunks.pop_back();
+                uint64_t left = f->size - f->readOffset;
+                std::size_t len = static_cast<std::size_t>(std::min<uint64_t>(left, opt.chunkSize));
+                c->file = f.get();
+                c->seq = f->nextReadSeq++;
+                c->offset = f->readOffset;
+                c->done = 0;
+                c->writing = false;
+                c->buf->inLen = len;
+                c->buf->last = f->readOffset + len == f->size;
+                f->readOffset += len;
+                f->readsQueued = c->buf->last;
+
+                if (len == 0)
+                    f->ready[c->seq] = c; // file rỗng: chỉ cần final()
+                else
+                    submitIo(c, IORING_OP_READV, f->inFd, c->buf->in.data(), len);
+                progress = true;
+            }
+        }
+    }
+
+    void dispatchCiphers()
+    {
+        for (auto &f : active)
+        {
+            if (f->cipherBusy || f->ready.empty() || f->ready.begin()->first != f->nextCipherSeq)
+                continue;
+
+            Chunk *c = f->ready.begin()->second;
+            f->ready.erase(f->ready.begin());
+            f->cipherBusy = true;
+            ++cipherTasks;
+            pool.submit([this, c]()
+                        {
+                            PipeBuffer &b = *c->buf;
+                            try
+                            {
+                                b.outLen = c->file->cipher.update(b.in.data(), b.inLen, b.out.data());
+                                if (b.last)
+                                    b.outLen += c->file->cipher.final(b.out.data() + b.outLen);
+                            }
+                            catch (...)
+                            {
+                                c->error = std::current_exception();
+                            }
+                            {
+                                std::lock_guard<std::mutex> lock(finishedMutex);
+                                finished.push_back(c);
+                            }
+                            uint64_t one = 1;
+                            if (::write(wakeFd, &one, sizeof(one)) < 0)
+                            {
+                                // eventfd chỉ lỗi khi bộ đếm tràn: vòng lặp vẫn được đánh thức
+                            } });
+        }
+    }
+
+    void handleCompletion(const io_uring_cqe &cqe)
+    {
+        if (cqe.user_data == WakeupTag)
+        {
+            armWakeup();
+            std::vector<Chunk *> done;
+            {
+                std::lock_guard<std::mutex> lock(finishedMutex);
+                done.swap(finished);
+            }
+            for (Chunk *c : done)
+                cipherFinished(c);
+            return;
+        }
+
+        --opsInFlight;
+        Chunk *c = reinterpret_cast<Chunk *>(cqe.user_data);
+        FileState &f = *c->file;
+        bool reading = !c->writing;
+
+        if (cqe.res < 0 || (cqe.res == 0 && !error))
+        {
+            std::string what = reading ? "Error reading input file: " + f.job->inPath
+                                       : "Error writing output file: " + f.job->outPath;
+            if (cqe.res < 0)
+                what += std::string(" (") + std::strerror(-cqe.res) + ")";
+            else if (reading)
+                what = "Input file shrank while reading: " + f.job->inPath;
+            fail(what);
+        }
+        if (error)
+        {
+            if (!reading)
+                --f.writesInFlight;
+            releaseChunk(c);
+            return;
+        }
+
+        c->done += static_cast<std::size_t>(cqe.res);
+        if (reading)
+        {
+            if (c->done < c->buf->inLen)
+            {
+                submitIo(c, IORING_OP_READV, f.inFd, c->buf->in.data(), c->buf->inLen);
+                return;
+            }
+            bytesIn += c->buf->inLen;
+            f.ready[c->seq] = c;
+        }
+        else
+        {
+            if (c->done < c->buf->outLen)
+            {
+                submitIo(c, IORING_OP_WRITEV, f.outFd, c->buf->out.data(), c->buf->outLen);
+                return;
+            }
+            bytesOut += c->buf->outLen;
+            --f.writesInFlight;
+            releaseChunk(c);
+        }
+    }
+
+    void cipherFinished(Chunk *c)
+    {
+        --cipherTasks;
+        FileState &f = *c->file;
+        f.cipherBusy = false;
+        ++f.nextCipherSeq;
+
+        if (c->error || error)
+        {
+            fail(c->error);
+            releaseChunk(c);
+            return;
+        }
+        if (c->buf->last)
+            f.cipherDone = true;
+        if (c->buf->outLen == 0)
+        {
+            releaseChunk(c);
+            return;
+        }
+
+        // output tuần tự theo thứ tự chunk, offset biết ngay sau khi mã hoá
+        c->offset = f.outOffset;
+        c->done = 0;
+        c->writing = true;
+        f.outOffset += c->buf->outLen;
+        ++f.writesInFlight;
+        submitIo(c, IORING_OP_WRITEV, f.outFd, c->buf->out.data(), c->buf->outLen);
+    }
+
+    void retireFiles()
+    {
+        for (std::size_t i = 0; i < active.size();)
+        {
+            FileState &f = *active[i];
+            bool finishedFile = f.cipherDone && f.writesInFlight == 0 && f.ready.empty();
+            if (!finishedFile || error)
+            {
+                ++i;
+                continue;
+            }
+            ::close(f.inFd);
+            f.inFd = -1;
+            int rc = ::close(f.outFd);
+            f.outFd = -1;
+            if (rc != 0)
+            {
+                fail("Error writing output file: " + f.job->outPath);
+                std::remove(f.job->outPath.c_str());
+            }
+            else
+            {
+                ++filesDone;
+            }
+            active.erase(active.begin() + static_cast<std::ptrdiff_t>(i));
+        }
+    }
+};
+
+} // namespace
+
+bool ioUringAvailable()
+{
+    static const bool available = []()
+    {
+        try
+        {
+            Uring probe(2);
+            return true;
+        }
+        catch (const std::exception &)
+        {
+            return false; // kernel cũ, bị chặn bởi seccomp / sysctl io_uring_disabled
+        }
+    }();
+    return available;
+}
+
+#else
+
+bool ioUringAvailable()
+{
+    return false;
+}
+
+#endif // ASYNC_IO_URING
+
+BulkIoResult cipherFilesBulk(const std::vector<BulkFileJob> &jobs, const CipherFactory &factory,
+                             const BulkIoOptions &options)
+{
+    if (options.chunkSize == 0 || options.chunkSize % 16 != 0)
+    {
+        throw std::runtime_error("Bulk I/O chunk size must be a non-zero multiple of 16");
+    }
+    if (options.queueDepth == 0 || options.maxOpenFiles == 0)
+    {
+        throw std::runtime_error("Bulk I/O queue depth and open-file limit must be non-zero");
+    }
+
+    IoBackend backend = options.backend;
+    if (backend == IoBackend::Auto)
+        backend = ioUringAvailable() ? IoBackend::IoUring : IoBackend::Blocking;
+
+#ifdef ASYNC_IO_URING
+    if (backend == IoBackend::IoUring)
+    {
+        UringBulk engine(jobs, factory, options);
+        return engine.run();
+    }
+#else
+    if (backend == IoBackend::IoUring)
+    {
+        throw std::runtime_error("io_uring is not supported on this system");
+    }
+#endif
+    return runBlocking(jobs, factory, options);
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "pipeline.h"
+
+// ===== Mã hoá nhiều file với I/O bất đồng bộ =====
+// IoUring (Linux): 1 thread giữ nhiều lệnh read/write trong hàng đợi của thiết bị
+// cùng lúc (nhiều file, nhiều chunk), chunk đọc xong được đưa cho worker mã hoá.
+// Blocking (mọi nền tảng): mỗi worker đọc / mã hoá / ghi trọn 1 file bằng read()/write().
+
+enum class IoBackend
+{
+    Auto,     // IoUring nếu kernel hỗ trợ, ngược lại Blocking
+    Blocking,
+    IoUring
+};
+
+// true nếu build có io_uring và kernel cho phép io_uring_setup
+bool ioUringAvailable();
+
+// "auto" | "blocking" | "uring"; ném std::runtime_error nếu sai tên hoặc không hỗ trợ
+IoBackend parseIoBackend(const std::string &name);
+const char *ioBackendName(IoBackend backend);
+
+struct BulkFileJob
+{
+    std::string inPath;
+    std::string outPath;
+};
+
+struct BulkIoOptions
+{
+    IoBackend backend = IoBackend::Auto;
+    unsigned threads = 0;                // worker mã hoá, 0 = mọi core
+    std::size_t chunkSize = 1024 * 1024; // bội số 16
+    unsigned queueDepth = 64;            // số chunk đang đọc / mã hoá / ghi tối đa
+    unsigned maxOpenFiles = 32;          // số file mở cùng lúc
+};
+
+struct BulkIoResult
+{
+    IoBackend backend = IoBackend::Blocking; // backend đã thực sự chạy
+    std::size_t files = 0;
+    uint64_t bytesIn = 0;
+    uint64_t bytesOut = 0;
+    double seconds = 0;
+};
+
+// Tạo cipher mới cho mỗi file (CbcEncryptor, GcmDecryptor...);
+// backend Blocking gọi factory từ nhiều worker cùng lúc
+using CipherFactory = std::function<PipelineCipher()>;
+
+// Xử lý mọi job (mỗi file 1 chain riêng, chunk trong 1 file mã hoá đúng thứ tự).
+// File lỗi: dừng hẳn, xoá output của các file chưa xong rồi ném std::runtime_error;
+// file đã xong trước đó được giữ nguyên.
+BulkIoResult cipherFilesBulk(const std::vector<BulkFileJob> &jobs, const CipherFactory &factory,
+                             const BulkIoOptions &options = BulkIoOptions());
@@ -0,0 +1,417 @@
+#include "batch.h"
+#include "cbc.h"
+#include "ctr.h"
+#include "gcm.h"
+#include "file_io.h"
+#include "key_cache.h"
+#include "thread_pool.h"
+
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <ostream>
+#include <sstream>
+#include <stdexcept>
+
+using Clock = std::chrono::steady_clock;
+
+// ===== JSON phẳng: chỉ string / true / false =====
+
+namespace
+{
+
+class JsonLine
+{
+public:
+    explicit JsonLine(const std::string &text) : s(text) {}
+
+    // Gọi f(tên, giá trị) cho mỗi cặp; bool trả về "true" / "false"
+    template <class F>
+    void parseObject(F f)
+    {
+        skipSpace();
+        expect('{');
+        skipSpace();
+        if (peek() == '}')
+        {
+            ++pos;
+        }
+        else
+        {
+            for (;;)
+            {
+                skipSpace();
+                std::string name = parseString();
+                skipSpace();
+                expect(':');
+                skipSpace();
+                std::string value = parseValue();
+                f(name, value);
+                skipSpace();
+                if (peek() == ',')
+                {
+                    ++pos;
+                    continue;
+                }
+                expect('}');
+                break;
+            }
+        }
+        skipSpace();
+        if (pos != s.size())
+            fail("trailing characters after object");
+    }
+
+private:
+    const std::string &s;
+    std::size_t pos = 0;
+
+    [[noreturn]] void fail(const std::string &what) const
+    {
+        throw std::runtime_error("Invalid JSON at column " + std::to_string(pos + 1) + ": " + what);
+    }
+
+    char peek() const { return pos < s.size() ? s[pos] : '\0'; }
+
+    void skipSpace()
+    {
+        while (pos < s.size() && std::isspace(static_cast<unsigned char>(s[pos])))
+            ++pos;
+    }
+
+    void expect(char c)
+    {
+        if (peek() != c)
+            fail(std::string("expected '") + c + "'");
+        ++pos;
+    }
+
+    std::string parseValue()
+    {
+        if (peek() == '"')
+            return parseString();
+        for (const char *word : {"true", "false"})
+        {
+            std::size_t n = std::strlen(word);
+            if (s.compare(pos, n, word) == 0)
+            {
+                pos += n;
+                return word;
+            }
+        }
+        fail("expected a string, true or false");
+    }
+
+    std::string parseString()
+    {
+        expect('"');
+        std::string out;
+        for (;;)
+        {
+            if (pos >= s.size())
+                fail("unterminated string");
+            char c = s[pos++];
+            if (c == '"')
+                return out;
+            if (c != '\\')
+            {
+                out += c;
+                continue;
+            }
+            if (pos >= s.size())
+                fail("unterminated escape");
+            char e = s[pos++];
+            switch (e)
+            {
+            case '"':
+            case '\\':
+            case '/':
+                out += e;
+                break;
+            case 'b':
+                out += '\b';
+                break;
+            case 'f':
+                out += '\f';
+                break;
+            case 'n':
+                out += '\n';
+                break;
+            case 'r':
+                out += '\r';
+                break;
+            case 't':
+                out += '\t';
+                break;
+            case 'u':
+            {
+                // đường dẫn thường là ASCII: chỉ nhận \u0000..\u007f
+                if (pos + 4 > s.size())
+                    fail("short \\u escape");
+                unsigned v = 0;
+                for (int k = 0; k < 4; ++k)
+                {
+                    char h = static_cast<char>(std::tolower(static_cast<unsigned char>(s[pos + k])));
+                    if (!std::isxdigit(static_cast<unsigned char>(h)))
+                        fail("\\u escape needs 4 hex digits");
+                    v = v * 16 + static_cast<unsigned>(h <= '9' ? h - '0' : h - 'a' + 10);
+                }
+                if (v > 0x7f)
+                    fail("only ASCII \\u escapes are supported");
+                out += static_cast<char>(v);
+                pos += 4;
+                break;
+            }
+            default:
+                fail(std::string("bad escape \\") + e);
+            }
+        }
+    }
+};
+
+std::vector<uint8_t> parseHex(const std::string &field, const std::string &hex)
+{
+    auto nibble = [&](char c) -> uint8_t
+    {
+        if (c >= '0' && c <= '9')
+            return static_cast<uint8_t>(c - '0');
+        c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+        if (c >= 'a' && c <= 'f')
+            return static_cast<uint8_t>(10 + (c - 'a'));
+        throw std::runtime_error("Invalid hex digit in \"" + field + "\"");
+    };
+    if (hex.size() % 2 != 0)
+    {
+        throw std::runtime_error("Hex string \"" + field + "\" must have even length");
+    }
+    std::vector<uint8_t> out(hex.size() / 2);
+    for (std::size_t i = 0; i < out.size(); ++i)
+        out[i] = static_cast<uint8_t>((nibble(hex[2 * i]) << 4) | nibble(hex[2 * i + 1]));
+    return out;
+}
+
+} // namespace
+
+BatchJob parseBatchJob(const std::string &line)
+{
+    BatchJob job;
+    bool hasKey = false, hasIv = false;
+
+    JsonLine(line).parseObject([&](const std::string &name, const std::string &value)
+                               {
+                                   if (name == "op")
+                                       job.op = value;
+                                   else if (name == "mode")
+                                       job.mode = value;
+                                   else if (name == "in")
+                                       job.in = value;
+                                   else if (name == "out")
+                                       job.out = value;
+                                   else if (name == "id")
+                                       job.id = value;
+                                   else if (name == "key")
+                                   {
+                                       std::vector<uint8_t> k = parseHex(name, value);
+                                       if (k.size() != 16)
+                                       {
+                                           throw std::runtime_error("\"key\" must be 32 hex characters (16 bytes)");
+                                       }
+                                       std::memcpy(job.key, k.data(), 16);
+                                       hasKey = true;
+                                   }
+                                   else if (name == "iv")
+                                   {
+                                       job.iv = parseHex(name, value);
+                                       hasIv = true;
+                                   }
+                                   else if (name == "aad")
+                                       job.aad = parseHex(name, value);
+                                   else if (name == "pad")
+                                   {
+                                       if (value != "true" && value != "false")
+                                       {
+                                           throw std::runtime_error("\"pad\" must be true or false");
+                                       }
+                                       job.padding = value == "true";
+                                   }
+                                   else
+                                   {
+                                       throw std::runtime_error("Unknown field \"" + name + "\"");
+                                   } });
+
+    if (job.op != "enc" && job.op != "dec")
+    {
+        throw std::runtime_error("\"op\" must be \"enc\" or \"dec\"");
+    }
+    if (job.in.empty() || job.out.empty() || !hasKey || !hasIv)
+    {
+        throw std::runtime_error("Missing field (op, in, out, key and iv are required)");
+    }
+    if (job.in == "-" || job.out == "-")
+    {
+        throw std::runtime_error("stdin / stdout cannot be used in batch jobs");
+    }
+    if (job.mode != "cbc" && job.mode != "ctr" && job.mode != "gcm")
+    {
+        throw std::runtime_error("Unknown mode: " + job.mode);
+    }
+    if (job.mode != "gcm" && job.iv.size() != 16)
+    {
+        throw std::runtime_error("\"iv\" must be 32 hex characters (16 bytes) for " + job.mode);
+    }
+    if (job.mode == "gcm" && job.iv.empty())
+    {
+        throw std::runtime_error("\"iv\" must not be empty");
+    }
+    if (job.mode != "cbc" && !job.padding)
+    {
+        throw std::runtime_error("\"pad\" only applies to cbc");
+    }
+    if (job.mode != "gcm" && !job.aad.empty())
+    {
+        throw std::runtime_error("\"aad\" only applies to gcm");
+    }
+    return job;
+}
+
+// ===== chạy job =====
+
+// Input mmap, output preallocate + commit như aes_tool enc/dec (file nhỏ: 1 lần update)
+template <class Cipher>
+static std::size_t runCipher(Cipher &cipher, const InputFile &in, OutputFile &out)
+{
+    std::size_t n = cipher.update(in.data(), in.size(), out.data());
+    n += cipher.final(out.data() + n);
+    out.commit(n);
+    return n;
+}
+
+static void runBatchJob(const BatchJob &job, const AES128 &aes, uint64_t &bytesIn, uint64_t &bytesOut)
+{
+    if (sameFile(job.in, job.out))
+    {
+        throw std::runtime_error("Input and output must be different files");
+    }
+
+    InputFile in(job.in);
+    OutputFile out(job.out, in.size() + AES128::BlockSize); // đủ cho padding / tag
+    bytesIn = in.size();
+
+    if (job.mode == "gcm")
+    {
+        if (job.op == "enc")
+        {
+            GcmEncryptor c(aes, job.iv.data(), job.iv.size(), job.aad.data(), job.aad.size());
+            bytesOut = runCipher(c, in, out);
+        }
+        else
+        {
+            GcmDecryptor c(aes, job.iv.data(), job.iv.size(), job.aad.data(), job.aad.size());
+            bytesOut = runCipher(c, in, out);
+        }
+    }
+    else if (job.mode == "ctr")
+    {
+        CtrCipher c(aes, job.iv.data());
+        bytesOut = runCipher(c, in, out);
+    }
+    else if (job.op == "enc")
+    {
+        CbcEncryptor c(aes, job.iv.data(), job.padding);
+        bytesOut = runCipher(c, in, out);
+    }
+    else
+    {
+        CbcDecryptor c(aes, job.iv.data(), job.padding);
+        bytesOut = runCipher(c, in, out);
+    }
+}
+
+BatchSummary runBatchFile(const std::string &jobsPath, unsigned threads, std::ostream &report)
+{
+    std::ifstream ifs(jobsPath);
+    if (!ifs)
+    {
+        throw std::runtime_error("Cannot open jobs file: " + jobsPath);
+    }
+
+    KeyScheduleCache keys;
+    std::mutex reportMutex;
+    std::atomic<std::size_t> jobs{0}, ok{0}, failed{0};
+    std::atomic<uint64_t> totalIn{0}, totalOut{0};
+
+    auto printResult = [&](std::size_t line, const std::string &name, const std::string &text)
+    {
+        std::lock_guard<std::mutex> lock(reportMutex);
+        report << "[job " << line << "] " << name << text << "\n";
+    };
+
+    auto start = Clock::now();
+    {
+        ThreadPool pool(threads);
+        std::string text;
+        for (std::size_t line = 1; std::getline(ifs, text); ++line)
+        {
+            if (!text.empty() && text.back() == '\r')
+                text.pop_back();
+            if (text.find_first_not_of(" \t") == std::string::npos)
+                continue;
+            ++jobs;
+
+            // parse ngay trên thread đọc: dòng sai báo lỗi luôn, không chiếm worker
+            std::shared_ptr<BatchJob> job;
+            try
+            {
+                job = std::make_shared<BatchJob>(parseBatchJob(text));
+                job->line = line;
+            }
+            catch (const std::exception &ex)
+            {
+                ++failed;
+                printResult(line, "", std::string("FAILED: ") + ex.what());
+                continue;
+            }
+
+            pool.submit([&, job]()
+                        {
+                            std::string name = (job->id.empty() ? "" : job->id + " ") + job->op + " " +
+                                               job->mode + " " + job->in + " -> " + job->out;
+                            auto t0 = Clock::now();
+                            try
+                            {
+                                uint64_t in = 0, out = 0;
+                                runBatchJob(*job, *keys.get(job->key), in, out);
+                                double ms = std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+                                ++ok;
+                                totalIn += in;
+                                totalOut += out;
+                                std::ostringstream text;
+                                text << ": OK, " << in << " -> " << out << " bytes, " << ms << " ms";
+                                printResult(job->line, name, text.str());
+                            }
+                            catch (const std::exception &ex)
+                            {
+                                ++failed;
+                                printResult(job->line, name, std::string(": FAILED: ") + ex.what());
+                            } });
+        }
+        if (ifs.bad())
+        {
+            throw std::runtime_error("Error reading jobs file: " + jobsPath);
+        }
+        pool.wait();
+    }
+
+    BatchSummary sum;
+    sum.jobs = jobs;
+    sum.ok = ok;
+    sum.failed = failed;
+    sum.bytesIn = totalIn;
+    sum.bytesOut = totalOut;
+    sum.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    sum.keysExpanded = keys.expanded();
+    sum.keysReused = keys.reused();
+    return sum;
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+// ===== aes_tool batch --jobs file.jsonl =====
+// Mỗi dòng 1 object JSON phẳng:
+//   {"op": "enc", "in": "a.bin", "out": "a.enc", "key": "<32 hex>", "iv": "<hex>"}
+// Tuỳ chọn: "mode": "cbc|ctr|gcm", "aad": "<hex>" (gcm), "pad": false (cbc), "id": "<tên>".
+// Dòng trống được bỏ qua. Các job chạy song song trên ThreadPool (không theo thứ tự,
+// nên job không được dùng output của job khác), mỗi job ghi 1 dòng kết quả.
+
+struct BatchJob
+{
+    std::size_t line = 0; // số dòng trong file jobs (từ 1)
+    std::string id;
+    std::string op;   // "enc" | "dec"
+    std::string mode = "cbc";
+    std::string in;
+    std::string out;
+    uint8_t key[16] = {};
+    std::vector<uint8_t> iv; // cbc/ctr: 16 byte; gcm: độ dài tuỳ ý
+    std::vector<uint8_t> aad;
+    bool padding = true;
+};
+
+// Parse 1 dòng JSONL; ném std::runtime_error nếu sai cú pháp / thiếu trường / giá trị sai
+BatchJob parseBatchJob(const std::string &line);
+
+struct BatchSummary
+{
+    std::size_t jobs = 0;
+    std::size_t ok = 0;
+    std::size_t failed = 0;
+    uint64_t bytesIn = 0;
+    uint64_t bytesOut = 0;
+    double seconds = 0;
+    std::size_t keysExpanded = 0;
+    std::size_t keysReused = 0;
+};
+
+// Đọc file jobs, chạy mọi job trên threads worker (0 = mọi core).
+// Dòng kết quả của từng job ghi ra report theo thứ tự job xong; job lỗi không dừng batch.
+// Ném std::runtime_error chỉ khi không mở được file jobs.
+BatchSummary runBatchFile(const std::string &jobsPath, unsigned threads, std::ostream &report);
@@ -1,4 +1,5 @@
 #include "cbc.h"
+#include <cstring>
 #include <stdexcept>
 
 // XOR 2 block 16 byte
@@ -10,36 +11,86 @@ static void xorBlock(uint8_t *dst, const uint8_t *src)
     }
 }
 
-std::vector<uint8_t> pkcs7Pad(const std::vector<uint8_t> &data,
-                              std::size_t blockSize)
+// Mã hoá CBC nblocks block đầy đủ.
+// prev: vào là IV (hoặc ciphertext block trước), ra là ciphertext block cuối.
+// in và out được phép trùng nhau.
+static void cbcEncryptBlocks(const AES128 &aes, uint8_t prev[16],
+                             const uint8_t *in, uint8_t *out, std::size_t nblocks)
 {
-    if (blockSize == 0 || blockSize > 255)
+    uint8_t block[16];
+
+    for (std::size_t b = 0; b < nblocks; ++b)
     {
-        throw std::runtime_error("Invalid blockSize");
+        // XOR với prev (IV hoặc ciphertext trước)
+        for (int i = 0; i < 16; ++i)
+        {
+            block[i] = in[i] ^ prev[i];
+        }
+
+        aes.encryptBlock(block, out);
+        std::memcpy(prev, out, 16);
+
+        in += 16;
+        out += 16;
     }
+}
 
-    std::vector<uint8_t> out = data;
-    std::size_t padLen = blockSize - (out.size() % blockSize);
-    if (padLen == 0)
-        padLen = blockSize;
+// Giải mã CBC song song: mỗi plaintext block chỉ phụ thuộc ciphertext,
+// nên giải mã BatchBlocks block độc lập một lượt (decryptBlocks),
+// sau đó mới XOR với ciphertext block đứng trước.
+// prev: vào là IV, ra là ciphertext block cuối. in và out được phép trùng nhau.
+static void cbcDecryptBlocks(const AES128 &aes, uint8_t prev[16],
+                             const uint8_t *in, uint8_t *out, std::size_t nblocks)
+{
+    constexpr std::size_t lanes = AES128::BatchBlocks;
 
-    out.insert(out.end(), padLen, static_cast<uint8_t>(padLen));
-    return out;
+    // giữ bản sao ciphertext của chunk vì out có thể đè lên in
+    uint8_t ct[lanes * 16];
+
+    while (nblocks > 0)
+    {
+        std::size_t n = nblocks < lanes ? nblocks : lanes;
+        std::memcpy(ct, in, n * 16);
+
+        aes.decryptBlocks(ct, out, n);
+
+        xorBlock(out, prev);
+        for (std::size_t b = 1; b < n; ++b)
+        {
+            xorBlock(out + 16 * b, ct + 16 * (b - 1));
+        }
+        std::memcpy(prev, ct + 16 * (n - 1), 16);
+
+        in += n * 16;
+        out += n * 16;
+        nblocks -= n;
+    }
 }
 
-std::vector<uint8_t> pkcs7Unpad(const std::vector<uint8_t> &data,
-                                std::size_t blockSize)
+// ===== PKCS#7 =====
+
+std::size_t pkcs7PaddedSize(std::size_t len, std::size_t blockSize)
+{
+    if (blockSize == 0 || blockSize > 255)
+    {
+        throw std::runtime_error("Invalid blockSize");
+    }
+    return (len / blockSize + 1) * blockSize;
+}
+
+std::size_t pkcs7UnpaddedSize(const uint8_t *data, std::size_t len,
+                              std::size_t blockSize)
 {
-    if (data.empty() || data.size() % blockSize != 0)
+    if (len == 0 || blockSize == 0 || len % blockSize != 0)
     {
         throw std::runtime_error("Invalid PKCS#7 padding (size)");
     }
-    uint8_t padLen = data.back();
+    uint8_t padLen = data[len - 1];
     if (padLen == 0 || padLen > blockSize)
     {
         throw std::runtime_error("Invalid PKCS#7 padding (value)");
     }
-    if (padLen > data.size())
+    if (padLen > len)
     {
         throw std::runtime_error("Invalid PKCS#7 padding (too large)");
     }
@@ -47,195 +98,468 @@ std::vector<uint8_t> pkcs7Unpad(const std::vector<uint8_t> &data,
     // kiểm tra tất cả pad byte
     for (std::size_t i = 0; i < padLen; ++i)
     {
-        if (data[data.size() - 1 - i] != padLen)
+        if (data[len - 1 - i] != padLen)
         {
             throw std::runtime_error("Invalid PKCS#7 padding (pattern)");
         }
     }
 
-    std::vector<uint8_t> out(data.begin(), data.end() - padLen);
+    return len - padLen;
+}
+
+std::vector<uint8_t> pkcs7Pad(const std::vector<uint8_t> &data,
+                              std::size_t blockSize)
+{
+    return pkcs7Pad(data.data(), data.size(), blockSize);
+}
+
+std::vector<uint8_t> pkcs7Pad(const uint8_t *data, std::size_t len,
+                              std::size_t blockSize)
+{
+    std::vector<uint8_t> out(pkcs7PaddedSize(len, blockSize));
+    pkcs7PadInto(data, len, out.data(), blockSize);
     return out;
 }
 
-// ===== CBC + PKCS#7 =====
+std::size_t pkcs7PadInto(const uint8_t *data, std::size_t len, uint8_t *out,
+                         std::size_t blockSize)
+{
+    std::size_t padded = pkcs7PaddedSize(len, blockSize);
+    if (len > 0 && out != data)
+    {
+        std::memmove(out, data, len);
+    }
+    std::memset(out + len, static_cast<int>(padded - len), padded - len);
+    return padded;
+}
 
-std::vector<uint8_t> cbcEncrypt(const std::vector<uint8_t> &plaintext,
-                                const uint8_t key[16],
-                                const uint8_t iv[16])
+std::vector<uint8_t> pkcs7Unpad(const std::vector<uint8_t> &data,
+                                std::size_t blockSize)
 {
-    AES128 aes(key);
+    std::size_t len = pkcs7UnpaddedSize(data.data(), data.size(), blockSize);
+    return std::vector<uint8_t>(data.begin(), data.begin() + len);
+}
 
-    // pad plaintext
-    std::vector<uint8_t> padded = pkcs7Pad(plaintext, AES128::BlockSize);
+// ===== CBC + PKCS#7 =====
 
-    std::vector<uint8_t> out;
-    out.resize(padded.size());
+std::size_t cbcEncrypt(const uint8_t *in, std::size_t len,
+                       uint8_t *out, std::size_t outCapacity,
+                       const AES128 &aes,
+                       const uint8_t iv[16])
+{
+    std::size_t outLen = pkcs7PaddedSize(len, AES128::BlockSize);
+    if (outCapacity < outLen)
+    {
+        throw std::runtime_error("Output buffer too small for CBC + PKCS#7");
+    }
 
     uint8_t prev[16];
-    for (int i = 0; i < 16; ++i)
-        prev[i] = iv[i];
-
-    uint8_t block[16];
-    uint8_t cipher[16];
+    std::memcpy(prev, iv, 16);
 
-    for (std::size_t offset = 0; offset < padded.size(); offset += 16)
-    {
-        // copy block
-        for (int i = 0; i < 16; ++i)
-        {
-            block[i] = padded[offset + i];
-        }
+    std::size_t full = len / 16;
+    cbcEncryptBlocks(aes, prev, in, out, full);
 
-        // XOR với prev (IV hoặc ciphertext trước)
-        xorBlock(block, prev);
+    // block cuối: phần dư + padding, dựng trên stack rồi mã hoá thẳng vào out
+    std::size_t rem = len - full * 16;
+    uint8_t last[16];
+    if (rem > 0)
+        std::memcpy(last, in + full * 16, rem);
+    std::memset(last + rem, static_cast<int>(16 - rem), 16 - rem);
+    cbcEncryptBlocks(aes, prev, last, out + full * 16, 1);
 
-        // AES encrypt
-        aes.encryptBlock(block, cipher);
+    return outLen;
+}
 
-        // lưu output và cập nhật prev
-        for (int i = 0; i < 16; ++i)
-        {
-            out[offset + i] = cipher[i];
-            prev[i] = cipher[i];
-        }
+std::size_t cbcDecrypt(const uint8_t *in, std::size_t len,
+                       uint8_t *out,
+                       const AES128 &aes,
+                       const uint8_t iv[16])
+{
+    if (len == 0 || len % 16 != 0)
+    {
+        throw std::runtime_error("Ciphertext size must be multiple of 16");
     }
 
+    uint8_t prev[16];
+    std::memcpy(prev, iv, 16);
+    cbcDecryptBlocks(aes, prev, in, out, len / 16);
+
+    // remove padding
+    return pkcs7UnpaddedSize(out, len, AES128::BlockSize);
+}
+
+std::vector<uint8_t> cbcEncrypt(const std::vector<uint8_t> &plaintext,
+                                const AES128 &aes,
+                                const uint8_t iv[16])
+{
+    std::vector<uint8_t> out(pkcs7PaddedSize(plaintext.size(), AES128::BlockSize));
+    cbcEncrypt(plaintext.data(), plaintext.size(), out.data(), out.size(), aes, iv);
     return out;
 }
 
 std::vector<uint8_t> cbcDecrypt(const std::vector<uint8_t> &ciphertext,
-                                const uint8_t key[16],
+                                const AES128 &aes,
                                 const uint8_t iv[16])
 {
-    if (ciphertext.empty() || ciphertext.size() % 16 != 0)
-    {
-        throw std::runtime_error("Ciphertext size must be multiple of 16");
-    }
+    std::vector<uint8_t> plain(ciphertext.size());
+    std::size_t len = cbcDecrypt(ciphertext.data(), ciphertext.size(), plain.data(), aes, iv);
+    plain.resize(len);
+    return plain;
+}
 
-    AES128 aes(key);
+// ===== CBC no-pad (dùng cho KAT SP 800-38A) =====
 
-    std::vector<uint8_t> plain;
-    plain.resize(ciphertext.size());
+void cbcEncryptNoPad(const uint8_t *in, std::size_t len,
+                     uint8_t *out,
+                     const AES128 &aes,
+                     const uint8_t iv[16])
+{
+    if (len == 0 || (len % 16) != 0)
+    {
+        throw std::runtime_error("Plaintext size must be multiple of 16 for no-pad CBC");
+    }
 
     uint8_t prev[16];
-    for (int i = 0; i < 16; ++i)
-        prev[i] = iv[i];
-
-    uint8_t block[16];
-    uint8_t decrypted[16];
+    std::memcpy(prev, iv, 16);
+    cbcEncryptBlocks(aes, prev, in, out, len / 16);
+}
 
-    for (std::size_t offset = 0; offset < ciphertext.size(); offset += 16)
+void cbcDecryptNoPad(const uint8_t *in, std::size_t len,
+                     uint8_t *out,
+                     const AES128 &aes,
+                     const uint8_t iv[16])
+{
+    if (len == 0 || (len % 16) != 0)
     {
-        // copy current ciphertext block
-        for (int i = 0; i < 16; ++i)
-        {
-            block[i] = ciphertext[offset + i];
-        }
+        throw std::runtime_error("Ciphertext size must be multiple of 16 for no-pad CBC");
+    }
 
-        // AES decrypt
-        aes.decryptBlock(block, decrypted);
+    uint8_t prev[16];
+    std::memcpy(prev, iv, 16);
+    cbcDecryptBlocks(aes, prev, in, out, len / 16); // KHÔNG unpad
+}
 
-        // XOR với prev để ra plaintext block
-        for (int i = 0; i < 16; ++i)
-        {
-            plain[offset + i] = decrypted[i] ^ prev[i];
-        }
+std::vector<uint8_t> cbcEncryptNoPad(const std::vector<uint8_t> &plaintext,
+                                     const AES128 &aes,
+                                     const uint8_t iv[16])
+{
+    std::vector<uint8_t> out(plaintext.size());
+    cbcEncryptNoPad(plaintext.data(), plaintext.size(), out.data(), aes, iv);
+    return out;
+}
 
-        // cập nhật prev
-        for (int i = 0; i < 16; ++i)
-        {
-            prev[i] = block[i];
-        }
-    }
+std::vector<uint8_t> cbcDecryptNoPad(const std::vector<uint8_t> &ciphertext,
+                                     const AES128 &aes,
+                                     const uint8_t iv[16])
+{
+    std::vector<uint8_t> plain(ciphertext.size());
+    cbcDecryptNoPad(ciphertext.data(), ciphertext.size(), plain.data(), aes, iv);
+    return plain;
+}
 
-    // remove padding
-    return pkcs7Unpad(plain, AES128::BlockSize);
+// ===== Bản nhận key: expand key rồi gọi bản AES128 =====
+
+std::vector<uint8_t> cbcEncrypt(const std::vector<uint8_t> &plaintext,
+                                const uint8_t key[16],
+                                const uint8_t iv[16])
+{
+    return cbcEncrypt(plaintext, AES128(key), iv);
 }
 
-// ===== CBC no-pad (dùng cho KAT SP 800-38A) =====
+std::vector<uint8_t> cbcDecrypt(const std::vector<uint8_t> &ciphertext,
+                                const uint8_t key[16],
+                                const uint8_t iv[16])
+{
+    return cbcDecrypt(ciphertext, AES128(key), iv);
+}
 
 std::vector<uint8_t> cbcEncryptNoPad(const std::vector<uint8_t> &plaintext,
                                      const uint8_t key[16],
                                      const uint8_t iv[16])
 {
-    if (plaintext.empty() || (plaintext.size() % 16) != 0)
+    return cbcEncryptNoPad(plaintext, AES128(key), iv);
+}
+
+std::vector<uint8_t> cbcDecryptNoPad(const std::vector<uint8_t> &ciphertext,
+                                     const uint8_t key[16],
+                                     const uint8_t iv[16])
+{
+    return cbcDecryptNoPad(ciphertext, AES128(key), iv);
+}
+
+std::size_t cbcEncrypt(const uint8_t *in, std::size_t len,
+                       uint8_t *out, std::size_t outCapacity,
+                       const uint8_t key[16],
+                       const uint8_t iv[16])
+{
+    return cbcEncrypt(in, len, out, outCapacity, AES128(key), iv);
+}
+
+std::size_t cbcDecrypt(const uint8_t *in, std::size_t len,
+                       uint8_t *out,
+                       const uint8_t key[16],
+                       const uint8_t iv[16])
+{
+    return cbcDecrypt(in, len, out, AES128(key), iv);
+}
+
+void cbcEncryptNoPad(const uint8_t *in, std::size_t len,
+                     uint8_t *out,
+                     const uint8_t key[16],
+                     const uint8_t iv[16])
+{
+    cbcEncryptNoPad(in, len, out, AES128(key), iv);
+}
+
+void cbcDecryptNoPad(const uint8_t *in, std::size_t len,
+                     uint8_t *out,
+                     const uint8_t key[16],
+                     const uint8_t iv[16])
+{
+    cbcDecryptNoPad(in, len, out, AES128(key), iv);
+}
+
+// ===== CBC streaming =====
+
+CbcEncryptor::CbcEncryptor(const uint8_t key[16], const uint8_t iv[16], bool padding)
+    : CbcEncryptor(AES128(key), iv, padding)
+{
+}
+
+CbcEncryptor::CbcEncryptor(const AES128 &aes, const uint8_t iv[16], bool padding)
+    : aes(aes), partialLen(0), padding(padding)
+{
+    std::memcpy(prev, iv, 16);
+}
+
+std::size_t CbcEncryptor::update(const uint8_t *in, std::size_t len, uint8_t *out)
+{
+    std::size_t written = 0;
+
+    // hoàn thành block dở dang từ lần trước
+    if (partialLen > 0)
     {
-        throw std::runtime_error("Plaintext size must be multiple of 16 for no-pad CBC");
+        std::size_t take = 16 - partialLen;
+        if (take > len)
+            take = len;
+        std::memcpy(partial + partialLen, in, take);
+        partialLen += take;
+        in += take;
+        len -= take;
+
+        if (partialLen < 16)
+            return 0;
+
+        cbcEncryptBlocks(aes, prev, partial, out, 1);
+        partialLen = 0;
+        out += 16;
+        written += 16;
     }
 
-    AES128 aes(key);
+    // các block đầy đủ: mã hoá thẳng từ in sang out
+    std::size_t full = len / 16;
+    cbcEncryptBlocks(aes, prev, in, out, full);
+    written += full * 16;
 
-    std::vector<uint8_t> out;
-    out.resize(plaintext.size());
+    partialLen = len - full * 16;
+    if (partialLen > 0)
+        std::memcpy(partial, in + full * 16, partialLen);
 
-    uint8_t prev[16];
-    for (int i = 0; i < 16; ++i)
-        prev[i] = iv[i];
-
-    uint8_t block[16];
-    uint8_t cipher[16];
+    return written;
+}
 
-    for (std::size_t offset = 0; offset < plaintext.size(); offset += 16)
+std::size_t CbcEncryptor::final(uint8_t *out)
+{
+    if (!padding)
     {
-        for (int i = 0; i < 16; ++i)
+        if (partialLen != 0)
         {
-            block[i] = plaintext[offset + i];
+            throw std::runtime_error("Plaintext size must be multiple of 16 for no-pad CBC");
         }
+        return 0;
+    }
 
-        xorBlock(block, prev);
+    std::memset(partial + partialLen, static_cast<int>(16 - partialLen), 16 - partialLen);
+    cbcEncryptBlocks(aes, prev, partial, out, 1);
+    partialLen = 0;
+    return 16;
+}
 
-        aes.encryptBlock(block, cipher);
+CbcDecryptor::CbcDecryptor(const uint8_t key[16], const uint8_t iv[16], bool padding)
+    : CbcDecryptor(AES128(key), iv, padding)
+{
+}
 
-        for (int i = 0; i < 16; ++i)
-        {
-            out[offset + i] = cipher[i];
-            prev[i] = cipher[i];
-        }
+CbcDecryptor::CbcDecryptor(const AES128 &aes, const uint8_t iv[16], bool padding)
+    : aes(aes), partialLen(0), padding(padding)
+{
+    std::memcpy(prev, iv, 16);
+}
+
+std::size_t CbcDecryptor::update(const uint8_t *in, std::size_t len, uint8_t *out)
+{
+    // số block được giải mã ngay; khi có padding luôn giữ lại >= 1 byte
+    // (tức block cuối cùng) cho final()
+    std::size_t total = partialLen + len;
+    std::size_t outBlocks = padding ? (total == 0 ? 0 : (total - 1) / 16) : total / 16;
+    std::size_t written = outBlocks * 16;
+
+    if (outBlocks > 0 && partialLen > 0)
+    {
+        std::size_t take = 16 - partialLen;
+        std::memcpy(partial + partialLen, in, take);
+        in += take;
+        len -= take;
+
+        cbcDecryptBlocks(aes, prev, partial, out, 1);
+        partialLen = 0;
+        out += 16;
+        --outBlocks;
     }
 
-    return out;
+    // các block còn lại giải mã song song thẳng từ in sang out
+    cbcDecryptBlocks(aes, prev, in, out, outBlocks);
+    in += outBlocks * 16;
+    len -= outBlocks * 16;
+
+    std::memcpy(partial + partialLen, in, len);
+    partialLen += len;
+
+    return written;
 }
 
-std::vector<uint8_t> cbcDecryptNoPad(const std::vector<uint8_t> &ciphertext,
-                                     const uint8_t key[16],
-                                     const uint8_t iv[16])
+std::size_t CbcDecryptor::final(uint8_t *out)
 {
-    if (ciphertext.empty() || (ciphertext.size() % 16) != 0)
+    if (!padding)
     {
-        throw std::runtime_error("Ciphertext size must be multiple of 16 for no-pad CBC");
+        if (partialLen != 0)
+        {
+            throw std::runtime_error("Ciphertext size must be multiple of 16 for no-pad CBC");
+        }
+        return 0;
     }
 
-    AES128 aes(key);
+    if (partialLen != 16)
+    {
+        throw std::runtime_error("Ciphertext size must be multiple of 16");
+    }
 
-    std::vector<uint8_t> plain;
-    plain.resize(ciphertext.size());
+    uint8_t last[16];
+    cbcDecryptBlocks(aes, prev, partial, last, 1);
+    partialLen = 0;
 
-    uint8_t prev[16];
-    for (int i = 0; i < 16; ++i)
-        prev[i] = iv[i];
+    std::size_t n = pkcs7UnpaddedSize(last, 16, AES128::BlockSize);
+    std::memcpy(out, last, n);
+    return n;
+}
 
-    uint8_t block[16];
-    uint8_t decrypted[16];
+// ===== Multi-buffer CBC =====
+
+std::vector<std::vector<uint8_t>> cbcEncryptBatch(const std::vector<CbcJob> &jobs)
+{
+    constexpr std::size_t lanes = AES128::ParallelBlocks;
 
-    for (std::size_t offset = 0; offset < ciphertext.size(); offset += 16)
+    std::vector<std::vector<uint8_t>> out(jobs.size());
+
+    // mỗi job 1 key schedule (cùng layout roundKeys của AES128);
+    // chỉ expand key cho job không có schedule dựng sẵn
+    std::vector<AES128> expanded;
+    expanded.reserve(jobs.size());
+    std::vector<const AES128 *> schedules(jobs.size());
+    for (std::size_t j = 0; j < jobs.size(); ++j)
     {
-        for (int i = 0; i < 16; ++i)
+        if (jobs[j].schedule)
+        {
+            schedules[j] = jobs[j].schedule;
+        }
+        else
         {
-            block[i] = ciphertext[offset + i];
+            expanded.emplace_back(jobs[j].key);
+            schedules[j] = &expanded.back();
         }
+        out[j].resize((jobs[j].plaintext.size() / 16 + 1) * 16);
+    }
 
-        aes.decryptBlock(block, decrypted);
+    struct Lane
+    {
+        std::size_t job;
+        std::size_t offset;
+        uint8_t prev[16];
+    };
+    Lane lane[lanes];
+    std::size_t active = 0;
+    std::size_t nextJob = 0;
+
+    auto startJob = [&](Lane &l)
+    {
+        l.job = nextJob++;
+        l.offset = 0;
+        std::memcpy(l.prev, jobs[l.job].iv, 16);
+    };
 
-        for (int i = 0; i < 16; ++i)
+    while (active < lanes && nextJob < jobs.size())
+    {
+        startJob(lane[active++]);
+    }
+
+    uint8_t blocks[lanes][16];
+    const AES128 *ctx[lanes];
+    const uint8_t *in[lanes];
+    uint8_t *dst[lanes];
+
+    while (active > 0)
+    {
+        for (std::size_t i = 0; i < active; ++i)
         {
-            plain[offset + i] = decrypted[i] ^ prev[i];
+            Lane &l = lane[i];
+            const std::vector<uint8_t> &pt = jobs[l.job].plaintext;
+
+            // block đầy đủ, hoặc block cuối chứa padding PKCS#7
+            std::size_t remain = pt.size() - l.offset;
+            if (remain >= 16)
+            {
+                std::memcpy(blocks[i], pt.data() + l.offset, 16);
+            }
+            else
+            {
+                if (remain > 0)
+                    std::memcpy(blocks[i], pt.data() + l.offset, remain);
+                std::memset(blocks[i] + remain, static_cast<int>(16 - remain), 16 - remain);
+            }
+            xorBlock(blocks[i], l.prev);
+
+            ctx[i] = schedules[l.job];
+            in[i] = blocks[i];
+            dst[i] = out[l.job].data() + l.offset;
         }
 
-        for (int i = 0; i < 16; ++i)
+        AES128::encryptBlocksMulti(ctx, in, dst, active);
+
+        // cập nhật chain; lane xong job thì lấy job mới hoặc bị loại
+        for (std::size_t i = 0; i < active;)
         {
-            prev[i] = block[i];
+            Lane &l = lane[i];
+            std::memcpy(l.prev, dst[i], 16);
+            l.offset += 16;
+
+            if (l.offset < out[l.job].size())
+            {
+                ++i;
+            }
+            else if (nextJob < jobs.size())
+            {
+                startJob(l);
+                ++i;
+            }
+            else
+            {
+                // dồn lane cuối vào chỗ trống (dst tương ứng cũng dồn theo)
+                --active;
+                lane[i] = lane[active];
+                dst[i] = dst[active];
+            }
         }
     }
 
-    return plain; // KHÔNG unpad
+    return out;
 }
@@ -8,9 +8,26 @@
 std::vector<uint8_t> pkcs7Pad(const std::vector<uint8_t> &data,
                               std::size_t blockSize = AES128::BlockSize);
 
+std::vector<uint8_t> pkcs7Pad(const uint8_t *data, std::size_t len,
+                              std::size_t blockSize = AES128::BlockSize);
+
+// Pad vào buffer do caller cấp (>= pkcs7PaddedSize(len) byte), không cấp phát.
+// out có thể trùng data (pad tại chỗ). Trả về số byte đã ghi.
+std::size_t pkcs7PadInto(const uint8_t *data, std::size_t len, uint8_t *out,
+                         std::size_t blockSize = AES128::BlockSize);
+
 std::vector<uint8_t> pkcs7Unpad(const std::vector<uint8_t> &data,
                                 std::size_t blockSize = AES128::BlockSize);
 
+// Kích thước sau khi pad PKCS#7 (luôn thêm 1..blockSize byte)
+std::size_t pkcs7PaddedSize(std::size_t len,
+                            std::size_t blockSize = AES128::BlockSize);
+
+// Kiểm tra padding của data[0..len) và trả về độ dài dữ liệu thật (không copy).
+// Ném std::runtime_error nếu padding sai.
+std::size_t pkcs7UnpaddedSize(const uint8_t *data, std::size_t len,
+                              std::size_t blockSize = AES128::BlockSize);
+
 // CBC encryption/decryption với AES-128 + PKCS#7
 std::vector<uint8_t> cbcEncrypt(const std::vector<uint8_t> &plaintext,
                                 const uint8_t key[16],
@@ -29,3 +46,140 @@ std::vector<uint8_t> cbcEncryptNoPad(const std::vector<uint8_t> &plaintext,
 std::vector<uint8_t> cbcDecryptNoPad(const std::vector<uint8_t> &ciphertext,
                                      const uint8_t key[16],
                                      const uint8_t iv[16]);
+
+// ===== API con trỏ, không cấp phát heap =====
+// Output do caller cấp phát. out == in được phép (mã hoá/giải mã in-place),
+// ngoài ra hai vùng nhớ không được chồng lên nhau.
+// Các hàm vector ở trên chỉ là wrapper của nhóm hàm này.
+
+// CBC + PKCS#7: padding ghi thẳng vào block cuối của out.
+// outCapacity >= pkcs7PaddedSize(len). Trả về số byte ciphertext đã ghi.
+std::size_t cbcEncrypt(const uint8_t *in, std::size_t len,
+                       uint8_t *out, std::size_t outCapacity,
+                       const uint8_t key[16],
+                       const uint8_t iv[16]);
+
+// out cần len byte (len bội số 16). Trả về độ dài plaintext sau khi bỏ padding.
+std::size_t cbcDecrypt(const uint8_t *in, std::size_t len,
+                       uint8_t *out,
+                       const uint8_t key[16],
+                       const uint8_t iv[16]);
+
+// No-pad: len bội số 16, out cần len byte
+void cbcEncryptNoPad(const uint8_t *in, std::size_t len,
+                     uint8_t *out,
+                     const uint8_t key[16],
+                     const uint8_t iv[16]);
+
+void cbcDecryptNoPad(const uint8_t *in, std::size_t len,
+                     uint8_t *out,
+                     const uint8_t key[16],
+                     const uint8_t iv[16]);
+
+// ===== Bản nhận key schedule dựng sẵn =====
+// Các hàm nhận key ở trên expand key mỗi lần gọi. Khi mã hoá nhiều message
+// cùng key, dựng AES128 một lần (cả decrypt schedule InvMixColumns cũng được
+// tính sẵn trong constructor) rồi dùng lại với các overload dưới đây.
+
+std::vector<uint8_t> cbcEncrypt(const std::vector<uint8_t> &plaintext,
+                                const AES128 &aes,
+                                const uint8_t iv[16]);
+
+std::vector<uint8_t> cbcDecrypt(const std::vector<uint8_t> &ciphertext,
+                                const AES128 &aes,
+                                const uint8_t iv[16]);
+
+std::vector<uint8_t> cbcEncryptNoPad(const std::vector<uint8_t> &plaintext,
+                                     const AES128 &aes,
+                                     const uint8_t iv[16]);
+
+std::vector<uint8_t> cbcDecryptNoPad(const std::vector<uint8_t> &ciphertext,
+                                     const AES128 &aes,
+                                     const uint8_t iv[16]);
+
+std::size_t cbcEncrypt(const uint8_t *in, std::size_t len,
+                       uint8_t *out, std::size_t outCapacity,
+                       const AES128 &aes,
+                       const uint8_t iv[16]);
+
+std::size_t cbcDecrypt(const uint8_t *in, std::size_t len,
+                       uint8_t *out,
+                       const AES128 &aes,
+                       const uint8_t iv[16]);
+
+void cbcEncryptNoPad(const uint8_t *in, std::size_t len,
+                     uint8_t *out,
+                     const AES128 &aes,
+                     const uint8_t iv[16]);
+
+void cbcDecryptNoPad(const uint8_t *in, std::size_t len,
+                     uint8_t *out,
+                     const AES128 &aes,
+                     const uint8_t iv[16]);
+
+// ===== CBC streaming (init/update/final) =====
+// Dùng cho input không giới hạn kích thước: giữ chaining block (prev)
+// và phần block dở dang giữa các lần update, bộ nhớ không đổi.
+// Với cả hai class: out không được chồng lên in.
+
+class CbcEncryptor
+{
+public:
+    // padding = false: tương đương cbcEncryptNoPad (tổng input phải bội số 16)
+    CbcEncryptor(const uint8_t key[16], const uint8_t iv[16], bool padding = true);
+    CbcEncryptor(const AES128 &aes, const uint8_t iv[16], bool padding = true);
+
+    // out cần ít nhất len + 15 byte. Trả về số byte ciphertext đã ghi (bội số 16).
+    std::size_t update(const uint8_t *in, std::size_t len, uint8_t *out);
+
+    // Ghi block cuối (PKCS#7) vào out (cần 16 byte). Trả về số byte đã ghi.
+    // Ném std::runtime_error nếu no-pad mà còn dư byte.
+    std::size_t final(uint8_t *out);
+
+private:
+    AES128 aes;
+    uint8_t prev[16];
+    uint8_t partial[16];
+    std::size_t partialLen;
+    bool padding;
+};
+
+class CbcDecryptor
+{
+public:
+    CbcDecryptor(const uint8_t key[16], const uint8_t iv[16], bool padding = true);
+    CbcDecryptor(const AES128 &aes, const uint8_t iv[16], bool padding = true);
+
+    // out cần ít nhất len + 15 byte. Trả về số byte plaintext đã ghi.
+    // Khi có padding, block đầy đủ cuối cùng luôn được giữ lại cho final().
+    std::size_t update(const uint8_t *in, std::size_t len, uint8_t *out);
+
+    // Giải mã block giữ lại, bỏ padding, ghi tối đa 15 byte vào out.
+    // Ném std::runtime_error nếu ciphertext không đủ block hoặc padding sai.
+    std::size_t final(uint8_t *out);
+
+private:
+    AES128 aes;
+    uint8_t prev[16];
+    uint8_t partial[16];
+    std::size_t partialLen;
+    bool padding;
+};
+
+// ===== Multi-buffer CBC (nhiều stream độc lập) =====
+
+// 1 job: key, iv và plaintext riêng; độ dài bất kỳ (sẽ được pad PKCS#7)
+struct CbcJob
+{
+    uint8_t key[16];
+    uint8_t iv[16];
+    std::vector<uint8_t> plaintext;
+    const AES128 *schedule = nullptr; // nếu khác null: dùng thay cho key (không expand lại)
+};
+
+// Mã hoá CBC + PKCS#7 cho nhiều job cùng lúc.
+// CBC nối tiếp trong 1 stream, nên mỗi bước lấy 1 block từ tối đa
+// AES128::ParallelBlocks stream khác nhau và mã hoá xen kẽ (multi-buffer).
+// Job xong trước thì lane đó nhận job kế tiếp.
+// Kết quả[i] giống hệt cbcEncrypt(jobs[i].plaintext, jobs[i].key, jobs[i].iv).
+std::vector<std::vector<uint8_t>> cbcEncryptBatch(const std::vector<CbcJob> &jobs);
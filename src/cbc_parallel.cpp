@@ -0,0 +1,275 @@
+#include "cbc_parallel.h"
+#include "cbc.h"
+#include "file_io.h"
+
+#include <cstring>
+#include <deque>
+#include <future>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <vector>
+
+static const char SegmentMagic[8] = {'A', 'E', 'S', '1', '2', '8', 'S', 'G'};
+
+void writeSegmentHeader(uint8_t out[SegmentHeaderSize], uint32_t segmentSize)
+{
+    std::memset(out, 0, SegmentHeaderSize);
+    std::memcpy(out, SegmentMagic, 8);
+    for (int i = 0; i < 4; ++i)
+        out[8 + i] = static_cast<uint8_t>(segmentSize >> (8 * i));
+}
+
+bool parseSegmentHeader(const uint8_t in[SegmentHeaderSize], uint32_t &segmentSize)
+{
+    if (std::memcmp(in, SegmentMagic, 8) != 0)
+        return false;
+
+    uint32_t size = 0;
+    for (int i = 0; i < 4; ++i)
+        size |= static_cast<uint32_t>(in[8 + i]) << (8 * i);
+    if (size == 0 || size % AES128::BlockSize != 0 ||
+        in[12] != 0 || in[13] != 0 || in[14] != 0 || in[15] != 0)
+    {
+        throw std::runtime_error("Invalid segmented file header");
+    }
+    segmentSize = size;
+    return true;
+}
+
+void segmentIv(const AES128 &aes, const uint8_t baseIv[16], uint64_t index, uint8_t iv[16])
+{
+    uint8_t block[16];
+    std::memcpy(block, baseIv, 16);
+    for (int i = 0; i < 8; ++i)
+        block[15 - i] ^= static_cast<uint8_t>(index >> (8 * i));
+    aes.encryptBlock(block, iv);
+}
+
+// ===== Chạy song song, ghi theo thứ tự =====
+
+namespace
+{
+
+// 1 đoạn dữ liệu: đọc vào buf, worker xử lý in-place, main ghi buf[0..len)
+struct Piece
+{
+    std::vector<uint8_t> buf;
+    std::size_t len = 0;
+    uint8_t iv[16];
+    std::future<void> done;
+};
+
+// Cửa sổ tối đa 2 * pool.size() piece đang chạy; piece đã ghi được tái sử dụng.
+// Huỷ khi đang lỗi vẫn chờ mọi task xong trước khi giải phóng buffer.
+class OrderedWriter
+{
+public:
+    OrderedWriter(ThreadPool &pool, std::ostream &os)
+        : pool(pool), os(os), maxInFlight(2 * static_cast<std::size_t>(pool.size()))
+    {
+    }
+
+    ~OrderedWriter()
+    {
+        for (auto &p : window)
+        {
+            if (p->done.valid())
+                p->done.wait();
+        }
+    }
+
+    std::unique_ptr<Piece> acquire(std::size_t capacity)
+    {
+        std::unique_ptr<Piece> p;
+        if (!spare.empty())
+        {
+            p = std::move(spare.back());
+            spare.pop_back();
+        }
+        else
+        {
+            p.reset(new Piece);
+        }
+        p->buf.resize(capacity);
+        p->len = 0;
+        return p;
+    }
+
+    template <class Work>
+    void add(std::unique_ptr<Piece> piece, Work work)
+    {
+        Piece *p = piece.get();
+        auto task = std::make_shared<std::packaged_task<void()>>([p, work]()
+                                                                 { work(*p); });
+        p->done = task->get_future();
+        window.push_back(std::move(piece));
+        pool.submit([task]()
+                    { (*task)(); });
+
+        if (window.size() >= maxInFlight)
+            writeFront();
+    }
+
+    void finish()
+    {
+        while (!window.empty())
+            writeFront();
+        os.flush();
+        if (!os)
+            throw std::runtime_error("Error writing output");
+    }
+
+private:
+    ThreadPool &pool;
+    std::ostream &os;
+    std::size_t maxInFlight;
+    std::deque<std::unique_ptr<Piece>> window;
+    std::vector<std::unique_ptr<Piece>> spare;
+
+    void writeFront()
+    {
+        Piece &p = *window.front();
+        p.done.get(); // ném lại lỗi của task (vd. padding sai)
+        os.write(reinterpret_cast<const char *>(p.buf.data()),
+                 static_cast<std::streamsize>(p.len));
+        if (!os)
+            throw std::runtime_error("Error writing output");
+        spare.push_back(std::move(window.front()));
+        window.pop_front();
+    }
+};
+
+} // namespace
+
+static bool atEnd(std::istream &in)
+{
+    return in.peek() == std::char_traits<char>::eof();
+}
+
+void cbcEncryptSegmented(const AES128 &aes, const uint8_t iv[16],
+                         std::istream &in, std::ostream &out,
+                         ThreadPool &pool, uint32_t segmentSize)
+{
+    if (segmentSize == 0 || segmentSize % AES128::BlockSize != 0)
+    {
+        throw std::runtime_error("Segment size must be a non-zero multiple of 16");
+    }
+
+    uint8_t header[SegmentHeaderSize];
+    writeSegmentHeader(header, segmentSize);
+    out.write(reinterpret_cast<const char *>(header), SegmentHeaderSize);
+
+    OrderedWriter writer(pool, out);
+    for (uint64_t index = 0;; ++index)
+    {
+        // + 1 block chỗ cho padding của segment cuối
+        std::unique_ptr<Piece> p = writer.acquire(segmentSize + AES128::BlockSize);
+        std::size_t n = readFull(in, p->buf.data(), segmentSize);
+        bool last = n < segmentSize;
+        segmentIv(aes, iv, index, p->iv);
+
+        writer.add(std::move(p), [&aes, n, last](Piece &piece)
+                   {
+                       if (last)
+                       {
+                           piece.len = cbcEncrypt(piece.buf.data(), n, piece.buf.data(),
+                                                  piece.buf.size(), aes, piece.iv);
+                       }
+                       else
+                       {
+                           cbcEncryptNoPad(piece.buf.data(), n, piece.buf.data(), aes, piece.iv);
+                           piece.len = n;
+                       } });
+        if (last)
+            break;
+    }
+    writer.finish();
+}
+
+void cbcDecryptSegmented(const AES128 &aes, const uint8_t iv[16],
+                         std::istream &in, std::ostream &out, ThreadPool &pool)
+{
+    uint8_t header[SegmentHeaderSize];
+    uint32_t segmentSize = 0;
+    if (readFull(in, header, SegmentHeaderSize) != SegmentHeaderSize ||
+        !parseSegmentHeader(header, segmentSize))
+    {
+        throw std::runtime_error("Input is not a segmented (--threads) file");
+    }
+
+    OrderedWriter writer(pool, out);
+    for (uint64_t index = 0;; ++index)
+    {
+        std::unique_ptr<Piece> p = writer.acquire(segmentSize);
+        std::size_t n = readFull(in, p->buf.data(), segmentSize);
+        bool last = n < segmentSize || atEnd(in);
+        if (last && (n == 0 || n % AES128::BlockSize != 0))
+        {
+            throw std::runtime_error("Truncated or corrupt segmented file");
+        }
+        segmentIv(aes, iv, index, p->iv);
+
+        writer.add(std::move(p), [&aes, n, last](Piece &piece)
+                   {
+                       if (last)
+                       {
+                           piece.len = cbcDecrypt(piece.buf.data(), n, piece.buf.data(),
+                                                  aes, piece.iv);
+                       }
+                       else
+                       {
+                           cbcDecryptNoPad(piece.buf.data(), n, piece.buf.data(), aes, piece.iv);
+                           piece.len = n;
+                       } });
+        if (last)
+            break;
+    }
+    writer.finish();
+}
+
+void cbcDecryptParallel(const AES128 &aes, const uint8_t iv[16],
+                        std::istream &in, std::ostream &out, ThreadPool &pool,
+                        bool padding, std::size_t chunkSize)
+{
+    if (chunkSize == 0 || chunkSize % AES128::BlockSize != 0)
+    {
+        throw std::runtime_error("Chunk size must be a non-zero multiple of 16");
+    }
+
+    // IV của chunk tiếp theo = ciphertext block cuối của chunk trước
+    uint8_t prev[16];
+    std::memcpy(prev, iv, 16);
+
+    OrderedWriter writer(pool, out);
+    for (;;)
+    {
+        std::unique_ptr<Piece> p = writer.acquire(chunkSize);
+        std::size_t n = readFull(in, p->buf.data(), chunkSize);
+        bool last = n < chunkSize || atEnd(in);
+        if (n % AES128::BlockSize != 0)
+        {
+            throw std::runtime_error("Ciphertext size must be multiple of 16");
+        }
+        std::memcpy(p->iv, prev, 16);
+        if (n > 0)
+            std::memcpy(prev, p->buf.data() + n - 16, 16);
+
+        bool unpad = last && padding;
+        writer.add(std::move(p), [&aes, n, unpad](Piece &piece)
+                   {
+                       if (unpad)
+                       {
+                           piece.len = cbcDecrypt(piece.buf.data(), n, piece.buf.data(),
+                                                  aes, piece.iv);
+                       }
+                       else
+                       {
+                           cbcDecryptNoPad(piece.buf.data(), n, piece.buf.data(), aes, piece.iv);
+                           piece.len = n;
+                       } });
+        if (last)
+            break;
+    }
+    writer.finish();
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+
+#include "aes.h"
+#include "thread_pool.h"
+
+// ===== CBC đa luồng =====
+//
+// Định dạng segmented (aes_tool --threads): 1 chain CBC không chia được cho nhiều core
+// khi mã hoá, nên input được cắt thành các segment độc lập:
+//
+//   header 16 byte: "AES128SG" | segmentSize (uint32 little-endian) | 4 byte 0
+//   segment i: CBC của plaintext [i * segmentSize, (i + 1) * segmentSize),
+//              IV_i = AES_K(baseIV ^ be64(i) ở 8 byte cuối)
+//
+// Mọi segment trừ segment cuối dài đúng segmentSize và không padding.
+// Segment cuối là phần còn lại (có thể rỗng) + PKCS#7, nên dài 16..segmentSize byte.
+
+constexpr std::size_t SegmentHeaderSize = 16;
+constexpr uint32_t DefaultSegmentSize = 1024 * 1024;
+
+void writeSegmentHeader(uint8_t out[SegmentHeaderSize], uint32_t segmentSize);
+
+// false nếu không phải header segmented (sai magic);
+// ném std::runtime_error nếu đúng magic nhưng segmentSize không hợp lệ
+bool parseSegmentHeader(const uint8_t in[SegmentHeaderSize], uint32_t &segmentSize);
+
+// IV của segment index (mã hoá baseIV ^ index để IV không đoán trước được)
+void segmentIv(const AES128 &aes, const uint8_t baseIv[16], uint64_t index, uint8_t iv[16]);
+
+// Đọc toàn bộ in, ghi header + các segment ra out theo thứ tự.
+// segmentSize phải là bội số 16. Các segment được mã hoá song song trên pool.
+void cbcEncryptSegmented(const AES128 &aes, const uint8_t iv[16],
+                         std::istream &in, std::ostream &out,
+                         ThreadPool &pool, uint32_t segmentSize = DefaultSegmentSize);
+
+// Đọc header (ném lỗi nếu không phải file segmented) rồi giải mã song song
+void cbcDecryptSegmented(const AES128 &aes, const uint8_t iv[16],
+                         std::istream &in, std::ostream &out, ThreadPool &pool);
+
+// Giải mã 1 chain CBC thường (file của aes_tool enc / openssl) trên nhiều thread:
+// plaintext block i chỉ cần ciphertext block i và i-1, nên cắt ciphertext thành
+// chunk, mỗi chunk dùng block cuối của chunk trước làm IV.
+void cbcDecryptParallel(const AES128 &aes, const uint8_t iv[16],
+                        std::istream &in, std::ostream &out, ThreadPool &pool,
+                        bool padding = true, std::size_t chunkSize = DefaultSegmentSize);
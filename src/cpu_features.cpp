@@ -0,0 +1,109 @@
+#include "cpu_features.h"
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define CPU_FEATURES_X86 1
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+#ifdef CPU_FEATURES_X86
+
+static void cpuid(unsigned leaf, unsigned subleaf, unsigned regs[4])
+{
+#if defined(_MSC_VER)
+    int r[4];
+    __cpuidex(r, static_cast<int>(leaf), static_cast<int>(subleaf));
+    for (int i = 0; i < 4; ++i)
+        regs[i] = static_cast<unsigned>(r[i]);
+#else
+    __cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+// XCR0: OS có lưu/khôi phục thanh ghi YMM không (cần cho AVX2)
+static unsigned long long readXcr0()
+{
+#if defined(_MSC_VER)
+    return _xgetbv(0);
+#else
+    unsigned eax, edx;
+    __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    return (static_cast<unsigned long long>(edx) << 32) | eax;
+#endif
+}
+
+static CpuFeatures detect()
+{
+    CpuFeatures f;
+    unsigned r[4];
+
+    cpuid(0, 0, r);
+    unsigned maxLeaf = r[0];
+    if (maxLeaf < 1)
+        return f;
+
+    cpuid(1, 0, r);
+    const unsigned ecx = r[2];
+    const unsigned edx = r[3];
+    f.sse2 = (edx >> 26) & 1;
+    f.ssse3 = (ecx >> 9) & 1;
+    f.sse41 = (ecx >> 19) & 1;
+    f.aesni = (ecx >> 25) & 1;
+    f.pclmul = (ecx >> 1) & 1;
+
+    const bool osxsave = (ecx >> 27) & 1;
+    const bool avx = (ecx >> 28) & 1;
+    if (maxLeaf >= 7 && osxsave && avx && (readXcr0() & 0x6) == 0x6)
+    {
+        cpuid(7, 0, r);
+        f.avx2 = (r[1] >> 5) & 1;
+    }
+    return f;
+}
+
+std::string cpuBrandString()
+{
+    unsigned r[4];
+    cpuid(0x80000000u, 0, r);
+    if (r[0] < 0x80000004u)
+        return std::string();
+
+    char brand[49] = {};
+    for (unsigned leaf = 0; leaf < 3; ++leaf)
+    {
+        cpuid(0x80000002u + leaf, 0, r);
+        for (int i = 0; i < 4; ++i)
+        {
+            for (int b = 0; b < 4; ++b)
+                brand[leaf * 16 + i * 4 + b] = static_cast<char>((r[i] >> (8 * b)) & 0xff);
+        }
+    }
+    std::string s(brand);
+    // brand string được căn phải / thêm khoảng trắng ở cuối
+    s.erase(0, s.find_first_not_of(' '));
+    s.erase(s.find_last_not_of(' ') + 1);
+    return s;
+}
+
+#else
+
+static CpuFeatures detect()
+{
+    return CpuFeatures{};
+}
+
+std::string cpuBrandString()
+{
+    return std::string();
+}
+
+#endif
+
+const CpuFeatures &cpuFeatures()
+{
+    static const CpuFeatures features = detect();
+    return features;
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <string>
+
+// Phát hiện tính năng CPU lúc runtime (CPUID) để chọn backend
+struct CpuFeatures
+{
+    bool sse2 = false;
+    bool ssse3 = false;
+    bool sse41 = false;
+    bool aesni = false;  // AESENC/AESDEC/AESKEYGENASSIST/AESIMC
+    bool pclmul = false; // PCLMULQDQ
+    bool avx2 = false;
+};
+
+// Kết quả được cache sau lần gọi đầu tiên
+const CpuFeatures &cpuFeatures();
+
+// Tên CPU theo CPUID (leaf 0x80000002..4), rỗng nếu không phải x86 / không hỗ trợ
+std::string cpuBrandString();
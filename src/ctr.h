@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "aes.h"
+#include "thread_pool.h"
+
+// AES-128-CTR (NIST SP 800-38A, 6.5)
+// Counter block thứ i = iv + i (cộng 128-bit big-endian, tràn thì quay vòng).
+// Mã hoá và giải mã là cùng một phép XOR với keystream.
+
+// Xử lý len byte bắt đầu từ vị trí offset (byte) trong stream:
+// có thể seek tới bất kỳ byte nào mà không cần xử lý phần trước.
+// Keystream sinh theo lô AES128::BatchBlocks block (encryptBlocks).
+// in và out được phép trùng nhau.
+void ctrCrypt(const AES128 &aes, const uint8_t iv[16], uint64_t offset,
+              const uint8_t *in, uint8_t *out, std::size_t len);
+
+// Mỗi thread cần ít nhất chừng này byte, ít hơn thì chi phí giao việc lớn hơn phần việc
+constexpr std::size_t CtrMinPerThread = 64 * 1024;
+
+// Như ctrCrypt nhưng chia buffer thành tối đa pool.size() đoạn theo counter offset
+// (mỗi task tự tính counter bắt đầu của đoạn mình) và chờ pool chạy xong.
+// Buffer dưới 2 * CtrMinPerThread chạy trên thread hiện tại.
+void ctrCryptParallel(const AES128 &aes, const uint8_t iv[16], uint64_t offset,
+                      const uint8_t *in, uint8_t *out, std::size_t len,
+                      ThreadPool &pool);
+
+std::vector<uint8_t> ctrCrypt(const std::vector<uint8_t> &data,
+                              const uint8_t key[16],
+                              const uint8_t iv[16]);
+
+// CTR dạng stream, cùng giao diện update/final với CbcEncryptor/CbcDecryptor
+class CtrCipher
+{
+public:
+    CtrCipher(const uint8_t key[16], const uint8_t iv[16]);
+    CtrCipher(const AES128 &aes, const uint8_t iv[16]);
+
+    // Nhảy tới byte offset trong stream
+    void seek(uint64_t offset) { position = offset; }
+    uint64_t tell() const { return position; }
+
+    // Số thread cho mỗi lần update (mặc định 1, 0: mọi core). Pool tạo 1 lần ở đây và
+    // dùng lại cho mọi update. Mỗi update cần >= threads * CtrMinPerThread byte để chia hết
+    // cho các thread (xem parallelChunkSize).
+    void setThreads(unsigned n);
+
+    // Kích thước update để mọi thread đều có việc (0: không chạy đa luồng)
+    std::size_t parallelChunkSize() const { return pool ? pool->size() * CtrMinPerThread : 0; }
+
+    // out cần len byte (được trùng in). Trả về len.
+    std::size_t update(const uint8_t *in, std::size_t len, uint8_t *out);
+
+    // CTR không có padding: không ghi gì thêm
+    std::size_t final(uint8_t *) { return 0; }
+
+private:
+    AES128 aes;
+    uint8_t iv[16];
+    uint64_t position;
+    std::shared_ptr<ThreadPool> pool; // nullptr: 1 thread
+};
@@ -0,0 +1,59 @@
+#include "cycle_counter.h"
+
+#include <algorithm>
+#include <chrono>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define CYCLE_COUNTER_X86 1
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#endif
+
+bool cycleCounterAvailable()
+{
+#ifdef CYCLE_COUNTER_X86
+    return true;
+#else
+    return false;
+#endif
+}
+
+uint64_t readCycleCounter()
+{
+#ifdef CYCLE_COUNTER_X86
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+static double calibrate()
+{
+    if (!cycleCounterAvailable())
+        return 0.0;
+
+    using Clock = std::chrono::steady_clock;
+    // 5 lượt 20 ms, lấy median: 1 lượt bị preempt giữa 2 lần đọc không làm lệch kết quả
+    double ghz[5];
+    for (double &g : ghz)
+    {
+        auto t0 = Clock::now();
+        uint64_t c0 = readCycleCounter();
+        auto t1 = t0;
+        while (t1 - t0 < std::chrono::milliseconds(20))
+            t1 = Clock::now();
+        uint64_t c1 = readCycleCounter();
+        g = static_cast<double>(c1 - c0) / std::chrono::duration<double, std::nano>(t1 - t0).count();
+    }
+    std::sort(ghz, ghz + 5);
+    return ghz[2];
+}
+
+double cycleCounterGHz()
+{
+    static const double ghz = calibrate();
+    return ghz;
+}
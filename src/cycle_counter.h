@@ -0,0 +1,16 @@
+#pragma once
+
+#include <cstdint>
+
+// ===== Bộ đếm chu kỳ cho aes_perf =====
+// x86: rdtsc. TSC chạy ở tần số cố định (invariant TSC) nên đây là "reference cycles":
+// khi CPU turbo / hạ xung, số chu kỳ lõi thật khác đi theo tỉ lệ tần số.
+// Nền tảng khác: không có bộ đếm, cycleCounterAvailable() = false, readCycleCounter() = 0.
+
+bool cycleCounterAvailable();
+
+uint64_t readCycleCounter();
+
+// Số tick mỗi ns (= GHz), đo 1 lần so với steady_clock (~100 ms) rồi cache.
+// 0 nếu không có bộ đếm.
+double cycleCounterGHz();
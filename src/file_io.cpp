@@ -0,0 +1,299 @@
+#include "file_io.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <istream>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define FILE_IO_MMAP 1
+#include <sys/mman.h>
+#include <unistd.h>
+#else
+#include <io.h>
+#endif
+
+#ifndef O_BINARY
+#define O_BINARY 0
+#endif
+
+bool isRegularFile(const std::string &path)
+{
+    if (path == "-")
+        return false;
+    struct stat st;
+    return ::stat(path.c_str(), &st) == 0 && S_ISREG(st.st_mode);
+}
+
+bool sameFile(const std::string &a, const std::string &b)
+{
+    if (a == "-" || b == "-")
+        return false;
+    struct stat sa, sb;
+    if (::stat(a.c_str(), &sa) != 0 || ::stat(b.c_str(), &sb) != 0)
+        return false;
+    return sa.st_dev == sb.st_dev && sa.st_ino == sb.st_ino;
+}
+
+// Mỗi lần gọi read/write tối đa 1 GiB: Windows _read/_write nhận unsigned int,
+// POSIX cũng chỉ hứa tới SSIZE_MAX (Linux cắt ở ~2 GiB)
+const std::size_t MaxIoChunk = std::size_t(1) << 30;
+
+#if defined(FILE_IO_MMAP)
+typedef std::size_t IoLen;
+#else
+typedef unsigned IoLen;
+#endif
+
+static IoLen ioChunk(std::size_t len)
+{
+    return static_cast<IoLen>(std::min(len, MaxIoChunk));
+}
+
+std::size_t readSomeFd(int fd, uint8_t *data, std::size_t len, const std::string &errorMessage)
+{
+    for (;;)
+    {
+        auto n = ::read(fd, data, ioChunk(len));
+        if (n >= 0)
+            return static_cast<std::size_t>(n);
+        if (errno != EINTR)
+            throw std::runtime_error(errorMessage);
+    }
+}
+
+void writeAllFd(int fd, const uint8_t *data, std::size_t len, const std::string &errorMessage)
+{
+    while (len > 0)
+    {
+        auto n = ::write(fd, data, ioChunk(len));
+        if (n < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            throw std::runtime_error(errorMessage);
+        }
+        data += n;
+        len -= static_cast<std::size_t>(n);
+    }
+}
+
+std::size_t readFull(std::istream &in, uint8_t *buf, std::size_t n)
+{
+    std::size_t got = 0;
+    while (got < n && in)
+    {
+        in.read(reinterpret_cast<char *>(buf + got), static_cast<std::streamsize>(n - got));
+        got += static_cast<std::size_t>(in.gcount());
+    }
+    if (in.bad())
+        throw std::runtime_error("Error reading input");
+    return got;
+}
+
+// Đọc tới EOF, chunk lớn; sizeHint (từ fstat) để cấp phát 1 lần
+static void readAll(int fd, std::size_t sizeHint, std::vector<uint8_t> &out)
+{
+    const std::size_t chunk = 1024 * 1024;
+    out.resize(sizeHint > 0 ? sizeHint : chunk);
+    std::size_t used = 0;
+    for (;;)
+    {
+        if (used == out.size())
+            out.resize(out.size() * 2);
+        std::size_t n = readSomeFd(fd, out.data() + used, out.size() - used, "Error reading input");
+        if (n == 0)
+            break;
+        used += n;
+    }
+    out.resize(used);
+}
+
+// ===== InputFile =====
+
+InputFile::InputFile(const std::string &path)
+{
+    if (path == "-")
+    {
+        readAll(0, 0, buffer);
+        ptr = buffer.data();
+        len = buffer.size();
+        return;
+    }
+
+    int fd = ::open(path.c_str(), O_RDONLY | O_BINARY);
+    if (fd < 0)
+    {
+        throw std::runtime_error("Cannot open input file: " + path);
+    }
+
+    struct stat st;
+    std::size_t hint = 0;
+    if (::fstat(fd, &st) == 0 && S_ISREG(st.st_mode))
+        hint = static_cast<std::size_t>(st.st_size);
+
+#ifdef FILE_IO_MMAP
+    if (hint > 0)
+    {
+        void *p = ::mmap(nullptr, hint, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p != MAP_FAILED)
+        {
+            ::madvise(p, hint, MADV_SEQUENTIAL);
+            ::close(fd);
+            ptr = static_cast<const uint8_t *>(p);
+            len = hint;
+            mapped = true;
+            return;
+        }
+    }
+#endif
+
+    try
+    {
+        readAll(fd, hint, buffer);
+    }
+    catch (...)
+    {
+        ::close(fd);
+        throw;
+    }
+    ::close(fd);
+    ptr = buffer.data();
+    len = buffer.size();
+}
+
+InputFile::~InputFile()
+{
+#ifdef FILE_IO_MMAP
+    if (mapped)
+        ::munmap(const_cast<uint8_t *>(ptr), len);
+#endif
+}
+
+// ===== OutputFile =====
+
+// Cấp block thật cho fd[0..size); false nếu không cấp được
+static bool preallocate(int fd, std::size_t size)
+{
+#if defined(__linux__)
+    return ::posix_fallocate(fd, 0, static_cast<off_t>(size)) == 0;
+#else
+    (void)fd;
+    (void)size;
+    return false;
+#endif
+}
+
+OutputFile::OutputFile(const std::string &path, std::size_t capacity)
+    : path(path), cap(capacity)
+{
+    if (path == "-")
+    {
+        fd = 1; // stdout
+    }
+    else
+    {
+        fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_BINARY, 0644);
+        if (fd < 0)
+        {
+            throw std::runtime_error("Cannot open output file: " + path);
+        }
+    }
+
+#ifdef FILE_IO_MMAP
+    // file thường: cấp đủ block trên đĩa trước rồi ghi thẳng qua mmap. Chỉ ftruncate thì file
+    // thưa, hết chỗ giữa chừng là SIGBUS (không có exception, file dở dang không bị xoá), nên
+    // không cấp phát được (đĩa đầy, FS không hỗ trợ, không có posix_fallocate) thì ghi qua buffer
+    struct stat st;
+    if (capacity > 0 && path != "-" && ::fstat(fd, &st) == 0 && S_ISREG(st.st_mode) &&
+        preallocate(fd, capacity))
+    {
+        void *p = ::mmap(nullptr, capacity, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (p != MAP_FAILED)
+        {
+            ptr = static_cast<uint8_t *>(p);
+            mapped = true;
+            return;
+        }
+    }
+#endif
+
+    buffer.resize(capacity);
+    ptr = buffer.data();
+}
+
+void OutputFile::writeBuffer(std::size_t size)
+{
+    writeAllFd(fd, buffer.data(), size, "Error writing output");
+#ifdef FILE_IO_MMAP
+    // file đã được cấp theo capacity (có thể chỉ 1 phần) nhưng không mmap: cắt về đúng kích thước
+    struct stat st;
+    if (path != "-" && ::fstat(fd, &st) == 0 && S_ISREG(st.st_mode) &&
+        ::ftruncate(fd, static_cast<off_t>(size)) != 0)
+    {
+        throw std::runtime_error("Error writing output file: " + path);
+    }
+#endif
+}
+
+void OutputFile::commit(std::size_t size)
+{
+    if (committed)
+        return;
+    if (size > cap)
+    {
+        throw std::runtime_error("OutputFile::commit: size exceeds capacity");
+    }
+
+#ifdef FILE_IO_MMAP
+    if (mapped)
+    {
+        ::munmap(ptr, cap);
+        mapped = false;
+        ptr = nullptr;
+        if (::ftruncate(fd, static_cast<off_t>(size)) != 0)
+        {
+            throw std::runtime_error("Error writing output file: " + path);
+        }
+    }
+    else
+#endif
+    {
+        writeBuffer(size);
+    }
+
+    if (path != "-" && ::close(fd) != 0)
+    {
+        fd = -1;
+        throw std::runtime_error("Error writing output file: " + path);
+    }
+    fd = -1;
+    committed = true;
+}
+
+OutputFile::~OutputFile()
+{
+#ifdef FILE_IO_MMAP
+    if (mapped)
+        ::munmap(ptr, cap);
+#endif
+    if (path == "-")
+        return;
+    if (fd >= 0)
+        ::close(fd);
+    if (!committed)
+    {
+        // không để lại file output dở dang
+        std::remove(path.c_str());
+    }
+}
+
+std::vector<uint8_t> readWholeFile(const std::string &path)
+{
+    InputFile in(path);
+    return std::vector<uint8_t>(in.data(), in.data() + in.size());
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+// ===== I/O file không copy qua buffer trung gian =====
+// POSIX: mmap input, output là file đã ftruncate sẵn rồi mmap ghi trực tiếp.
+// Không mmap được (pipe, stdin "-", Windows, FS không hỗ trợ): đọc/ghi bằng buffer.
+
+// true nếu path là file thường (mmap được); "-" là stdin/stdout -> false
+bool isRegularFile(const std::string &path);
+
+// true nếu 2 path trỏ tới cùng 1 file đang tồn tại
+bool sameFile(const std::string &a, const std::string &b);
+
+// Toàn bộ nội dung input: mmap nếu là file thường, ngược lại đọc hết vào buffer
+class InputFile
+{
+public:
+    explicit InputFile(const std::string &path);
+    ~InputFile();
+
+    InputFile(const InputFile &) = delete;
+    InputFile &operator=(const InputFile &) = delete;
+
+    const uint8_t *data() const { return ptr; }
+    std::size_t size() const { return len; }
+    bool isMapped() const { return mapped; }
+
+private:
+    const uint8_t *ptr = nullptr;
+    std::size_t len = 0;
+    bool mapped = false;
+    std::vector<uint8_t> buffer; // fallback
+};
+
+// Output có kích thước tối đa biết trước (vd. plaintext + padding).
+// data() trỏ thẳng vào file (mmap) hoặc vào buffer fallback.
+// commit(n) giữ lại n byte đầu và đóng file; huỷ khi chưa commit thì xoá file dở dang.
+class OutputFile
+{
+public:
+    OutputFile(const std::string &path, std::size_t capacity);
+    ~OutputFile();
+
+    OutputFile(const OutputFile &) = delete;
+    OutputFile &operator=(const OutputFile &) = delete;
+
+    uint8_t *data() { return ptr; }
+    std::size_t capacity() const { return cap; }
+    bool isMapped() const { return mapped; }
+
+    void commit(std::size_t size);
+
+private:
+    std::string path;
+    uint8_t *ptr = nullptr;
+    std::size_t cap = 0;
+    bool mapped = false;
+    bool committed = false;
+    int fd = -1;
+    std::vector<uint8_t> buffer; // fallback: ghi 1 lần khi commit
+
+    void writeBuffer(std::size_t size);
+};
+
+// Đọc cả file vào vector (1 lần đọc theo kích thước file, không đọc từng ký tự)
+std::vector<uint8_t> readWholeFile(const std::string &path);
+
+// ===== read / write trên file descriptor, dùng chung cho các module I/O =====
+// Lặp lại khi EINTR; mỗi lần gọi tối đa 1 GiB (POSIX chỉ hứa tới SSIZE_MAX, Windows
+// _read/_write nhận unsigned int) nên buffer >= 4 GiB không bị cắt hay treo.
+// Lỗi: ném std::runtime_error(errorMessage).
+
+// 1 lần read: trả về số byte đọc được (có thể < len), 0 = EOF
+std::size_t readSomeFd(int fd, uint8_t *data, std::size_t len, const std::string &errorMessage);
+
+// Ghi hết len byte
+void writeAllFd(int fd, const uint8_t *data, std::size_t len, const std::string &errorMessage);
+
+// Đọc từ stream tới khi đủ n byte hoặc EOF; trả về số byte đọc được
+std::size_t readFull(std::istream &in, uint8_t *buf, std::size_t n);
@@ -0,0 +1,481 @@
+#include "gcm.h"
+#include "cpu_features.h"
+
+#include <cstring>
+#include <stdexcept>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define GCM_PCLMUL_COMPILED 1
+#include <emmintrin.h>
+#include <tmmintrin.h>
+#include <wmmintrin.h>
+#if defined(__GNUC__) || defined(__clang__)
+#define PCLMUL_TARGET __attribute__((target("pclmul,sse2,ssse3")))
+#else
+#define PCLMUL_TARGET
+#endif
+#endif
+
+static inline uint64_t load64be(const uint8_t *p)
+{
+    uint64_t v = 0;
+    for (int i = 0; i < 8; ++i)
+        v = (v << 8) | p[i];
+    return v;
+}
+
+static inline void store64be(uint8_t *p, uint64_t v)
+{
+    for (int i = 7; i >= 0; --i)
+    {
+        p[i] = static_cast<uint8_t>(v);
+        v >>= 8;
+    }
+}
+
+// ===== GHASH: bảng Shoup 4-bit =====
+
+// phần dư khi dịch phải 4 bit, đã nhân với đa thức rút gọn (0xE1 << 120)
+static const uint64_t last4[16] = {
+    0x0000, 0x1c20, 0x3840, 0x2460, 0x7080, 0x6ca0, 0x48c0, 0x54e0,
+    0xe100, 0xfd20, 0xd940, 0xc560, 0x9180, 0x8da0, 0xa9c0, 0xb5e0};
+
+#ifdef GCM_PCLMUL_COMPILED
+
+// Nhân trong GF(2^128) bằng PCLMULQDQ (Intel CLMUL white paper, Algorithm 5):
+// a, b đã đảo byte; kết quả cũng ở dạng đảo byte.
+PCLMUL_TARGET
+static __m128i gfmulPclmul(__m128i a, __m128i b)
+{
+    __m128i t3 = _mm_clmulepi64_si128(a, b, 0x00);
+    __m128i t4 = _mm_clmulepi64_si128(a, b, 0x10);
+    __m128i t5 = _mm_clmulepi64_si128(a, b, 0x01);
+    __m128i t6 = _mm_clmulepi64_si128(a, b, 0x11);
+
+    t4 = _mm_xor_si128(t4, t5);
+    t5 = _mm_slli_si128(t4, 8);
+    t4 = _mm_srli_si128(t4, 8);
+    t3 = _mm_xor_si128(t3, t5);
+    t6 = _mm_xor_si128(t6, t4);
+
+    // dịch trái 1 bit cả 256 bit (do quy ước bit đảo của GCM)
+    __m128i t7 = _mm_srli_epi32(t3, 31);
+    __m128i t8 = _mm_srli_epi32(t6, 31);
+    t3 = _mm_slli_epi32(t3, 1);
+    t6 = _mm_slli_epi32(t6, 1);
+    __m128i t9 = _mm_srli_si128(t7, 12);
+    t8 = _mm_slli_si128(t8, 4);
+    t7 = _mm_slli_si128(t7, 4);
+    t3 = _mm_or_si128(t3, t7);
+    t6 = _mm_or_si128(t6, t8);
+    t6 = _mm_or_si128(t6, t9);
+
+    // rút gọn modulo x^128 + x^7 + x^2 + x + 1
+    t7 = _mm_slli_epi32(t3, 31);
+    t8 = _mm_slli_epi32(t3, 30);
+    t9 = _mm_slli_epi32(t3, 25);
+    t7 = _mm_xor_si128(t7, t8);
+    t7 = _mm_xor_si128(t7, t9);
+    t8 = _mm_srli_si128(t7, 4);
+    t7 = _mm_slli_si128(t7, 12);
+    t3 = _mm_xor_si128(t3, t7);
+
+    __m128i t2 = _mm_srli_epi32(t3, 1);
+    t4 = _mm_srli_epi32(t3, 2);
+    t5 = _mm_srli_epi32(t3, 7);
+    t2 = _mm_xor_si128(t2, t4);
+    t2 = _mm_xor_si128(t2, t5);
+    t2 = _mm_xor_si128(t2, t8);
+    t3 = _mm_xor_si128(t3, t2);
+    return _mm_xor_si128(t6, t3);
+}
+
+PCLMUL_TARGET
+static void ghashPclmul(const uint8_t h[16], uint8_t x[16], const uint8_t *data, std::size_t nblocks)
+{
+    const __m128i bswap = _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+    __m128i hv = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(h)), bswap);
+    __m128i xv = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(x)), bswap);
+
+    for (std::size_t b = 0; b < nblocks; ++b, data += 16)
+    {
+        __m128i d = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(data)), bswap);
+        xv = gfmulPclmul(_mm_xor_si128(xv, d), hv);
+    }
+
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(x), _mm_shuffle_epi8(xv, bswap));
+}
+
+#endif
+
+GHash::GHash(const uint8_t h[16], bool allowPclmul)
+{
+    std::memcpy(H, h, 16);
+
+#ifdef GCM_PCLMUL_COMPILED
+    pclmul = allowPclmul && cpuFeatures().pclmul && cpuFeatures().ssse3;
+#else
+    (void)allowPclmul;
+    pclmul = false;
+#endif
+
+    // HL/HH[i] = i * H với i là nibble 4 bit (bit đảo theo quy ước GCM)
+    uint64_t vh = load64be(h);
+    uint64_t vl = load64be(h + 8);
+
+    HL[8] = vl;
+    HH[8] = vh;
+    HL[0] = 0;
+    HH[0] = 0;
+
+    for (int i = 4; i > 0; i >>= 1)
+    {
+        uint64_t t = (vl & 1) * 0xe1000000ULL;
+        vl = (vh << 63) | (vl >> 1);
+        vh = (vh >> 1) ^ (t << 32);
+        HL[i] = vl;
+        HH[i] = vh;
+    }
+
+    for (int i = 2; i <= 8; i *= 2)
+    {
+        vh = HH[i];
+        vl = HL[i];
+        for (int j = 1; j < i; ++j)
+        {
+            HH[i + j] = vh ^ HH[j];
+            HL[i + j] = vl ^ HL[j];
+        }
+    }
+}
+
+// x = x * H, xử lý từng nibble từ byte cuối lên
+void GHash::multiplyTable(uint8_t x[16]) const
+{
+    uint8_t lo = x[15] & 0x0f;
+    uint64_t zh = HH[lo];
+    uint64_t zl = HL[lo];
+
+    for (int i = 15; i >= 0; --i)
+    {
+        lo = x[i] & 0x0f;
+        uint8_t hi = (x[i] >> 4) & 0x0f;
+        uint8_t rem;
+
+        if (i != 15)
+        {
+            rem = static_cast<uint8_t>(zl & 0x0f);
+            zl = (zh << 60) | (zl >> 4);
+            zh = (zh >> 4) ^ (last4[rem] << 48);
+            zh ^= HH[lo];
+            zl ^= HL[lo];
+        }
+
+        rem = static_cast<uint8_t>(zl & 0x0f);
+        zl = (zh << 60) | (zl >> 4);
+        zh = (zh >> 4) ^ (last4[rem] << 48);
+        zh ^= HH[hi];
+        zl ^= HL[hi];
+    }
+
+    store64be(x, zh);
+    store64be(x + 8, zl);
+}
+
+void GHash::update(uint8_t x[16], const uint8_t *data, std::size_t nblocks) const
+{
+#ifdef GCM_PCLMUL_COMPILED
+    if (pclmul)
+    {
+        ghashPclmul(H, x, data, nblocks);
+        return;
+    }
+#endif
+
+    for (std::size_t b = 0; b < nblocks; ++b, data += 16)
+    {
+        for (int i = 0; i < 16; ++i)
+            x[i] ^= data[i];
+        multiplyTable(x);
+    }
+}
+
+// ===== GCM =====
+
+// inc32: chỉ tăng 32 bit cuối của counter block (SP 800-38D)
+static void inc32(uint8_t ctr[16])
+{
+    for (int i = 15; i >= 12; --i)
+    {
+        if (++ctr[i] != 0)
+            break;
+    }
+}
+
+// H = E_K(0^128). PCLMULQDQ chỉ dùng cùng backend AES-NI, để backend
+// phần mềm (byte/ttable) là đường đi thuần phần mềm hoàn toàn.
+static GHash makeGHash(const AES128 &aes)
+{
+    uint8_t zero[16] = {0};
+    uint8_t h[16];
+    aes.encryptBlock(zero, h);
+    return GHash(h, aes.backend() == AES128::Backend::AesNi);
+}
+
+// GHASH trên data, block cuối thiếu thì pad 0
+static void ghashPadded(const GHash &gh, uint8_t x[16], const uint8_t *data, std::size_t len)
+{
+    std::size_t full = len / 16;
+    gh.update(x, data, full);
+    if (len % 16 != 0)
+    {
+        uint8_t last[16] = {0};
+        std::memcpy(last, data + full * 16, len % 16);
+        gh.update(x, last, 1);
+    }
+}
+
+GcmStream::GcmStream(const AES128 &aes, const uint8_t *iv, std::size_t ivLen,
+                     const uint8_t *aad, std::size_t aadLen)
+    : aes(aes), ghash(makeGHash(aes)), aadLen(aadLen), textLen(0)
+{
+    if (ivLen == 0)
+    {
+        throw std::runtime_error("GCM IV must not be empty");
+    }
+
+    // J0: IV 96-bit -> IV || 0^31 || 1, ngược lại GHASH(IV || pad || len(IV))
+    if (ivLen == 12)
+    {
+        std::memcpy(j0, iv, 12);
+        j0[12] = 0;
+        j0[13] = 0;
+        j0[14] = 0;
+        j0[15] = 1;
+    }
+    else
+    {
+        std::memset(j0, 0, 16);
+        ghashPadded(ghash, j0, iv, ivLen);
+        uint8_t lenBlock[16] = {0};
+        store64be(lenBlock + 8, static_cast<uint64_t>(ivLen) * 8);
+        ghash.update(j0, lenBlock, 1);
+    }
+
+    std::memcpy(ctr, j0, 16);
+    inc32(ctr);
+
+    std::memset(x, 0, 16);
+    ghashPadded(ghash, x, aad, aadLen);
+}
+
+void GcmStream::encrypt(const uint8_t *in, std::size_t len, uint8_t *out)
+{
+    process(in, len, out, true);
+}
+
+void GcmStream::decrypt(const uint8_t *in, std::size_t len, uint8_t *out)
+{
+    process(in, len, out, false);
+}
+
+void GcmStream::process(const uint8_t *in, std::size_t len, uint8_t *out, bool encrypting)
+{
+    constexpr std::size_t lanes = AES128::BatchBlocks;
+
+    if (static_cast<uint64_t>(len) > GcmMaxTextBytes - textLen)
+    {
+        throw std::runtime_error("GCM input exceeds 2^32 - 2 blocks for one IV");
+    }
+
+    // 1) hoàn thành block dở dang từ lần gọi trước
+    std::size_t pos = static_cast<std::size_t>(textLen % 16);
+    if (pos != 0)
+    {
+        while (pos < 16 && len > 0)
+        {
+            uint8_t c = encrypting ? static_cast<uint8_t>(*in ^ ks[pos]) : *in;
+            *out = static_cast<uint8_t>(*in ^ ks[pos]);
+            partial[pos] = c;
+            ++pos;
+            ++in;
+            ++out;
+            --len;
+            ++textLen;
+        }
+        if (pos < 16)
+            return;
+        ghash.update(x, partial, 1);
+    }
+
+    // 2) các chunk đầy đủ: CTR lô BatchBlocks block rồi GHASH ngay chunk đó
+    uint8_t ctrs[lanes * 16];
+    uint8_t stream[lanes * 16];
+    while (len >= 16)
+    {
+        std::size_t nb = len / 16;
+        if (nb > lanes)
+            nb = lanes;
+
+        for (std::size_t b = 0; b < nb; ++b)
+        {
+            std::memcpy(ctrs + 16 * b, ctr, 16);
+            inc32(ctr);
+        }
+        aes.encryptBlocks(ctrs, stream, nb);
+
+        // giải mã: GHASH ciphertext trước khi out (có thể trùng in) bị ghi đè
+        if (!encrypting)
+            ghash.update(x, in, nb);
+        for (std::size_t i = 0; i < nb * 16; ++i)
+            out[i] = in[i] ^ stream[i];
+        if (encrypting)
+            ghash.update(x, out, nb);
+
+        in += nb * 16;
+        out += nb * 16;
+        len -= nb * 16;
+        textLen += nb * 16;
+    }
+
+    // 3) phần dư < 16 byte: sinh keystream 1 block, giữ lại cho lần sau
+    if (len > 0)
+    {
+        aes.encryptBlock(ctr, ks);
+        inc32(ctr);
+        for (std::size_t i = 0; i < len; ++i)
+        {
+            partial[i] = encrypting ? static_cast<uint8_t>(in[i] ^ ks[i]) : in[i];
+            out[i] = static_cast<uint8_t>(in[i] ^ ks[i]);
+        }
+        textLen += len;
+    }
+}
+
+void GcmStream::tag(uint8_t out[16])
+{
+    std::size_t pos = static_cast<std::size_t>(textLen % 16);
+    if (pos != 0)
+    {
+        std::memset(partial + pos, 0, 16 - pos);
+        ghash.update(x, partial, 1);
+    }
+
+    uint8_t lenBlock[16];
+    store64be(lenBlock, aadLen * 8);
+    store64be(lenBlock + 8, textLen * 8);
+    ghash.update(x, lenBlock, 1);
+
+    uint8_t ekj0[16];
+    aes.encryptBlock(j0, ekj0);
+    for (int i = 0; i < 16; ++i)
+        out[i] = x[i] ^ ekj0[i];
+}
+
+// ===== Encryptor / Decryptor =====
+
+GcmEncryptor::GcmEncryptor(const AES128 &aes, const uint8_t *iv, std::size_t ivLen,
+                           const uint8_t *aad, std::size_t aadLen)
+    : stream(aes, iv, ivLen, aad, aadLen)
+{
+}
+
+std::size_t GcmEncryptor::update(const uint8_t *in, std::size_t len, uint8_t *out)
+{
+    stream.encrypt(in, len, out);
+    return len;
+}
+
+std::size_t GcmEncryptor::final(uint8_t *out)
+{
+    stream.tag(out);
+    return GcmTagSize;
+}
+
+GcmDecryptor::GcmDecryptor(const AES128 &aes, const uint8_t *iv, std::size_t ivLen,
+                           const uint8_t *aad, std::size_t aadLen)
+    : stream(aes, iv, ivLen, aad, aadLen), heldLen(0)
+{
+}
+
+std::size_t GcmDecryptor::update(const uint8_t *in, std::size_t len, uint8_t *out)
+{
+    // luôn giữ lại 16 byte cuối cùng (có thể là tag)
+    std::size_t total = heldLen + len;
+    if (total <= GcmTagSize)
+    {
+        std::memcpy(held + heldLen, in, len);
+        heldLen = total;
+        return 0;
+    }
+
+    std::size_t release = total - GcmTagSize;
+    std::size_t written = 0;
+
+    // phần nhả ra lấy trước từ held, sau đó từ in
+    std::size_t fromHeld = release < heldLen ? release : heldLen;
+    stream.decrypt(held, fromHeld, out);
+    written += fromHeld;
+
+    std::size_t fromIn = release - fromHeld;
+    stream.decrypt(in, fromIn, out + written);
+    written += fromIn;
+
+    // held mới = phần còn lại của held + đuôi của in
+    uint8_t next[GcmTagSize];
+    std::size_t keepHeld = heldLen - fromHeld;
+    std::memcpy(next, held + fromHeld, keepHeld);
+    std::memcpy(next + keepHeld, in + fromIn, len - fromIn);
+    std::memcpy(held, next, GcmTagSize);
+    heldLen = GcmTagSize;
+
+    return written;
+}
+
+std::size_t GcmDecryptor::final(uint8_t *)
+{
+    if (heldLen != GcmTagSize)
+    {
+        throw std::runtime_error("GCM input too short (missing tag)");
+    }
+
+    uint8_t expected[GcmTagSize];
+    stream.tag(expected);
+
+    // so sánh không phụ thuộc thời gian
+    uint8_t diff = 0;
+    for (std::size_t i = 0; i < GcmTagSize; ++i)
+        diff |= static_cast<uint8_t>(expected[i] ^ held[i]);
+    if (diff != 0)
+    {
+        throw std::runtime_error("GCM authentication failed (tag mismatch)");
+    }
+    return 0;
+}
+
+// ===== One-shot =====
+
+std::vector<uint8_t> gcmEncrypt(const std::vector<uint8_t> &plaintext,
+                                const uint8_t key[16],
+                                const std::vector<uint8_t> &iv,
+                                const std::vector<uint8_t> &aad)
+{
+    GcmEncryptor enc(AES128(key), iv.data(), iv.size(), aad.data(), aad.size());
+    std::vector<uint8_t> out(plaintext.size() + GcmTagSize);
+    std::size_t n = enc.update(plaintext.data(), plaintext.size(), out.data());
+    enc.final(out.data() + n);
+    return out;
+}
+
+std::vector<uint8_t> gcmDecrypt(const std::vector<uint8_t> &input,
+                                const uint8_t key[16],
+                                const std::vector<uint8_t> &iv,
+                                const std::vector<uint8_t> &aad)
+{
+    GcmDecryptor dec(AES128(key), iv.data(), iv.size(), aad.data(), aad.size());
+    std::vector<uint8_t> out(input.size());
+    std::size_t n = dec.update(input.data(), input.size(), out.data());
+    dec.final(nullptr);
+    out.resize(n);
+    return out;
+}
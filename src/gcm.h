@@ -0,0 +1,113 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "aes.h"
+
+// AES-128-GCM (NIST SP 800-38D): CTR để mã hoá + GHASH để xác thực.
+// Output của gcmEncrypt / GcmEncryptor: ciphertext || tag (16 byte).
+
+constexpr std::size_t GcmTagSize = 16;
+
+// Giới hạn plaintext của 1 IV (SP 800-38D): 2^32 - 2 block. Counter chỉ có 32 bit, vượt quá thì
+// keystream lặp lại và tới block E(J0) dùng để che tag -> mất cả bí mật lẫn xác thực.
+constexpr uint64_t GcmMaxTextBytes = ((uint64_t(1) << 32) - 2) * 16;
+
+// GHASH với H cố định.
+// Mặc định dùng bảng Shoup 4-bit (16 phần tử 128-bit); nếu CPU có
+// PCLMULQDQ thì nhân bằng carry-less multiply.
+class GHash
+{
+public:
+    explicit GHash(const uint8_t h[16], bool allowPclmul = true);
+
+    // Với mỗi block 16 byte: X = (X ^ block) * H
+    void update(uint8_t x[16], const uint8_t *data, std::size_t nblocks) const;
+
+    bool usesPclmul() const { return pclmul; }
+
+private:
+    uint8_t H[16];
+    uint64_t HL[16]; // bảng Shoup: i * H (nửa thấp)
+    uint64_t HH[16]; // (nửa cao)
+    bool pclmul;
+
+    void multiplyTable(uint8_t x[16]) const;
+};
+
+// Lõi GCM dạng stream: CTR + GHASH xen kẽ trong một lượt qua mỗi chunk
+// (mã hoá BatchBlocks block rồi GHASH ngay khi dữ liệu còn trong L1).
+// GHASH dùng PCLMULQDQ khi aes là backend AesNi và CPU hỗ trợ.
+class GcmStream
+{
+public:
+    GcmStream(const AES128 &aes, const uint8_t *iv, std::size_t ivLen,
+              const uint8_t *aad, std::size_t aadLen);
+
+    // in và out được phép trùng nhau. Tổng dữ liệu vượt GcmMaxTextBytes: ném
+    // std::runtime_error trước khi sinh keystream
+    void encrypt(const uint8_t *in, std::size_t len, uint8_t *out);
+    void decrypt(const uint8_t *in, std::size_t len, uint8_t *out);
+
+    // Tag trên toàn bộ dữ liệu đã xử lý (gọi 1 lần ở cuối)
+    void tag(uint8_t out[16]);
+
+    bool usesPclmul() const { return ghash.usesPclmul(); }
+
+private:
+    AES128 aes;
+    GHash ghash;
+    uint8_t j0[16];      // counter block đầu, dùng cho tag
+    uint8_t ctr[16];     // counter block kế tiếp
+    uint8_t ks[16];      // keystream của block đang dở
+    uint8_t x[16];       // trạng thái GHASH
+    uint8_t partial[16]; // ciphertext của block đang dở (chờ GHASH)
+    uint64_t aadLen;
+    uint64_t textLen;
+
+    void process(const uint8_t *in, std::size_t len, uint8_t *out, bool encrypting);
+};
+
+// Cùng giao diện update/final với CbcEncryptor: final() ghi tag 16 byte
+class GcmEncryptor
+{
+public:
+    GcmEncryptor(const AES128 &aes, const uint8_t *iv, std::size_t ivLen,
+                 const uint8_t *aad = nullptr, std::size_t aadLen = 0);
+
+    std::size_t update(const uint8_t *in, std::size_t len, uint8_t *out);
+    std::size_t final(uint8_t *out);
+
+private:
+    GcmStream stream;
+};
+
+// Input là ciphertext || tag: 16 byte cuối luôn được giữ lại cho final().
+// final() ném std::runtime_error nếu tag sai. out không được chồng lên in.
+class GcmDecryptor
+{
+public:
+    GcmDecryptor(const AES128 &aes, const uint8_t *iv, std::size_t ivLen,
+                 const uint8_t *aad = nullptr, std::size_t aadLen = 0);
+
+    // out cần ít nhất len byte
+    std::size_t update(const uint8_t *in, std::size_t len, uint8_t *out);
+    std::size_t final(uint8_t *out);
+
+private:
+    GcmStream stream;
+    uint8_t held[GcmTagSize];
+    std::size_t heldLen;
+};
+
+// One-shot: trả về ciphertext || tag
+std::vector<uint8_t> gcmEncrypt(const std::vector<uint8_t> &plaintext,
+                                const uint8_t key[16],
+                                const std::vector<uint8_t> &iv,
+                                const std::vector<uint8_t> &aad = {});
+
+// input = ciphertext || tag; ném std::runtime_error nếu tag sai
+std::vector<uint8_t> gcmDecrypt(const std::vector<uint8_t> &input,
+                                const uint8_t key[16],
+                                const std::vector<uint8_t> &iv,
+                                const std::vector<uint8_t> &aad = {});
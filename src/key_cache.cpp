@@ -0,0 +1,60 @@
+#include "key_cache.h"
+
+#include <cstring>
+
+KeyScheduleCache::KeyScheduleCache(std::size_t capacity) : capacity(capacity)
+{
+}
+
+std::shared_ptr<const AES128> KeyScheduleCache::get(const uint8_t key[16])
+{
+    Key k;
+    std::memcpy(k.data(), key, 16);
+
+    {
+        std::lock_guard<std::mutex> lock(m);
+        auto it = index.find(k);
+        if (it != index.end())
+        {
+            ++hits;
+            lru.splice(lru.begin(), lru, it->second);
+            return it->second->second;
+        }
+        ++misses;
+    }
+
+    // mở rộng khoá ngoài lock: các thread dùng key khác không phải chờ
+    auto aes = std::make_shared<const AES128>(key);
+
+    std::lock_guard<std::mutex> lock(m);
+    auto it = index.find(k);
+    if (it != index.end())
+        return it->second->second; // thread khác vừa thêm cùng key
+
+    lru.emplace_front(k, aes);
+    index[k] = lru.begin();
+    if (capacity > 0 && lru.size() > capacity)
+    {
+        index.erase(lru.back().first);
+        lru.pop_back();
+    }
+    return aes;
+}
+
+std::size_t KeyScheduleCache::size() const
+{
+    std::lock_guard<std::mutex> lock(m);
+    return lru.size();
+}
+
+std::size_t KeyScheduleCache::expanded() const
+{
+    std::lock_guard<std::mutex> lock(m);
+    return misses;
+}
+
+std::size_t KeyScheduleCache::reused() const
+{
+    std::lock_guard<std::mutex> lock(m);
+    return hits;
+}
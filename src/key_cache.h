@@ -0,0 +1,40 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <utility>
+
+#include "aes.h"
+
+// ===== Cache key schedule theo key =====
+// Request / job cùng key dùng lại AES128 đã mở rộng khoá (kể cả decrypt schedule).
+// capacity > 0: giữ tối đa capacity key, bỏ key dùng lâu nhất (LRU).
+// An toàn khi gọi từ nhiều thread; mở rộng khoá chạy ngoài lock.
+class KeyScheduleCache
+{
+public:
+    // capacity = 0: không giới hạn
+    explicit KeyScheduleCache(std::size_t capacity = 0);
+
+    std::shared_ptr<const AES128> get(const uint8_t key[16]);
+
+    std::size_t size() const;
+    std::size_t expanded() const; // số lần phải mở rộng khoá (miss)
+    std::size_t reused() const;   // số lần dùng lại (hit)
+
+private:
+    using Key = std::array<uint8_t, 16>;
+    using Entry = std::pair<Key, std::shared_ptr<const AES128>>;
+
+    mutable std::mutex m;
+    std::size_t capacity;
+    std::list<Entry> lru; // đầu list = mới dùng nhất
+    std::map<Key, std::list<Entry>::iterator> index;
+    std::size_t misses = 0;
+    std::size_t hits = 0;
+};
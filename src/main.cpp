@@ -1,36 +1,232 @@
 #include <iostream>
+#include <algorithm>
 #include <fstream>
+#include <sstream>
 #include <vector>
 #include <string>
 #include <cctype>
+#include <cstdio>
+#include <cstdlib>
 #include <stdexcept>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <thread>
 
 #include "cbc.h"
+#include "ctr.h"
+#include "gcm.h"
+#include "cbc_parallel.h"
+#include "file_io.h"
+#include "pipeline.h"
+#include "async_io.h"
+#include "batch.h"
+#include "key_cache.h"
+#include "server.h"
 
 // ========== I/O tiện ích ==========
 
-std::vector<uint8_t> readFileBinary(const std::string &path)
+// Mở input/output ("-" = stdin/stdout) rồi chạy body(in, out).
+// Lỗi giữa chừng: xoá file output dở dang rồi ném lại.
+template <typename Body>
+void processFile(const std::string &inPath, const std::string &outPath, Body body)
 {
-    std::ifstream ifs(path, std::ios::binary);
-    if (!ifs)
+    std::ifstream ifs;
+    std::istream *in = &std::cin;
+    if (inPath != "-")
     {
-        throw std::runtime_error("Cannot open input file: " + path);
+        ifs.open(inPath, std::ios::binary);
+        if (!ifs)
+        {
+            throw std::runtime_error("Cannot open input file: " + inPath);
+        }
+        in = &ifs;
+    }
+    std::ofstream ofs;
+    std::ostream *out = &std::cout;
+    if (outPath != "-")
+    {
+        ofs.open(outPath, std::ios::binary);
+        if (!ofs)
+        {
+            throw std::runtime_error("Cannot open output file: " + outPath);
+        }
+        out = &ofs;
+    }
+
+    try
+    {
+        body(*in, *out);
+
+        out->flush();
+        if (!*out)
+        {
+            throw std::runtime_error("Error writing output file: " + outPath);
+        }
+    }
+    catch (...)
+    {
+        // không để lại file output dở dang
+        if (outPath != "-")
+        {
+            ofs.close();
+            std::remove(outPath.c_str());
+        }
+        throw;
+    }
+}
+
+// Mã hoá/giải mã theo chunk cố định (CbcEncryptor/CbcDecryptor):
+// bộ nhớ dùng không phụ thuộc kích thước file
+const std::size_t StreamChunkSize = 64 * 1024;
+
+template <typename Cipher>
+void streamCipherFile(Cipher &cipher, const std::string &inPath, const std::string &outPath,
+                      std::size_t chunkSize = StreamChunkSize)
+{
+    processFile(inPath, outPath, [&](std::istream &ifs, std::ostream &ofs)
+                {
+                    std::vector<uint8_t> inBuf(chunkSize);
+                    std::vector<uint8_t> outBuf(chunkSize + 16);
+
+                    while (ifs)
+                    {
+                        ifs.read(reinterpret_cast<char *>(inBuf.data()),
+                                 static_cast<std::streamsize>(inBuf.size()));
+                        std::streamsize got = ifs.gcount();
+                        if (got <= 0)
+                            break;
+
+                        std::size_t n = cipher.update(inBuf.data(), static_cast<std::size_t>(got), outBuf.data());
+                        ofs.write(reinterpret_cast<const char *>(outBuf.data()), static_cast<std::streamsize>(n));
+                    }
+                    if (ifs.bad())
+                    {
+                        throw std::runtime_error("Error reading input file: " + inPath);
+                    }
+
+                    std::size_t n = cipher.final(outBuf.data());
+                    ofs.write(reinterpret_cast<const char *>(outBuf.data()), static_cast<std::streamsize>(n)); });
+}
+
+// File thường: input mmap, output là file ftruncate sẵn (len + 16) rồi mmap;
+// cipher đọc/ghi thẳng trên 2 vùng nhớ đó, không qua buffer trung gian.
+template <typename Cipher>
+void mappedCipherFile(Cipher &cipher, const std::string &inPath, const std::string &outPath)
+{
+    InputFile in(inPath);
+    OutputFile out(outPath, in.size() + AES128::BlockSize); // đủ cho padding / tag
+    std::size_t n = cipher.update(in.data(), in.size(), out.data());
+    n += cipher.final(out.data() + n);
+    out.commit(n); // lỗi trước đây (vd. tag GCM sai): OutputFile tự xoá file
+}
+
+// --pipeline: thread đọc, thread mã hoá, thread ghi chạy chồng lên nhau
+template <typename Cipher>
+PipelineStats pipelineCipherFile(Cipher &cipher, const std::string &inPath, const std::string &outPath)
+{
+    PipelineStats stats;
+    processFile(inPath, outPath, [&](std::istream &ifs, std::ostream &ofs)
+                { stats = runPipeline(cipher, ifs, ofs); });
+    return stats;
+}
+
+// Cách đọc/ghi file do dòng lệnh chọn
+struct FileIoOptions
+{
+    bool pipeline = false;
+    PipelineStats stats; // kết quả của --pipeline
+
+    std::size_t streamChunk = StreamChunkSize; // chunk đọc khi input là pipe / stdin
+
+    bool bulk = false; // nhiều cặp --in/--out hoặc --io: cipherFilesBulk
+    BulkIoOptions bulkOptions;
+    BulkIoResult bulkResult;
+};
+
+// mmap khi input là file thường và output không phải stdout,
+// ngược lại (pipe, stdin) đọc/ghi theo chunk
+template <typename Cipher>
+void cipherFile(Cipher &cipher, const std::string &inPath, const std::string &outPath,
+                FileIoOptions &io)
+{
+    if (io.pipeline)
+        io.stats = pipelineCipherFile(cipher, inPath, outPath);
+    else if (isRegularFile(inPath) && outPath != "-")
+        mappedCipherFile(cipher, inPath, outPath);
+    else
+        streamCipherFile(cipher, inPath, outPath, io.streamChunk);
+}
+
+// 1 file, hoặc cả danh sách qua cipherFilesBulk (io_uring / blocking).
+// makeCipher() trả về std::shared_ptr tới cipher mới: mỗi file 1 chain riêng.
+template <typename MakeCipher>
+void cipherFiles(MakeCipher makeCipher, const std::vector<BulkFileJob> &jobs, FileIoOptions &io)
+{
+    if (io.bulk)
+    {
+        io.bulkResult = cipherFilesBulk(jobs, [&]()
+                                        { return makePipelineCipher(makeCipher()); },
+                                        io.bulkOptions);
+        return;
     }
-    std::vector<uint8_t> data(
-        (std::istreambuf_iterator<char>(ifs)),
-        std::istreambuf_iterator<char>());
-    return data;
+    auto cipher = makeCipher();
+    cipherFile(*cipher, jobs[0].inPath, jobs[0].outPath, io);
+}
+
+// --stats: thời gian làm việc / chờ của từng tầng pipeline
+void printPipelineStats(std::ostream &os, const PipelineStats &st)
+{
+    auto ms = [](double sec)
+    { return sec * 1000.0; };
+    double mb = static_cast<double>(st.bytesIn) / (1024.0 * 1024.0);
+
+    os << "Pipeline stats (" << st.buffers << " buffers x " << st.chunkSize / 1024 << " KB):\n";
+    os << "  reader : busy " << ms(st.readBusy) << " ms, stalled " << ms(st.readStall)
+       << " ms (waiting for a free buffer)\n";
+    os << "  cipher : busy " << ms(st.cipherBusy) << " ms, stalled " << ms(st.cipherStall)
+       << " ms (waiting for input)\n";
+    os << "  writer : busy " << ms(st.writeBusy) << " ms, stalled " << ms(st.writeStall)
+       << " ms (waiting for cipher output)\n";
+    os << "  total  : " << ms(st.total) << " ms, " << st.bytesIn << " bytes in, "
+       << st.bytesOut << " bytes out";
+    if (st.total > 0)
+        os << " (" << mb / st.total << " MB/s)";
+    os << "\n";
 }
 
-void writeFileBinary(const std::string &path, const std::vector<uint8_t> &data)
+// --threads: enc ghi file segmented; dec nhận cả file segmented lẫn CBC 1 chain
+// (tự nhận biết qua magic ở header)
+void parallelCbcFile(const std::string &mode, const AES128 &aes, const uint8_t iv[16],
+                     bool padding, unsigned threads, uint32_t segmentSize,
+                     const std::string &inPath, const std::string &outPath)
 {
-    std::ofstream ofs(path, std::ios::binary);
-    if (!ofs)
+    if (mode == "dec" && inPath == "-")
     {
-        throw std::runtime_error("Cannot open output file: " + path);
+        throw std::runtime_error("dec --threads needs a seekable input file (not stdin)");
     }
-    ofs.write(reinterpret_cast<const char *>(data.data()),
-              static_cast<std::streamsize>(data.size()));
+    ThreadPool pool(threads);
+
+    processFile(inPath, outPath, [&](std::istream &ifs, std::ostream &ofs)
+                {
+                    if (mode == "enc")
+                    {
+                        cbcEncryptSegmented(aes, iv, ifs, ofs, pool, segmentSize);
+                        return;
+                    }
+
+                    uint8_t header[SegmentHeaderSize];
+                    ifs.read(reinterpret_cast<char *>(header), SegmentHeaderSize);
+                    uint32_t size = 0;
+                    bool segmented = ifs.gcount() == static_cast<std::streamsize>(SegmentHeaderSize) &&
+                                     parseSegmentHeader(header, size);
+                    ifs.clear();
+                    ifs.seekg(0);
+
+                    if (segmented)
+                        cbcDecryptSegmented(aes, iv, ifs, ofs, pool);
+                    else
+                        cbcDecryptParallel(aes, iv, ifs, ofs, pool, padding); });
 }
 
 // ========== xử lý hex ==========
@@ -102,9 +298,42 @@ void printUsage()
 {
     std::cout
         << "Usage:\n"
-        << "  aes_tool enc --in <input> --out <output> --key-hex <32 hex> --iv-hex <32 hex> [--no-pad]\n"
-        << "  aes_tool dec --in <input> --out <output> --key-hex <32 hex> --iv-hex <32 hex> [--no-pad]\n"
+        << "  aes_tool enc --in <input> --out <output> --key-hex <32 hex> --iv-hex <hex> [--mode cbc|ctr|gcm] [--no-pad] [--aad-hex <hex>] [--backend <b>] [--threads N [--segment-size <bytes>] | --pipeline [--stats] | --io <io>]\n"
+        << "  aes_tool dec --in <input> --out <output> --key-hex <32 hex> --iv-hex <hex> [--mode cbc|ctr|gcm] [--no-pad] [--aad-hex <hex>] [--backend <b>] [--threads N | --pipeline [--stats] | --io <io>]\n"
+        << "  aes_tool batch --jobs <file.jsonl> [--threads N] [--backend <b>]\n"
+        << "  aes_tool serve --socket <path> [--threads N] [--key-cache N] [--backend <b>]\n"
+        << "  aes_tool loadgen --socket <path> [--connections C] [--requests N] [--size <bytes>] [--mode cbc|cbc-nopad|ctr|gcm]\n"
         << "  aes_tool selftest\n"
+        << "\n  --mode cbc|ctr|gcm                 cipher mode (default: cbc + PKCS#7; ctr: iv = initial counter block;\n"
+        << "                                     gcm: iv any length, 24 hex recommended, output = ciphertext || 16-byte tag)\n"
+        << "  --aad-hex <hex>                    additional authenticated data (gcm only)\n"
+        << "  --backend auto|byte|ttable|aesni|bitslice\n"
+        << "                                     AES engine (default: auto = aesni if CPU supports it, else bitslice)\n"
+        << "  --threads N                        cbc / ctr, N = 0: all cores. cbc: enc writes the segmented format\n"
+        << "                                     (independent CBC segments, IV per segment); dec reads segmented\n"
+        << "                                     files and also decrypts plain CBC files in parallel.\n"
+        << "                                     ctr: each chunk is split across threads by counter offset\n"
+        << "                                     (output unchanged)\n"
+        << "  --segment-size <bytes>             segment size for enc --threads (multiple of 16, default 1048576)\n"
+        << "  --pipeline                         stream through reader / cipher / writer threads (1 MB buffers)\n"
+        << "                                     so file I/O overlaps with encryption; works with every mode\n"
+        << "  --stats                            with --pipeline: print busy / stall time of each stage\n"
+        << "  --io auto|blocking|uring           bulk file I/O: uring keeps many reads / writes in flight (Linux),\n"
+        << "                                     blocking reads and writes one file per worker thread.\n"
+        << "                                     Repeat --in/--out to process several files (cbc only)\n"
+        << "\n  batch: one JSON object per line, e.g.\n"
+        << "    {\"op\": \"enc\", \"in\": \"a.bin\", \"out\": \"a.enc\", \"key\": \"<32 hex>\", \"iv\": \"<hex>\"}\n"
+        << "    optional: \"mode\": \"cbc|ctr|gcm\", \"aad\": \"<hex>\", \"pad\": false, \"id\": \"<name>\".\n"
+        << "    Jobs run on N threads (0 = all cores); key schedules are cached per key.\n"
+        << "    Prints one result line per job and a summary; exit code 1 if any job failed.\n"
+        << "\n  serve: persistent server on a Unix socket (Linux). Each request is a binary frame\n"
+        << "    (44-byte header: length, op, mode, id, key, iv; then the payload), answered with\n"
+        << "    a 12-byte header + output. Expanded key schedules are kept in an LRU of N keys\n"
+        << "    (--key-cache, default 1024). Stops on Ctrl-C / SIGTERM and prints statistics.\n"
+        << "  loadgen: C connections send N enc requests of <bytes> each, check every response\n"
+        << "    and print throughput and p50 / p90 / p99 / max latency.\n"
+        << "\n  Regular input files are memory-mapped and the output is written through a\n"
+        << "  preallocated mapping. --in - / --out - use stdin / stdout (buffered streaming).\n"
         << "\nExamples:\n"
         << "  aes_tool enc --in plain.bin --out cipher.bin \\\n"
         << "      --key-hex 00112233445566778899aabbccddeeff \\\n"
@@ -115,7 +344,7 @@ void printUsage()
 // ========== SELFTESTS ==========
 
 // FIPS-197 AES-128 ECB test vector (Appendix C.1)
-bool selftest_fips197()
+bool selftest_fips197(AES128::Backend backend)
 {
     std::string keyHex =
         "000102030405060708090A0B0C0D0E0F";
@@ -131,7 +360,7 @@ bool selftest_fips197()
     uint8_t key[16];
     std::copy(keyBytes.begin(), keyBytes.end(), key);
 
-    AES128 aes(key);
+    AES128 aes(key, backend);
 
     uint8_t out[16];
     aes.encryptBlock(ptBytes.data(), out);
@@ -208,140 +437,1198 @@ bool selftest_sp800_38a_cbc()
     return true;
 }
 
-bool runSelfTests()
+// encryptBlocks/decryptBlocks (xen kẽ 4-8 block) phải khớp với từng block đơn lẻ
+bool selftest_parallel_blocks(AES128::Backend backend)
 {
-    bool ok1 = selftest_fips197();
-    bool ok2 = selftest_sp800_38a_cbc();
+    const std::size_t nblocks = 2 * AES128::ParallelBlocks + 3; // có phần dư
+    uint8_t key[16];
+    for (int i = 0; i < 16; ++i)
+        key[i] = static_cast<uint8_t>(0xA0 + i);
 
-    if (ok1 && ok2)
+    std::vector<uint8_t> pt(nblocks * 16);
+    for (std::size_t i = 0; i < pt.size(); ++i)
+        pt[i] = static_cast<uint8_t>(i * 7 + 3);
+
+    AES128 aes(key, backend);
+
+    std::vector<uint8_t> ctRef(pt.size());
+    for (std::size_t b = 0; b < nblocks; ++b)
+        aes.encryptBlock(pt.data() + 16 * b, ctRef.data() + 16 * b);
+
+    std::vector<uint8_t> ct(pt.size());
+    aes.encryptBlocks(pt.data(), ct.data(), nblocks);
+    if (!bytesEqual(ct, ctRef))
     {
-        std::cout << "All self-tests PASSED.\n";
-        return true;
+        std::cerr << "[Parallel] encryptBlocks mismatch!\n";
+        return false;
     }
-    else
+
+    // in-place
+    std::vector<uint8_t> buf = ct;
+    aes.decryptBlocks(buf.data(), buf.data(), nblocks);
+    if (!bytesEqual(buf, pt))
     {
-        std::cout << "Self-tests FAILED.\n";
+        std::cerr << "[Parallel] decryptBlocks mismatch!\n";
         return false;
     }
-}
 
-// ========== main ==========
+    std::cout << "[Parallel] " << nblocks << "-block ECB batch test: OK\n";
+    return true;
+}
 
-int main(int argc, char *argv[])
+// cbcEncryptBatch (multi-buffer) phải khớp cbcEncrypt cho từng job,
+// kể cả khi các job dài ngắn khác nhau
+bool selftest_cbc_batch()
 {
-    if (argc < 2)
+    std::vector<CbcJob> jobs(2 * AES128::ParallelBlocks + 1);
+    std::vector<AES128> prebuilt;
+    prebuilt.reserve(jobs.size());
+    for (std::size_t j = 0; j < jobs.size(); ++j)
     {
-        printUsage();
-        return 1;
+        for (int i = 0; i < 16; ++i)
+        {
+            jobs[j].key[i] = static_cast<uint8_t>(j * 31 + i);
+            jobs[j].iv[i] = static_cast<uint8_t>(j + i * 5);
+        }
+        // job lẻ dùng key schedule dựng sẵn
+        if (j % 2 == 1)
+        {
+            prebuilt.emplace_back(jobs[j].key);
+            jobs[j].schedule = &prebuilt.back();
+        }
+        jobs[j].plaintext.resize((j * 37) % 150); // có job rỗng, lẻ, bội số 16
+        for (std::size_t i = 0; i < jobs[j].plaintext.size(); ++i)
+            jobs[j].plaintext[i] = static_cast<uint8_t>(i ^ j);
     }
 
-    std::string mode = argv[1]; // "enc" / "dec" / "selftest"
+    auto out = cbcEncryptBatch(jobs);
+    for (std::size_t j = 0; j < jobs.size(); ++j)
+    {
+        auto expected = cbcEncrypt(jobs[j].plaintext, jobs[j].key, jobs[j].iv);
+        if (!bytesEqual(out[j], expected))
+        {
+            std::cerr << "[CBC batch] job " << j << " mismatch!\n";
+            return false;
+        }
+    }
 
-    if (mode == "selftest")
+    std::cout << "[CBC batch] " << jobs.size() << " multi-buffer jobs: OK\n";
+    return true;
+}
+
+// API con trỏ: mã hoá/giải mã in-place phải khớp bản vector
+bool selftest_cbc_inplace()
+{
+    uint8_t key[16];
+    uint8_t iv[16];
+    for (int i = 0; i < 16; ++i)
     {
-        try
+        key[i] = static_cast<uint8_t>(i * 11);
+        iv[i] = static_cast<uint8_t>(0xF0 - i);
+    }
+
+    const std::size_t lengths[] = {0, 1, 15, 16, 17, 129, 256};
+    for (std::size_t len : lengths)
+    {
+        std::vector<uint8_t> pt(len);
+        for (std::size_t i = 0; i < len; ++i)
+            pt[i] = static_cast<uint8_t>(i * 13 + 1);
+
+        auto expected = cbcEncrypt(pt, key, iv);
+
+        // buffer đủ chỗ cho padding, mã hoá đè lên chính nó
+        std::vector<uint8_t> buf(pkcs7PaddedSize(len));
+        std::copy(pt.begin(), pt.end(), buf.begin());
+        std::size_t ctLen = cbcEncrypt(buf.data(), len, buf.data(), buf.size(), key, iv);
+        if (ctLen != expected.size() || !bytesEqual(buf, expected))
         {
-            bool ok = runSelfTests();
-            return ok ? 0 : 1;
+            std::cerr << "[CBC in-place] encrypt mismatch (len " << len << ")!\n";
+            return false;
         }
-        catch (const std::exception &ex)
+
+        std::size_t ptLen = cbcDecrypt(buf.data(), buf.size(), buf.data(), key, iv);
+        buf.resize(ptLen);
+        if (!bytesEqual(buf, pt))
         {
-            std::cerr << "Selftest error: " << ex.what() << "\n";
-            return 1;
+            std::cerr << "[CBC in-place] decrypt mismatch (len " << len << ")!\n";
+            return false;
         }
     }
 
-    // Các mode còn lại: enc / dec
-    std::string inPath;
-    std::string outPath;
-    std::string keyHex;
-    std::string ivHex;
-    bool noPad = false;
+    std::cout << "[CBC in-place] pointer API test: OK\n";
+    return true;
+}
 
-    for (int i = 2; i < argc; ++i)
+// CbcEncryptor/CbcDecryptor với chunk lẻ phải khớp bản one-shot
+bool selftest_cbc_stream()
+{
+    uint8_t key[16];
+    uint8_t iv[16];
+    for (int i = 0; i < 16; ++i)
     {
-        std::string arg = argv[i];
+        key[i] = static_cast<uint8_t>(0x5A ^ i);
+        iv[i] = static_cast<uint8_t>(i * 3);
+    }
 
-        if (arg == "--in" && i + 1 < argc)
+    std::vector<uint8_t> pt(1000);
+    for (std::size_t i = 0; i < pt.size(); ++i)
+        pt[i] = static_cast<uint8_t>(i * 29 + 7);
+    auto expected = cbcEncrypt(pt, key, iv);
+
+    const std::size_t chunks[] = {1, 7, 16, 33, 1000};
+    for (std::size_t chunk : chunks)
+    {
+        std::vector<uint8_t> ct(expected.size() + chunk + 16);
+        std::size_t ctLen = 0;
+        CbcEncryptor enc(key, iv);
+        for (std::size_t off = 0; off < pt.size(); off += chunk)
         {
-            inPath = argv[++i];
+            std::size_t n = std::min(chunk, pt.size() - off);
+            ctLen += enc.update(pt.data() + off, n, ct.data() + ctLen);
         }
-        else if (arg == "--out" && i + 1 < argc)
+        ctLen += enc.final(ct.data() + ctLen);
+        ct.resize(ctLen);
+        if (!bytesEqual(ct, expected))
         {
-            outPath = argv[++i];
+            std::cerr << "[CBC stream] encrypt mismatch (chunk " << chunk << ")!\n";
+            return false;
         }
-        else if (arg == "--key-hex" && i + 1 < argc)
+
+        std::vector<uint8_t> dec(ct.size() + chunk + 16);
+        std::size_t decLen = 0;
+        CbcDecryptor d(key, iv);
+        for (std::size_t off = 0; off < ct.size(); off += chunk)
         {
-            keyHex = argv[++i];
+            std::size_t n = std::min(chunk, ct.size() - off);
+            decLen += d.update(ct.data() + off, n, dec.data() + decLen);
         }
-        else if (arg == "--iv-hex" && i + 1 < argc)
+        decLen += d.final(dec.data() + decLen);
+        dec.resize(decLen);
+        if (!bytesEqual(dec, pt))
         {
-            ivHex = argv[++i];
+            std::cerr << "[CBC stream] decrypt mismatch (chunk " << chunk << ")!\n";
+            return false;
         }
-        else if (arg == "--no-pad")
+    }
+
+    std::cout << "[CBC stream] update/final test: OK\n";
+    return true;
+}
+
+// SP 800-38A F.5.1 CTR-AES128.Encrypt + seek + chia thread
+bool selftest_sp800_38a_ctr()
+{
+    auto key = hexToBytes("2B7E151628AED2A6ABF7158809CF4F3C");
+    auto ctr0 = hexToBytes("F0F1F2F3F4F5F6F7F8F9FAFBFCFDFEFF");
+    auto pt = hexToBytes(
+        "6BC1BEE22E409F96E93D7E117393172A"
+        "AE2D8A571E03AC9C9EB76FAC45AF8E51"
+        "30C81C46A35CE411E5FBC1191A0A52EF"
+        "F69F2445DF4F9B17AD2B417BE66C3710");
+    auto ctExpected = hexToBytes(
+        "874D6191B620E3261BEF6864990DB6CE"
+        "9806F66B7970FDFF8617187BB9FFFDFF"
+        "5AE4DF3EDBD5D35E5B4F09020DB03EAB"
+        "1E031DDA2FBE03D1792170A0F3009CEE");
+
+    auto ct = ctrCrypt(pt, key.data(), ctr0.data());
+    if (!bytesEqual(ct, ctExpected))
+    {
+        std::cerr << "[SP800-38A] CTR Encrypt mismatch!\n";
+        return false;
+    }
+
+    // seek: xử lý riêng từ byte 21 phải khớp phần đuôi
+    AES128 aes(key.data());
+    std::vector<uint8_t> tail(pt.size() - 21);
+    ctrCrypt(aes, ctr0.data(), 21, pt.data() + 21, tail.data(), tail.size());
+    if (!bytesEqual(tail, std::vector<uint8_t>(ctExpected.begin() + 21, ctExpected.end())))
+    {
+        std::cerr << "[SP800-38A] CTR seek mismatch!\n";
+        return false;
+    }
+
+    // buffer lớn chia 4 thread phải khớp bản 1 thread
+    std::vector<uint8_t> big(300000 + 5);
+    for (std::size_t i = 0; i < big.size(); ++i)
+        big[i] = static_cast<uint8_t>(i * 17);
+    std::vector<uint8_t> one(big.size()), multi(big.size());
+    ctrCrypt(aes, ctr0.data(), 3, big.data(), one.data(), big.size());
+    ThreadPool pool(4);
+    ctrCryptParallel(aes, ctr0.data(), 3, big.data(), multi.data(), big.size(), pool);
+    if (!bytesEqual(one, multi))
+    {
+        std::cerr << "[CTR] parallel mismatch!\n";
+        return false;
+    }
+
+    std::cout << "[SP800-38A] CTR-AES128 test: OK\n";
+    return true;
+}
+
+// GCM spec (McGrew & Viega) test case 2, 4 (IV 96-bit, có AAD) và 5 (IV 64-bit)
+bool selftest_gcm()
+{
+    auto k0 = hexToBytes("00000000000000000000000000000000");
+    auto r2 = gcmEncrypt(hexToBytes("00000000000000000000000000000000"), k0.data(),
+                         hexToBytes("000000000000000000000000"));
+    auto e2 = hexToBytes("0388DACE60B6A392F328C2B971B2FE78"
+                         "AB6E47D42CEC13BDF53A67B21257BDDF");
+    if (!bytesEqual(r2, e2))
+    {
+        std::cerr << "[GCM] test case 2 mismatch!\n";
+        return false;
+    }
+
+    auto key = hexToBytes("FEFFE9928665731C6D6A8F9467308308");
+    auto pt = hexToBytes(
+        "D9313225F88406E5A55909C5AFF5269A86A7A9531534F7DA2E4C303D8A318A72"
+        "1C3C0C95956809532FCF0E2449A6B525B16AEDF5AA0DE657BA637B39");
+    auto aad = hexToBytes("FEEDFACEDEADBEEFFEEDFACEDEADBEEFABADDAD2");
+
+    auto r4 = gcmEncrypt(pt, key.data(), hexToBytes("CAFEBABEFACEDBADDECAF888"), aad);
+    auto e4 = hexToBytes(
+        "42831EC2217774244B7221B784D0D49CE3AA212F2C02A4E035C17E2329ACA12E"
+        "21D514B25466931C7D8F6A5AAC84AA051BA30B396A0AAC973D58E091"
+        "5BC94FBC3221A5DB94FAE95AE7121A47");
+    if (!bytesEqual(r4, e4))
+    {
+        std::cerr << "[GCM] test case 4 mismatch!\n";
+        return false;
+    }
+
+    auto iv5 = hexToBytes("CAFEBABEFACEDBAD");
+    auto r5 = gcmEncrypt(pt, key.data(), iv5, aad);
+    auto e5 = hexToBytes(
+        "61353B4C2806934A777FF51FA22A4755699B2A714FCDC6F83766E5F97B6C7423"
+        "73806900E49F24B22B097544D4896B424989B5E1EBAC0F07C23F4598"
+        "3612D2E79E3B0785561BE14AACA2FCCB");
+    if (!bytesEqual(r5, e5))
+    {
+        std::cerr << "[GCM] test case 5 mismatch!\n";
+        return false;
+    }
+
+    if (!bytesEqual(gcmDecrypt(e5, key.data(), iv5, aad), pt))
+    {
+        std::cerr << "[GCM] decrypt mismatch!\n";
+        return false;
+    }
+
+    // sửa 1 bit -> phải bị từ chối
+    auto bad = e4;
+    bad[3] ^= 0x01;
+    try
+    {
+        gcmDecrypt(bad, key.data(), hexToBytes("CAFEBABEFACEDBADDECAF888"), aad);
+        std::cerr << "[GCM] tampered ciphertext accepted!\n";
+        return false;
+    }
+    catch (const std::runtime_error &)
+    {
+    }
+
+    // vượt 2^32 - 2 block / IV -> phải ném trước khi đụng tới dữ liệu (in / out = nullptr)
+    if (sizeof(std::size_t) > 4)
+    {
+        AES128 aes(key.data());
+        GcmStream limit(aes, iv5.data(), iv5.size(), nullptr, 0);
+        uint8_t block[16] = {0};
+        limit.encrypt(block, sizeof(block), block);
+        try
         {
-            noPad = true;
+            limit.encrypt(nullptr, static_cast<std::size_t>(GcmMaxTextBytes - sizeof(block) + 1), nullptr);
+            std::cerr << "[GCM] input over 2^32 - 2 blocks accepted!\n";
+            return false;
         }
-        else
+        catch (const std::runtime_error &)
         {
-            std::cerr << "Unknown or incomplete option: " << arg << "\n";
-            printUsage();
-            return 1;
         }
     }
 
-    if ((mode != "enc" && mode != "dec") ||
-        inPath.empty() || outPath.empty() || keyHex.empty() || ivHex.empty())
+    std::cout << "[GCM] AES-128-GCM test: OK\n";
+    return true;
+}
+
+// --threads: file segmented (segment nhỏ cho nhiều segment) và giải mã song song CBC 1 chain
+bool selftest_parallel_cbc()
+{
+    uint8_t key[16], iv[16];
+    for (int i = 0; i < 16; ++i)
     {
-        std::cerr << "Missing or invalid arguments.\n";
-        printUsage();
-        return 1;
+        key[i] = static_cast<uint8_t>(0x10 + i);
+        iv[i] = static_cast<uint8_t>(0xA0 + i);
     }
+    AES128 aes(key);
+    ThreadPool pool(4);
 
-    try
+    const std::size_t sizes[] = {0, 15, 64, 1000, 4096, 5000};
+    for (std::size_t len : sizes)
     {
-        uint8_t key[16];
-        uint8_t iv[16];
-        parseHexKeyOrIv(keyHex, key);
-        parseHexKeyOrIv(ivHex, iv);
+        std::string pt(len, '\0');
+        for (std::size_t i = 0; i < len; ++i)
+            pt[i] = static_cast<char>(i * 31 + 7);
 
-        std::vector<uint8_t> input = readFileBinary(inPath);
-        std::vector<uint8_t> output;
+        // segmented: 64 byte/segment, có trường hợp vừa khít segment
+        std::istringstream segIn(pt);
+        std::ostringstream segOut;
+        cbcEncryptSegmented(aes, iv, segIn, segOut, pool, 64);
+        std::istringstream segCt(segOut.str());
+        std::ostringstream segPt;
+        cbcDecryptSegmented(aes, iv, segCt, segPt, pool);
+        if (segPt.str() != pt)
+        {
+            std::cerr << "[PAR] segmented round-trip mismatch (len " << len << ")!\n";
+            return false;
+        }
 
-        if (mode == "enc")
+        // CBC thường: cắt chunk 48 byte, phải khớp cbcDecrypt 1 luồng
+        std::vector<uint8_t> ct = cbcEncrypt(std::vector<uint8_t>(pt.begin(), pt.end()), aes, iv);
+        std::istringstream chainIn(std::string(ct.begin(), ct.end()));
+        std::ostringstream chainOut;
+        cbcDecryptParallel(aes, iv, chainIn, chainOut, pool, true, 48);
+        if (chainOut.str() != pt)
         {
-            if (noPad)
-            {
-                if (input.size() % 16 != 0)
-                {
-                    throw std::runtime_error("Input size must be multiple of 16 when using --no-pad");
-                }
-                output = cbcEncryptNoPad(input, key, iv);
-            }
-            else
-            {
-                output = cbcEncrypt(input, key, iv);
-            }
+            std::cerr << "[PAR] parallel CBC decrypt mismatch (len " << len << ")!\n";
+            return false;
         }
-        else
-        { // dec
-            if (noPad)
-            {
-                if (input.size() % 16 != 0)
-                {
-                    throw std::runtime_error("Ciphertext size must be multiple of 16 when using --no-pad");
-                }
-                output = cbcDecryptNoPad(input, key, iv);
-            }
-            else
-            {
-                output = cbcDecrypt(input, key, iv);
-            }
+    }
+
+    std::cout << "[PAR] segmented + parallel CBC decrypt test: OK\n";
+    return true;
+}
+
+// --pipeline: chunk nhỏ, 2 buffer để các tầng phải chờ nhau; lỗi ở tầng cipher phải ném ra ngoài
+bool selftest_pipeline()
+{
+    uint8_t key[16], iv[16];
+    for (int i = 0; i < 16; ++i)
+    {
+        key[i] = static_cast<uint8_t>(0x30 + i);
+        iv[i] = static_cast<uint8_t>(0xC0 + i);
+    }
+    AES128 aes(key);
+
+    const std::size_t sizes[] = {0, 15, 48, 96, 1000, 5000};
+    for (std::size_t len : sizes)
+    {
+        std::string pt(len, '\0');
+        for (std::size_t i = 0; i < len; ++i)
+            pt[i] = static_cast<char>(i * 13 + 5);
+
+        std::vector<uint8_t> ref = cbcEncrypt(std::vector<uint8_t>(pt.begin(), pt.end()), aes, iv);
+        CbcEncryptor enc(key, iv);
+        std::istringstream encIn(pt);
+        std::ostringstream encOut;
+        runPipeline(enc, encIn, encOut, 48, 2);
+        if (encOut.str() != std::string(ref.begin(), ref.end()))
+        {
+            std::cerr << "[PIPE] CBC encrypt mismatch (len " << len << ")!\n";
+            return false;
+        }
+
+        CbcDecryptor dec(key, iv);
+        std::istringstream decIn(encOut.str());
+        std::ostringstream decOut;
+        PipelineStats st = runPipeline(dec, decIn, decOut, 48, 2);
+        if (decOut.str() != pt || st.bytesIn != ref.size() || st.bytesOut != len)
+        {
+            std::cerr << "[PIPE] CBC decrypt mismatch (len " << len << ")!\n";
+            return false;
         }
+    }
+
+    // ciphertext không phải bội 16 -> CbcDecryptor::final ném lỗi trong thread cipher
+    CbcDecryptor dec(key, iv);
+    std::istringstream badIn(std::string(100, 'x'));
+    std::ostringstream badOut;
+    try
+    {
+        runPipeline(dec, badIn, badOut, 48, 2);
+        std::cerr << "[PIPE] invalid ciphertext accepted!\n";
+        return false;
+    }
+    catch (const std::runtime_error &)
+    {
+    }
 
-        writeFileBinary(outPath, output);
+    std::cout << "[PIPE] reader/cipher/writer pipeline test: OK\n";
+    return true;
+}
 
-        std::cout << "Done (" << mode << (noPad ? ", no-pad" : "") << "). Output written to: " << outPath << "\n";
+// --io: vài file nhỏ (có file rỗng), chunk 4 KB, ít buffer / file mở để phải xoay vòng
+bool selftest_bulk_io()
+{
+    uint8_t key[16], iv[16];
+    for (int i = 0; i < 16; ++i)
+    {
+        key[i] = static_cast<uint8_t>(0x50 + i);
+        iv[i] = static_cast<uint8_t>(0xE0 + i);
+    }
+    AES128 aes(key);
+
+    const std::size_t sizes[] = {0, 1000, 70000};
+    std::vector<BulkFileJob> jobs;
+    std::vector<std::vector<uint8_t>> expected;
+    for (std::size_t n = 0; n < 3; ++n)
+    {
+        std::vector<uint8_t> pt(sizes[n]);
+        for (std::size_t i = 0; i < pt.size(); ++i)
+            pt[i] = static_cast<uint8_t>(i * 7 + n);
+        BulkFileJob job;
+        job.inPath = "aes_selftest_bulk_" + std::to_string(n) + ".bin";
+        job.outPath = job.inPath + ".enc";
+        std::ofstream(job.inPath, std::ios::binary)
+            .write(reinterpret_cast<const char *>(pt.data()), static_cast<std::streamsize>(pt.size()));
+        jobs.push_back(job);
+        expected.push_back(cbcEncrypt(pt, aes, iv));
+    }
+
+    bool ok = true;
+    const IoBackend ioBackends[] = {IoBackend::Blocking, IoBackend::IoUring};
+    for (IoBackend b : ioBackends)
+    {
+        if (b == IoBackend::IoUring && !ioUringAvailable())
+            continue;
+        BulkIoOptions opt;
+        opt.backend = b;
+        opt.threads = 2;
+        opt.chunkSize = 4096;
+        opt.queueDepth = 4;
+        opt.maxOpenFiles = 2;
+        cipherFilesBulk(jobs, [&]()
+                        { return makePipelineCipher(std::make_shared<CbcEncryptor>(aes, iv)); },
+                        opt);
+        for (std::size_t n = 0; n < jobs.size(); ++n)
+        {
+            if (readWholeFile(jobs[n].outPath) != expected[n])
+            {
+                std::cerr << "[BULK] " << ioBackendName(b) << " mismatch (file " << n << ")!\n";
+                ok = false;
+            }
+        }
+    }
+
+    for (const auto &job : jobs)
+    {
+        std::remove(job.inPath.c_str());
+        std::remove(job.outPath.c_str());
+    }
+    if (ok)
+        std::cout << "[BULK] blocking / io_uring file I/O test: OK\n";
+    return ok;
+}
+
+// batch: parse dòng JSONL và cache key schedule
+bool selftest_batch()
+{
+    BatchJob job = parseBatchJob(
+        " {\"op\": \"dec\", \"in\": \"dir\\/a \\\"x\\\".bin\", \"out\": \"b\", \"mode\": \"cbc\", \"pad\": false,"
+        " \"key\": \"2B7E151628AED2A6ABF7158809CF4F3C\", \"iv\": \"000102030405060708090a0b0c0d0e0f\"} ");
+    if (job.op != "dec" || job.in != "dir/a \"x\".bin" || job.out != "b" || job.padding ||
+        job.key[0] != 0x2B || job.key[15] != 0x3C || job.iv.size() != 16 || job.iv[15] != 0x0F)
+    {
+        std::cerr << "[BATCH] JSONL parse mismatch!\n";
+        return false;
+    }
+
+    const char *bad[] = {
+        "{\"op\": \"enc\", \"in\": \"a\", \"out\": \"b\", \"key\": \"00\", \"iv\": \"00\"}",
+        "{\"op\": \"enc\", \"in\": \"a\", \"out\": \"b\", \"key\": \"000102030405060708090a0b0c0d0e0f\"}",
+        "{\"op\": \"xor\", \"in\": \"a\", \"out\": \"b\", \"key\": \"000102030405060708090a0b0c0d0e0f\", \"iv\": \"000102030405060708090a0b0c0d0e0f\"}",
+        "{\"op\": \"enc\", \"ivv\": \"00\"}",
+        "{\"op\": \"enc\",",
+        "[1, 2]",
+    };
+    for (const char *line : bad)
+    {
+        try
+        {
+            parseBatchJob(line);
+            std::cerr << "[BATCH] invalid line accepted: " << line << "\n";
+            return false;
+        }
+        catch (const std::exception &)
+        {
+        }
+    }
+
+    KeyScheduleCache cache;
+    uint8_t k1[16] = {1}, k2[16] = {2};
+    auto a = cache.get(k1);
+    auto b = cache.get(k2);
+    auto c = cache.get(k1);
+    if (a != c || a == b || cache.expanded() != 2 || cache.reused() != 1)
+    {
+        std::cerr << "[BATCH] key schedule cache mismatch!\n";
+        return false;
+    }
+
+    std::cout << "[BATCH] JSONL jobs + key schedule cache test: OK\n";
+    return true;
+}
+
+// serve: frame header + server / load generator trên socket tạm
+bool selftest_server()
+{
+    WireRequest req;
+    req.length = 4096;
+    req.op = WireOp::Decrypt;
+    req.mode = WireMode::Gcm;
+    req.id = 0x12345678;
+    for (int i = 0; i < 16; ++i)
+    {
+        req.key[i] = static_cast<uint8_t>(i);
+        req.iv[i] = static_cast<uint8_t>(0xF0 + i);
+    }
+    uint8_t head[WireRequestHeaderSize];
+    encodeRequestHeader(req, head);
+    WireRequest back = decodeRequestHeader(head);
+    if (back.length != req.length || back.op != req.op || back.mode != req.mode || back.id != req.id ||
+        std::memcmp(back.key, req.key, 16) != 0 || std::memcmp(back.iv, req.iv, 16) != 0)
+    {
+        std::cerr << "[SERVER] header round-trip mismatch!\n";
+        return false;
+    }
+    head[5] = 9; // mode sai
+    try
+    {
+        decodeRequestHeader(head);
+        std::cerr << "[SERVER] invalid header accepted!\n";
+        return false;
+    }
+    catch (const std::exception &)
+    {
+    }
+
+    // LRU 2 key: k1, k2, k1, k3 -> k2 bị bỏ, k1 vẫn còn
+    KeyScheduleCache lru(2);
+    uint8_t k1[16] = {1}, k2[16] = {2}, k3[16] = {3};
+    lru.get(k1);
+    lru.get(k2);
+    lru.get(k1);
+    lru.get(k3);
+    lru.get(k1);
+    lru.get(k2);
+    if (lru.size() != 2 || lru.expanded() != 4 || lru.reused() != 2)
+    {
+        std::cerr << "[SERVER] key schedule LRU mismatch!\n";
+        return false;
+    }
+
+#if defined(__linux__)
+    ServeOptions so;
+    so.socketPath = "aes_selftest_server.sock";
+    so.threads = 2;
+    so.keyCacheSize = 2; // 3 connection = 3 key: buộc LRU phải bỏ key
+    std::atomic<bool> stop{false};
+    so.stop = &stop;
+
+    std::ostringstream log;
+    std::string serverError;
+    ServeStats stats;
+    std::thread server([&]()
+                       {
+                           try
+                           {
+                               stats = runServer(so, log);
+                           }
+                           catch (const std::exception &ex)
+                           {
+                               serverError = ex.what();
+                           } });
+
+    bool ok = true;
+    const WireMode modes[] = {WireMode::Cbc, WireMode::CbcNoPad, WireMode::Ctr, WireMode::Gcm};
+    for (WireMode m : modes)
+    {
+        LoadGenOptions lo;
+        lo.socketPath = so.socketPath;
+        lo.connections = 3;
+        lo.requests = 30;
+        lo.payloadSize = m == WireMode::CbcNoPad ? 4096 : 1000;
+        lo.mode = m;
+        // server khởi động trên thread khác: thử kết nối lại vài lần
+        for (int attempt = 0;; ++attempt)
+        {
+            try
+            {
+                LoadGenResult r = runLoadGen(lo);
+                ok = ok && r.requests == lo.requests;
+                break;
+            }
+            catch (const std::exception &ex)
+            {
+                if (attempt == 50)
+                {
+                    std::cerr << "[SERVER] load generator failed: " << ex.what() << "\n";
+                    ok = false;
+                    break;
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            }
+        }
+    }
+    stop = true;
+    server.join();
+
+    if (!serverError.empty())
+    {
+        std::cerr << "[SERVER] " << serverError << "\n";
+        return false;
+    }
+    if (!ok || stats.requests != 120 || stats.errors != 0 || stats.connections != 12)
+    {
+        std::cerr << "[SERVER] server / load generator mismatch!\n";
+        return false;
+    }
+    std::cout << "[SERVER] wire frames + key LRU + Unix socket server test: OK\n";
+#else
+    std::cout << "[SERVER] wire frames + key LRU test: OK (socket server skipped: Linux only)\n";
+#endif
+    return true;
+}
+
+bool runSelfTests()
+{
+    const AES128::Backend backends[] = {AES128::Backend::Byte,
+                                        AES128::Backend::TTable,
+                                        AES128::Backend::AesNi,
+                                        AES128::Backend::Bitslice};
+    const AES128::Backend saved = AES128::defaultBackend();
+
+    bool ok = true;
+    for (AES128::Backend b : backends)
+    {
+        if (!AES128::isBackendAvailable(b))
+        {
+            std::cout << "--- Backend: " << AES128::backendName(b)
+                      << " (not supported by this CPU, skipped) ---\n";
+            continue;
+        }
+        std::cout << "--- Backend: " << AES128::backendName(b) << " ---\n";
+
+        // các hàm CBC tự tạo AES128 -> chọn backend qua default
+        AES128::setDefaultBackend(b);
+        bool ok1 = selftest_fips197(b);
+        bool ok2 = selftest_sp800_38a_cbc();
+        bool ok3 = selftest_parallel_blocks(b);
+        bool ok4 = selftest_cbc_batch();
+        bool ok5 = selftest_cbc_inplace();
+        bool ok6 = selftest_cbc_stream();
+        bool ok7 = selftest_sp800_38a_ctr();
+        bool ok8 = selftest_gcm();
+        bool ok9 = selftest_parallel_cbc();
+        bool ok10 = selftest_pipeline();
+        bool ok11 = selftest_bulk_io();
+        bool ok12 = selftest_batch();
+        bool ok13 = selftest_server();
+        ok = ok && ok1 && ok2 && ok3 && ok4 && ok5 && ok6 && ok7 && ok8 && ok9 && ok10 && ok11 && ok12 && ok13;
+    }
+    AES128::setDefaultBackend(saved);
+
+    if (ok)
+    {
+        std::cout << "All self-tests PASSED.\n";
+        return true;
+    }
+    else
+    {
+        std::cout << "Self-tests FAILED.\n";
+        return false;
+    }
+}
+
+// ========== batch ==========
+
+// aes_tool batch --jobs file.jsonl [--threads N] [--backend b]
+int runBatchCommand(int argc, char *argv[])
+{
+    std::string jobsPath;
+    std::string backendName = "auto";
+    unsigned threads = 0;
+
+    for (int i = 2; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "--jobs" && i + 1 < argc)
+        {
+            jobsPath = argv[++i];
+        }
+        else if (arg == "--threads" && i + 1 < argc)
+        {
+            threads = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+        }
+        else if (arg == "--backend" && i + 1 < argc)
+        {
+            backendName = argv[++i];
+        }
+        else
+        {
+            std::cerr << "Unknown or incomplete option: " << arg << "\n";
+            printUsage();
+            return 1;
+        }
+    }
+    if (jobsPath.empty())
+    {
+        std::cerr << "Missing --jobs <file.jsonl>.\n";
+        printUsage();
+        return 1;
+    }
+
+    try
+    {
+        AES128::setDefaultBackend(AES128::parseBackend(backendName));
+        BatchSummary sum = runBatchFile(jobsPath, threads, std::cout);
+
+        double mb = static_cast<double>(sum.bytesIn) / (1024.0 * 1024.0);
+        std::cout << "Batch done (backend " << AES128::backendName(AES128::defaultBackend()) << "): "
+                  << sum.jobs << " jobs, " << sum.ok << " OK, " << sum.failed << " failed, "
+                  << sum.bytesIn << " bytes in, " << sum.bytesOut << " bytes out, "
+                  << sum.seconds * 1000.0 << " ms";
+        if (sum.seconds > 0)
+            std::cout << " (" << mb / sum.seconds << " MB/s)";
+        std::cout << ", key schedules: " << sum.keysExpanded << " expanded, "
+                  << sum.keysReused << " reused\n";
+        return sum.failed == 0 ? 0 : 1;
+    }
+    catch (const std::exception &ex)
+    {
+        std::cerr << "Error: " << ex.what() << "\n";
+        return 1;
+    }
+}
+
+// ========== serve / loadgen ==========
+
+// aes_tool serve --socket path [--threads N] [--key-cache N] [--backend b]
+int runServeCommand(int argc, char *argv[])
+{
+    ServeOptions opt;
+    std::string backendName = "auto";
+
+    for (int i = 2; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "--socket" && i + 1 < argc)
+        {
+            opt.socketPath = argv[++i];
+        }
+        else if (arg == "--threads" && i + 1 < argc)
+        {
+            opt.threads = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+        }
+        else if (arg == "--key-cache" && i + 1 < argc)
+        {
+            opt.keyCacheSize = static_cast<std::size_t>(std::strtoull(argv[++i], nullptr, 10));
+        }
+        else if (arg == "--backend" && i + 1 < argc)
+        {
+            backendName = argv[++i];
+        }
+        else
+        {
+            std::cerr << "Unknown or incomplete option: " << arg << "\n";
+            printUsage();
+            return 1;
+        }
+    }
+    if (opt.socketPath.empty())
+    {
+        std::cerr << "Missing --socket <path>.\n";
+        printUsage();
+        return 1;
+    }
+
+    try
+    {
+        AES128::setDefaultBackend(AES128::parseBackend(backendName));
+        ServeStats st = runServer(opt, std::cout);
+        std::cout << "Server stopped: " << st.connections << " connections, " << st.requests
+                  << " requests, " << st.errors << " errors, " << st.bytesIn << " bytes in, "
+                  << st.bytesOut << " bytes out, key schedules: " << st.keysExpanded << " expanded, "
+                  << st.keysReused << " reused\n";
+        return 0;
+    }
+    catch (const std::exception &ex)
+    {
+        std::cerr << "Error: " << ex.what() << "\n";
+        return 1;
+    }
+}
+
+// aes_tool loadgen --socket path [--connections C] [--requests N] [--size B] [--mode m]
+int runLoadGenCommand(int argc, char *argv[])
+{
+    LoadGenOptions opt;
+    std::string modeName = "cbc";
+
+    for (int i = 2; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "--socket" && i + 1 < argc)
+        {
+            opt.socketPath = argv[++i];
+        }
+        else if (arg == "--connections" && i + 1 < argc)
+        {
+            opt.connections = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+        }
+        else if (arg == "--requests" && i + 1 < argc)
+        {
+            opt.requests = static_cast<std::size_t>(std::strtoull(argv[++i], nullptr, 10));
+        }
+        else if (arg == "--size" && i + 1 < argc)
+        {
+            opt.payloadSize = static_cast<std::size_t>(std::strtoull(argv[++i], nullptr, 10));
+        }
+        else if (arg == "--mode" && i + 1 < argc)
+        {
+            modeName = argv[++i];
+        }
+        else
+        {
+            std::cerr << "Unknown or incomplete option: " << arg << "\n";
+            printUsage();
+            return 1;
+        }
+    }
+    if (opt.socketPath.empty())
+    {
+        std::cerr << "Missing --socket <path>.\n";
+        printUsage();
+        return 1;
+    }
+    if (modeName == "cbc")
+        opt.mode = WireMode::Cbc;
+    else if (modeName == "cbc-nopad")
+        opt.mode = WireMode::CbcNoPad;
+    else if (modeName == "ctr")
+        opt.mode = WireMode::Ctr;
+    else if (modeName == "gcm")
+        opt.mode = WireMode::Gcm;
+    else
+    {
+        std::cerr << "Unknown mode: " << modeName << "\n";
+        return 1;
+    }
+
+    try
+    {
+        LoadGenResult r = runLoadGen(opt);
+        double mb = static_cast<double>(r.requests) * static_cast<double>(opt.payloadSize) / (1024.0 * 1024.0);
+        std::cout << "Load: " << r.requests << " requests (" << modeName << ", " << opt.payloadSize
+                  << " bytes) over " << opt.connections << " connections in " << r.seconds * 1000.0 << " ms";
+        if (r.seconds > 0)
+            std::cout << " (" << static_cast<double>(r.requests) / r.seconds << " req/s, " << mb / r.seconds << " MB/s)";
+        std::cout << "\nLatency (us): p50 " << r.p50Us << ", p90 " << r.p90Us << ", p99 " << r.p99Us
+                  << ", max " << r.maxUs << "\n";
+        return 0;
+    }
+    catch (const std::exception &ex)
+    {
+        std::cerr << "Error: " << ex.what() << "\n";
+        return 1;
+    }
+}
+
+// ========== main ==========
+
+int main(int argc, char *argv[])
+{
+    if (argc < 2)
+    {
+        printUsage();
+        return 1;
+    }
+
+    std::string mode = argv[1]; // "enc" / "dec" / "selftest"
+
+    if (mode == "selftest")
+    {
+        try
+        {
+            bool ok = runSelfTests();
+            return ok ? 0 : 1;
+        }
+        catch (const std::exception &ex)
+        {
+            std::cerr << "Selftest error: " << ex.what() << "\n";
+            return 1;
+        }
+    }
+
+    if (mode == "batch")
+    {
+        return runBatchCommand(argc, argv);
+    }
+    if (mode == "serve")
+    {
+        return runServeCommand(argc, argv);
+    }
+    if (mode == "loadgen")
+    {
+        return runLoadGenCommand(argc, argv);
+    }
+
+    // Các mode còn lại: enc / dec
+    std::string inPath;
+    std::string outPath;
+    std::vector<std::string> inPaths, outPaths; // --in / --out lặp lại: ghép cặp theo thứ tự
+    std::string keyHex;
+    std::string ivHex;
+    bool noPad = false;
+    std::string backendName = "auto";
+    std::string cipherMode = "cbc";
+    std::string aadHex;
+    bool threaded = false;
+    unsigned threads = 0;
+    uint32_t segmentSize = DefaultSegmentSize;
+    FileIoOptions io;
+    bool showStats = false;
+    std::string ioName;
+
+    for (int i = 2; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+
+        if (arg == "--in" && i + 1 < argc)
+        {
+            inPaths.push_back(argv[++i]);
+        }
+        else if (arg == "--out" && i + 1 < argc)
+        {
+            outPaths.push_back(argv[++i]);
+        }
+        else if (arg == "--key-hex" && i + 1 < argc)
+        {
+            keyHex = argv[++i];
+        }
+        else if (arg == "--iv-hex" && i + 1 < argc)
+        {
+            ivHex = argv[++i];
+        }
+        else if (arg == "--no-pad")
+        {
+            noPad = true;
+        }
+        else if (arg == "--backend" && i + 1 < argc)
+        {
+            backendName = argv[++i];
+        }
+        else if (arg == "--mode" && i + 1 < argc)
+        {
+            cipherMode = argv[++i];
+        }
+        else if (arg == "--aad-hex" && i + 1 < argc)
+        {
+            aadHex = argv[++i];
+        }
+        else if (arg == "--threads" && i + 1 < argc)
+        {
+            threaded = true;
+            threads = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+        }
+        else if (arg == "--segment-size" && i + 1 < argc)
+        {
+            segmentSize = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        }
+        else if (arg == "--io" && i + 1 < argc)
+        {
+            ioName = argv[++i];
+        }
+        else if (arg == "--pipeline")
+        {
+            io.pipeline = true;
+        }
+        else if (arg == "--stats")
+        {
+            showStats = true;
+        }
+        else
+        {
+            std::cerr << "Unknown or incomplete option: " << arg << "\n";
+            printUsage();
+            return 1;
+        }
+    }
+
+    std::vector<BulkFileJob> jobs;
+    if (inPaths.size() == outPaths.size())
+    {
+        for (std::size_t i = 0; i < inPaths.size(); ++i)
+            jobs.push_back(BulkFileJob{inPaths[i], outPaths[i]});
+    }
+    if (!jobs.empty())
+    {
+        inPath = jobs[0].inPath;
+        outPath = jobs[0].outPath;
+    }
+    if ((mode != "enc" && mode != "dec") ||
+        inPath.empty() || outPath.empty() || keyHex.empty() || ivHex.empty())
+    {
+        std::cerr << "Missing or invalid arguments.\n";
+        printUsage();
+        return 1;
+    }
+
+    if (cipherMode != "cbc" && cipherMode != "ctr" && cipherMode != "gcm")
+    {
+        std::cerr << "Unknown mode: " << cipherMode << "\n";
+        printUsage();
+        return 1;
+    }
+    if (cipherMode != "cbc" && noPad)
+    {
+        std::cerr << "--no-pad only applies to --mode cbc (CTR/GCM have no padding).\n";
+        return 1;
+    }
+    if (cipherMode != "gcm" && !aadHex.empty())
+    {
+        std::cerr << "--aad-hex only applies to --mode gcm.\n";
+        return 1;
+    }
+    if (threaded && cipherMode == "gcm")
+    {
+        std::cerr << "--threads only applies to --mode cbc and ctr.\n";
+        return 1;
+    }
+    if (threaded && mode == "enc" && noPad)
+    {
+        std::cerr << "--no-pad cannot be used with enc --threads (the last segment is always padded).\n";
+        return 1;
+    }
+    if (threaded && io.pipeline)
+    {
+        std::cerr << "--pipeline cannot be combined with --threads.\n";
+        return 1;
+    }
+    io.bulk = jobs.size() > 1 || !ioName.empty();
+    if (io.bulk && (threaded || io.pipeline))
+    {
+        std::cerr << "Several --in/--out pairs and --io cannot be combined with --threads or --pipeline.\n";
+        return 1;
+    }
+    if (jobs.size() > 1 && cipherMode != "cbc")
+    {
+        // CTR/GCM: cùng key + IV cho 2 file làm lộ XOR của plaintext
+        std::cerr << "Several files with one key/IV are only allowed for --mode cbc.\n";
+        return 1;
+    }
+    if (showStats && !io.pipeline)
+    {
+        std::cerr << "--stats requires --pipeline.\n";
+        return 1;
+    }
+    if (segmentSize == 0 || segmentSize % AES128::BlockSize != 0)
+    {
+        std::cerr << "--segment-size must be a non-zero multiple of 16.\n";
+        return 1;
+    }
+
+    try
+    {
+        uint8_t key[16];
+        uint8_t iv[16];
+        parseHexKeyOrIv(keyHex, key);
+
+        AES128::setDefaultBackend(AES128::parseBackend(backendName));
+
+        for (const auto &job : jobs)
+        {
+            if (io.bulk && (job.inPath == "-" || job.outPath == "-"))
+            {
+                throw std::runtime_error("--in - / --out - cannot be used with several files or --io");
+            }
+            if (sameFile(job.inPath, job.outPath))
+            {
+                throw std::runtime_error("Input and output must be different files");
+            }
+        }
+        if (io.bulk)
+            io.bulkOptions.backend = parseIoBackend(ioName.empty() ? "auto" : ioName);
+
+        if (cipherMode == "gcm")
+        {
+            // GCM: IV độ dài bất kỳ (khuyến nghị 12 byte)
+            std::vector<uint8_t> gcmIv = hexToBytes(ivHex);
+            std::vector<uint8_t> aad = hexToBytes(aadHex);
+            AES128 aes(key);
+            if (mode == "enc")
+            {
+                cipherFiles([&]()
+                            { return std::make_shared<GcmEncryptor>(aes, gcmIv.data(), gcmIv.size(),
+                                                                    aad.data(), aad.size()); },
+                            jobs, io);
+            }
+            else
+            {
+                cipherFiles([&]()
+                            { return std::make_shared<GcmDecryptor>(aes, gcmIv.data(), gcmIv.size(),
+                                                                    aad.data(), aad.size()); },
+                            jobs, io);
+            }
+        }
+        else if (cipherMode == "ctr")
+        {
+            parseHexKeyOrIv(ivHex, iv);
+            // CTR: mã hoá và giải mã giống nhau; --threads chia mỗi lần update theo counter offset.
+            // stdin / pipe: chunk đủ lớn để mọi thread đều có phần (64 KB thì chỉ 1 thread chạy)
+            cipherFiles([&]()
+                        {
+                            auto c = std::make_shared<CtrCipher>(key, iv);
+                            if (threaded)
+                            {
+                                c->setThreads(threads);
+                                io.streamChunk = std::max(StreamChunkSize, c->parallelChunkSize());
+                            }
+                            return c; },
+                        jobs, io);
+        }
+        else if (threaded)
+        {
+            parseHexKeyOrIv(ivHex, iv);
+            AES128 aes(key);
+            parallelCbcFile(mode, aes, iv, !noPad, threads, segmentSize, inPath, outPath);
+        }
+        else if (mode == "enc")
+        {
+            parseHexKeyOrIv(ivHex, iv);
+            AES128 aes(key);
+            cipherFiles([&]()
+                        { return std::make_shared<CbcEncryptor>(aes, iv, !noPad); },
+                        jobs, io);
+        }
+        else
+        { // dec
+            parseHexKeyOrIv(ivHex, iv);
+            AES128 aes(key);
+            cipherFiles([&]()
+                        { return std::make_shared<CbcDecryptor>(aes, iv, !noPad); },
+                        jobs, io);
+        }
+
+        // output ra stdout thì thông báo sang stderr để không lẫn vào dữ liệu
+        std::ostream &status = (outPath == "-") ? std::cerr : std::cout;
+        status << "Done (" << mode << ", " << cipherMode << (noPad ? ", no-pad" : "")
+               << ", backend " << AES128::backendName(AES128::defaultBackend());
+        if (io.bulk)
+        {
+            const BulkIoResult &r = io.bulkResult;
+            status << ", io " << ioBackendName(r.backend) << "). " << r.files << " file(s), "
+                   << r.bytesIn << " bytes in, " << r.bytesOut << " bytes out, "
+                   << r.seconds * 1000.0 << " ms";
+            if (r.seconds > 0)
+                status << " (" << static_cast<double>(r.bytesIn) / (1024.0 * 1024.0) / r.seconds << " MB/s)";
+            status << "\n";
+        }
+        else
+        {
+            status << "). Output written to: " << outPath << "\n";
+        }
+        if (showStats)
+            printPipelineStats(status, io.stats);
     }
     catch (const std::exception &ex)
     {
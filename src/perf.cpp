@@ -8,24 +8,35 @@
 #include <algorithm>
 #include <numeric>
 #include <cmath>
+#include <iomanip>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <optional>
+#include <memory>
+#include <atomic>
+#include <thread>
+#include <cstring>
+#include <sstream>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#endif
 
 #include "cbc.h"
+#include "ctr.h"
+#include "gcm.h"
+#include "file_io.h"
+#include "async_io.h"
+#include "cycle_counter.h"
+#include "perf_stats.h"
+#include "perf_counters.h"
+#include "perf_env.h"
 
 // ==== I/O util ====
 
-std::vector<uint8_t> readFileBinary(const std::string &path)
-{
-    std::ifstream ifs(path, std::ios::binary);
-    if (!ifs)
-    {
-        throw std::runtime_error("Cannot open input file: " + path);
-    }
-    std::vector<uint8_t> data(
-        (std::istreambuf_iterator<char>(ifs)),
-        std::istreambuf_iterator<char>());
-    return data;
-}
-
 uint8_t hexToByte(char hi, char lo)
 {
     auto hexVal = [](char c) -> int
@@ -58,103 +69,346 @@ void parseHexKeyOrIv(const std::string &hex, uint8_t out[16])
     }
 }
 
-// ==== thống kê ====
+// ==== cấu trúc lưu kết quả để xuất CSV ====
 
-struct Stats
+// Thời gian trung bình của 1 phase cho 1 lần gọi (1 lượt cả file / 1 lần mở rộng khoá)
+struct PhaseResult
 {
-    double mean_ms;
-    double median_ms;
-    double stddev_ms;
-    double ci_low_ms;
-    double ci_high_ms;
+    double ns_per_op = 0;
+    double ns_per_block = 0;    // / số block 16 byte
+    double cycles_per_op = 0;   // 0 nếu không có bộ đếm chu kỳ
+    double cycles_per_byte = 0;
+    bool measured = false;      // false: phase không đo (CSV để trống, JSON null)
+};
+
+struct PerfResult
+{
+    std::string filename;
+    std::string backend;
+    std::string mode;
+    std::string measure = "kernel"; // --measure (io-bench: e2e)
+    std::size_t size_bytes;
+    int rounds_per_block;
+    int blocks;
+    Stats stats;
+    double throughput_MBps; // enc+dec
+    int threads = 1;
+    double efficiency = 1.0; // --threads: (MB/s / thread) so với số thread nhỏ nhất
+    // --counters (0 nếu không đo / không có): trên mỗi block 16 byte dữ liệu của 1 round
+    double ipc = 0;
+    double hw_cycles_per_byte = 0;
+    double l1d_misses_per_block = 0;
+    double branch_misses_per_block = 0;
+    double p50_ns = 0, p90_ns = 0, p99_ns = 0, p999_ns = 0, max_ns = 0; // --latency
+    double enc_mean_ms = 0;  // phần enc / dec của 1 block đo
+    double dec_mean_ms = 0;
+    PhaseResult enc, dec, keyexp, pad;
+    std::vector<double> samples_ms; // --json: thời gian từng block / mẫu
+    std::vector<std::pair<double, uint64_t>> latency_buckets; // --latency: (ns, số mẫu)
 };
 
-Stats computeStats(const std::vector<double> &samples_ms)
+// ==== 1 lượt enc / dec theo mode ====
+
+// Dùng key schedule có sẵn: mở rộng khoá được đo riêng (phase keyexp).
+// cbc: CBC không padding (padding đo riêng); ctr: iv là counter block đầu;
+// gcm: dùng 12 byte đầu của iv làm nonce, output = ct || tag
+std::vector<uint8_t> encryptOnce(const std::string &mode,
+                                 const AES128 &aes,
+                                 const uint8_t *data, std::size_t len,
+                                 const uint8_t iv[16])
 {
-    const std::size_t n = samples_ms.size();
-    if (n == 0)
+    if (mode == "ctr")
     {
-        throw std::runtime_error("No samples to compute stats");
+        std::vector<uint8_t> out(len);
+        ctrCrypt(aes, iv, 0, data, out.data(), len);
+        return out;
     }
+    if (mode == "gcm")
+    {
+        std::vector<uint8_t> out(len + GcmTagSize);
+        GcmEncryptor enc(aes, iv, 12);
+        std::size_t n = enc.update(data, len, out.data());
+        enc.final(out.data() + n);
+        return out;
+    }
+    std::vector<uint8_t> out(len);
+    cbcEncryptNoPad(data, len, out.data(), aes, iv);
+    return out;
+}
 
-    // mean
-    double sum = std::accumulate(samples_ms.begin(), samples_ms.end(), 0.0);
-    double mean = sum / static_cast<double>(n);
+std::vector<uint8_t> decryptOnce(const std::string &mode,
+                                 const AES128 &aes,
+                                 const std::vector<uint8_t> &data,
+                                 const uint8_t iv[16])
+{
+    if (mode == "ctr")
+    {
+        std::vector<uint8_t> out(data.size());
+        ctrCrypt(aes, iv, 0, data.data(), out.data(), data.size());
+        return out;
+    }
+    if (mode == "gcm")
+    {
+        std::vector<uint8_t> out(data.size());
+        GcmDecryptor dec(aes, iv, 12);
+        std::size_t n = dec.update(data.data(), data.size(), out.data());
+        dec.final(out.data() + n);
+        out.resize(n);
+        return out;
+    }
+    return cbcDecryptNoPad(data, aes, iv);
+}
 
-    // median
-    std::vector<double> sorted = samples_ms;
-    std::sort(sorted.begin(), sorted.end());
-    double median;
-    if (n % 2 == 0)
+// Bản không cấp phát (--measure kernel): output do caller cấp, ctr / cbc cần len byte,
+// gcm cần len + GcmTagSize byte (enc) / len byte (dec, len gồm cả tag).
+// Trả về số byte đã ghi.
+std::size_t encryptInto(const std::string &mode,
+                        const AES128 &aes,
+                        const uint8_t *in, std::size_t len,
+                        uint8_t *out,
+                        const uint8_t iv[16])
+{
+    if (mode == "ctr")
     {
-        median = 0.5 * (sorted[n / 2 - 1] + sorted[n / 2]);
+        ctrCrypt(aes, iv, 0, in, out, len);
+        return len;
     }
-    else
+    if (mode == "gcm")
     {
-        median = sorted[n / 2];
+        GcmEncryptor enc(aes, iv, 12);
+        std::size_t n = enc.update(in, len, out);
+        return n + enc.final(out + n);
     }
+    cbcEncryptNoPad(in, len, out, aes, iv);
+    return len;
+}
 
-    // sample stddev
-    double sq_sum = 0.0;
-    for (double x : samples_ms)
+std::size_t decryptInto(const std::string &mode,
+                        const AES128 &aes,
+                        const uint8_t *in, std::size_t len,
+                        uint8_t *out,
+                        const uint8_t iv[16])
+{
+    if (mode == "ctr")
+    {
+        ctrCrypt(aes, iv, 0, in, out, len);
+        return len;
+    }
+    if (mode == "gcm")
     {
-        double diff = x - mean;
-        sq_sum += diff * diff;
+        GcmDecryptor dec(aes, iv, 12);
+        std::size_t n = dec.update(in, len, out);
+        return n + dec.final(out + n);
     }
-    double stddev = std::sqrt(sq_sum / static_cast<double>(n - 1));
+    cbcDecryptNoPad(in, len, out, aes, iv);
+    return len;
+}
 
-    // 95% CI: mean ± t * std/sqrt(n), với n=10 → t≈2.262
-    double t_val = 2.262;
-    double margin = t_val * stddev / std::sqrt(static_cast<double>(n));
-    double ci_low = mean - margin;
-    double ci_high = mean + margin;
+// ==== đo theo phase ====
 
-    return Stats{mean, median, stddev, ci_low, ci_high};
+// Tổng thời gian (steady_clock) và chu kỳ (rdtsc) của 1 phase trong 1 block đo
+struct PhaseTotals
+{
+    double ns = 0;
+    double cycles = 0;
+};
+
+template <typename F>
+void timePhase(PhaseTotals &totals, F f)
+{
+    auto t0 = std::chrono::steady_clock::now();
+    uint64_t c0 = readCycleCounter();
+    f();
+    uint64_t c1 = readCycleCounter();
+    auto t1 = std::chrono::steady_clock::now();
+    totals.ns += std::chrono::duration<double, std::nano>(t1 - t0).count();
+    totals.cycles += static_cast<double>(c1 - c0);
 }
 
-// ==== cấu trúc lưu kết quả để xuất CSV ====
+void addPhase(PhaseTotals &sum, const PhaseTotals &block)
+{
+    sum.ns += block.ns;
+    sum.cycles += block.cycles;
+}
 
-struct PerfResult
+PhaseResult phaseResult(const PhaseTotals &totals, double ops, std::size_t bytes)
 {
-    std::string filename;
-    std::size_t size_bytes;
-    int rounds_per_block;
-    int blocks;
-    Stats stats;
-    double throughput_MBps; // enc+dec
+    PhaseResult r;
+    r.measured = true;
+    r.ns_per_op = totals.ns / ops;
+    r.ns_per_block = r.ns_per_op / (static_cast<double>(bytes) / AES128::BlockSize);
+    if (cycleCounterAvailable())
+    {
+        r.cycles_per_op = totals.cycles / ops;
+        r.cycles_per_byte = r.cycles_per_op / static_cast<double>(bytes);
+    }
+    return r;
+}
+
+// ==== chạy perf trên 1 buffer ====
+
+// --measure: kernel = buffer output cấp trước, 1 key schedule dùng chung, mỗi block đo enc
+// rồi dec của cả block bằng 1 lần đọc đồng hồ; e2e = như bản cũ, mỗi round mở rộng khoá,
+// pad và nhận vector mới từ API vector (đo cả malloc và key setup).
+enum class Measure
+{
+    Kernel,
+    EndToEnd
 };
 
-// ==== chạy perf 1 file ====
+const char *measureName(Measure m)
+{
+    return m == Measure::Kernel ? "kernel" : "e2e";
+}
 
-void runPerfForFile(const std::string &filename,
-                    const uint8_t key[16],
-                    const uint8_t iv[16],
-                    int rounds_per_block,
-                    int blocks,
-                    PerfResult &outResult)
+// Số round tối đa của 1 block (khi hiệu chỉnh)
+const int MaxRoundsPerBlock = 1 << 30;
+
+// Tăng số round x4 cho tới khi 1 block chạy >= 1/4 thời gian mục tiêu,
+// rồi nội suy tuyến tính ra số round cho đúng targetMs
+template <typename Block>
+int calibrateRounds(double targetMs, Block runBlock)
 {
-    using clock = std::chrono::high_resolution_clock;
+    int rounds = 1;
+    while (true)
+    {
+        double ms = runBlock(rounds);
+        if (ms >= targetMs / 4 || rounds >= MaxRoundsPerBlock / 4)
+        {
+            double want = ms > 0 ? rounds * targetMs / ms : static_cast<double>(MaxRoundsPerBlock);
+            return static_cast<int>(std::min<double>(MaxRoundsPerBlock, std::max(1.0, std::round(want))));
+        }
+        rounds *= 4;
+    }
+}
 
-    std::vector<uint8_t> data = readFileBinary(filename);
-    std::size_t data_size = data.size();
+// Mẫu của 1 block = thời gian enc + dec của rounds_per_block round.
+// e2e: mỗi round gồm 4 phase đo riêng: mở rộng khoá (AES128 ctor, cả decrypt schedule),
+// padding PKCS#7 (chỉ cbc), enc, dec. kernel: mẫu chỉ gồm enc và dec; mở rộng khoá và pad
+// (pkcs7PadInto, không cấp phát) đo 1 lần / block, ngoài vòng enc / dec.
+// rounds_per_block = 0: hiệu chỉnh để 1 block chạy ~sampleMs.
+// Message size byte; round thứ r dùng message thứ (r mod span / size) trong buf[0..span),
+// span > size (working set lớn hơn LLC) thì mỗi round đọc vùng nhớ chưa có trong cache.
+// counters != nullptr: đếm cycles / instructions / miss quanh mỗi block đo (mọi phase).
+void runPerfForBuffer(const char *kind,
+                      const std::string &label,
+                      const uint8_t *buf,
+                      std::size_t data_size,
+                      std::size_t span,
+                      const uint8_t key[16],
+                      const uint8_t iv[16],
+                      const std::string &mode,
+                      Measure measure,
+                      int rounds_per_block,
+                      double sampleMs,
+                      int blocks,
+                      HwCounters *counters,
+                      PerfResult &outResult)
+{
+    using clock = std::chrono::high_resolution_clock;
 
     if (data_size == 0 || (data_size % 16) != 0)
     {
-        throw std::runtime_error("File " + filename +
+        throw std::runtime_error(std::string(kind) + " " + label +
                                  " size must be non-empty and multiple of 16 bytes");
     }
 
-    std::cout << "\n=== File: " << filename
-              << " (" << data_size << " bytes) ===\n";
+    std::cout << "\n=== " << kind << ": " << label << " (" << data_size << " bytes, mode " << mode
+              << ", " << measureName(measure);
+    if (span > data_size)
+        std::cout << ", working set " << span << " bytes";
+    std::cout << ") ===\n";
+
+    const std::size_t messages = std::max<std::size_t>(1, span / data_size);
+    std::size_t next = 0;
+    auto advance = [&]()
+    { next = next + 1 == messages ? 0 : next + 1; };
+
+    const bool e2e = measure == Measure::EndToEnd;
+    const bool padPhase = mode == "cbc";
+    PhaseTotals keyexp, pad, enc, dec;
+    auto runRound = [&]()
+    {
+        const uint8_t *data = buf + next * data_size;
+        advance();
+
+        std::optional<AES128> aes;
+        timePhase(keyexp, [&]()
+                  { aes.emplace(key); });
+        if (padPhase)
+        {
+            std::vector<uint8_t> padded;
+            timePhase(pad, [&]()
+                      { padded = pkcs7Pad(data, data_size); });
+        }
+        std::vector<uint8_t> ct, pt;
+        timePhase(enc, [&]()
+                  { ct = encryptOnce(mode, *aes, data, data_size, iv); });
+        timePhase(dec, [&]()
+                  { pt = decryptOnce(mode, *aes, ct, iv); });
+    };
+
+    // kernel: ciphertext của mọi message trong working set (dec đọc lại đúng message vừa enc)
+    const std::size_t ctLen = data_size + (mode == "gcm" ? GcmTagSize : 0);
+    const AES128 aes(key);
+    std::vector<uint8_t> ct, pt, padded;
+    if (!e2e)
+    {
+        ct.resize(messages * ctLen);
+        pt.resize(ctLen);
+        if (padPhase)
+            padded.resize(pkcs7PaddedSize(data_size));
+    }
+    auto kernelBlock = [&](int rounds)
+    {
+        const std::size_t first = next;
+        std::optional<AES128> fresh;
+        timePhase(keyexp, [&]()
+                  { fresh.emplace(key); });
+        if (padPhase)
+        {
+            timePhase(pad, [&]()
+                      { pkcs7PadInto(buf + next * data_size, data_size, padded.data()); });
+        }
+        timePhase(enc, [&]()
+                  {
+                      for (int r = 0; r < rounds; ++r)
+                      {
+                          encryptInto(mode, aes, buf + next * data_size, data_size, ct.data() + next * ctLen, iv);
+                          advance();
+                      } });
+        next = first;
+        timePhase(dec, [&]()
+                  {
+                      for (int r = 0; r < rounds; ++r)
+                      {
+                          decryptInto(mode, aes, ct.data() + next * ctLen, ctLen, pt.data(), iv);
+                          advance();
+                      } });
+    };
+
+    // 1 block rounds round, trả về ms enc + dec
+    auto runBlock = [&](int rounds) -> double
+    {
+        keyexp = pad = enc = dec = PhaseTotals();
+        if (e2e)
+        {
+            for (int r = 0; r < rounds; ++r)
+                runRound();
+        }
+        else
+        {
+            kernelBlock(rounds);
+        }
+        return (enc.ns + dec.ns) / 1e6;
+    };
 
     // warm-up ~1s
     {
         auto start = clock::now();
-        std::vector<uint8_t> ct, pt;
         while (true)
         {
-            ct = cbcEncryptNoPad(data, key, iv);
-            pt = cbcDecryptNoPad(ct, key, iv);
+            runBlock(1);
 
             auto now = clock::now();
             double elapsed_sec =
@@ -165,29 +419,50 @@ void runPerfForFile(const std::string &filename,
         std::cout << "Warm-up done (~1s)\n";
     }
 
-    // đo thời gian cho "blocks" block, mỗi block = rounds_per_block lần (enc+dec)
+    if (rounds_per_block <= 0)
+    {
+        rounds_per_block = calibrateRounds(sampleMs, runBlock);
+        std::cout << "Calibrated: " << rounds_per_block << " rounds / block (~" << sampleMs << " ms)\n";
+    }
+
+    // đo "blocks" block, mỗi block = rounds_per_block round
     std::vector<double> samples_ms;
     samples_ms.reserve(blocks);
+    PhaseTotals sumKeyexp, sumPad, sumEnc, sumDec;
+    double encMs = 0, decMs = 0;
+    double hw[static_cast<int>(HwCounter::Count)] = {};
 
     for (int b = 0; b < blocks; ++b)
     {
-        auto t0 = clock::now();
-
-        std::vector<uint8_t> ct, pt;
-        for (int r = 0; r < rounds_per_block; ++r)
+        if (counters)
+            counters->start();
+        double elapsed_ms = runBlock(rounds_per_block);
+        if (counters)
         {
-            ct = cbcEncryptNoPad(data, key, iv);
-            pt = cbcDecryptNoPad(ct, key, iv);
+            counters->stop();
+            for (int c = 0; c < static_cast<int>(HwCounter::Count); ++c)
+                hw[c] += counters->value(static_cast<HwCounter>(c));
         }
 
-        auto t1 = clock::now();
-        double elapsed_ms =
-            std::chrono::duration<double, std::milli>(t1 - t0).count();
         samples_ms.push_back(elapsed_ms);
+        encMs += enc.ns / 1e6;
+        decMs += dec.ns / 1e6;
+        addPhase(sumKeyexp, keyexp);
+        addPhase(sumPad, pad);
+        addPhase(sumEnc, enc);
+        addPhase(sumDec, dec);
 
         std::cout << "Block " << (b + 1)
                   << " time (enc+dec " << rounds_per_block
-                  << " rounds): " << elapsed_ms << " ms\n";
+                  << " rounds): " << elapsed_ms << " ms (enc " << enc.ns / 1e6
+                  << ", dec " << dec.ns / 1e6 << ")\n";
+    }
+
+    // kernel: kiểm tra message giải mã cuối cùng (gcm: tag đã được kiểm tra trong final)
+    const uint8_t *lastIn = buf + (next + messages - 1) % messages * data_size;
+    if (!e2e && !std::equal(lastIn, lastIn + data_size, pt.begin()))
+    {
+        throw std::runtime_error(label + ": decrypted buffer does not match the input");
     }
 
     Stats st = computeStats(samples_ms);
@@ -199,7 +474,18 @@ void runPerfForFile(const std::string &filename,
     double throughput_MBps =
         (bytes_per_block / (1024.0 * 1024.0)) / mean_sec;
 
-    std::cout << "\n--- Statistics for file: " << filename << " ---\n";
+    const double ops = static_cast<double>(rounds_per_block) * blocks;
+    outResult.enc = phaseResult(sumEnc, ops, data_size);
+    outResult.dec = phaseResult(sumDec, ops, data_size);
+    // kernel: 1 lần mở rộng khoá / pad mỗi block
+    const double setupOps = e2e ? ops : blocks;
+    outResult.keyexp = phaseResult(sumKeyexp, setupOps, AES128::BlockSize);
+    if (padPhase)
+        outResult.pad = phaseResult(sumPad, setupOps, data_size);
+    outResult.enc_mean_ms = encMs / blocks;
+    outResult.dec_mean_ms = decMs / blocks;
+
+    std::cout << "\n--- Statistics for " << kind << ": " << label << " ---\n";
     std::cout << "Samples (blocks): " << blocks << "\n";
     std::cout << "Mean   : " << st.mean_ms << " ms\n";
     std::cout << "Median : " << st.median_ms << " ms\n";
@@ -209,15 +495,574 @@ void runPerfForFile(const std::string &filename,
     std::cout << "Throughput (mean, enc+dec): "
               << throughput_MBps << " MB/s\n";
 
+    auto printPhase = [&](const char *name, const PhaseResult &r, bool perByte)
+    {
+        std::cout << "  " << std::left << std::setw(7) << name << std::right << ": "
+                  << r.ns_per_op << " ns";
+        if (perByte)
+            std::cout << ", " << r.ns_per_block << " ns/block";
+        if (cycleCounterAvailable())
+        {
+            if (perByte)
+                std::cout << ", " << r.cycles_per_byte << " cycles/byte";
+            else
+                std::cout << ", " << r.cycles_per_op << " cycles";
+        }
+        std::cout << "\n";
+    };
+    std::cout << "Per call (mean):\n";
+    printPhase("enc", outResult.enc, true);
+    printPhase("dec", outResult.dec, true);
+    printPhase("keyexp", outResult.keyexp, false);
+    if (padPhase)
+        printPhase("pad", outResult.pad, true);
+
+    if (counters)
+    {
+        // mỗi round xử lý data_size / 16 block (mỗi block được enc rồi dec)
+        const double aesBlocks = ops * static_cast<double>(data_size / AES128::BlockSize);
+        const double cycles = hw[static_cast<int>(HwCounter::Cycles)];
+        const double instructions = hw[static_cast<int>(HwCounter::Instructions)];
+        if (counters->has(HwCounter::Cycles))
+            outResult.hw_cycles_per_byte = cycles / (ops * static_cast<double>(data_size));
+        if (counters->has(HwCounter::Cycles) && counters->has(HwCounter::Instructions) && cycles > 0)
+            outResult.ipc = instructions / cycles;
+        if (counters->has(HwCounter::L1dMisses))
+            outResult.l1d_misses_per_block = hw[static_cast<int>(HwCounter::L1dMisses)] / aesBlocks;
+        if (counters->has(HwCounter::BranchMisses))
+            outResult.branch_misses_per_block = hw[static_cast<int>(HwCounter::BranchMisses)] / aesBlocks;
+
+        std::cout << "Counters (whole round, per 16-byte block):\n";
+        auto printCounter = [&](HwCounter c, const char *label, double v)
+        {
+            std::cout << "  " << std::left << std::setw(14) << label << std::right << ": ";
+            if (counters->has(c))
+                std::cout << v << "\n";
+            else
+                std::cout << "n/a\n";
+        };
+        printCounter(HwCounter::Instructions, "IPC", outResult.ipc);
+        printCounter(HwCounter::Cycles, "cycles/byte", outResult.hw_cycles_per_byte);
+        printCounter(HwCounter::L1dMisses, "L1D misses", outResult.l1d_misses_per_block);
+        printCounter(HwCounter::BranchMisses, "branch misses", outResult.branch_misses_per_block);
+    }
+
     // điền vào outResult để ghi CSV
-    outResult.filename = filename;
+    outResult.filename = label;
+    outResult.measure = measureName(measure);
+    outResult.backend = AES128::backendName(AES128::defaultBackend());
+    outResult.mode = mode;
     outResult.size_bytes = data_size;
     outResult.rounds_per_block = rounds_per_block;
     outResult.blocks = blocks;
     outResult.stats = st;
+    outResult.samples_ms = samples_ms;
     outResult.throughput_MBps = throughput_MBps;
 }
 
+void runPerfForFile(const std::string &filename,
+                    const uint8_t key[16],
+                    const uint8_t iv[16],
+                    const std::string &mode,
+                    Measure measure,
+                    int rounds_per_block,
+                    double sampleMs,
+                    int blocks,
+                    HwCounters *counters,
+                    PerfResult &outResult)
+{
+    std::vector<uint8_t> data = readWholeFile(filename);
+    runPerfForBuffer("File", filename, data.data(), data.size(), data.size(), key, iv, mode, measure,
+                     rounds_per_block, sampleMs, blocks, counters, outResult);
+}
+
+// ==== workload tổng hợp trong bộ nhớ (--sizes) ====
+
+const std::size_t PageSize = 4096;
+
+// "64K" -> 65536, "1M" -> 1048576 (K / M / G = 1024^n, không phân biệt hoa thường)
+std::size_t parseSize(const std::string &s)
+{
+    char *end = nullptr;
+    unsigned long long n = std::strtoull(s.c_str(), &end, 10);
+    if (end == s.c_str())
+    {
+        throw std::runtime_error("Invalid size: " + s);
+    }
+    std::string suffix(end);
+    if (suffix == "k" || suffix == "K")
+        n <<= 10;
+    else if (suffix == "m" || suffix == "M")
+        n <<= 20;
+    else if (suffix == "g" || suffix == "G")
+        n <<= 30;
+    else if (!suffix.empty())
+    {
+        throw std::runtime_error("Invalid size: " + s);
+    }
+    return static_cast<std::size_t>(n);
+}
+
+// 65536 -> "64K" (ngược với parseSize)
+std::string formatSize(std::size_t n)
+{
+    if (n >= (std::size_t(1) << 20) && n % (std::size_t(1) << 20) == 0)
+        return std::to_string(n >> 20) + "M";
+    if (n >= 1024 && n % 1024 == 0)
+        return std::to_string(n >> 10) + "K";
+    return std::to_string(n);
+}
+
+// Dung lượng cache cấp cuối (L3, không có thì L2); 0 nếu không biết
+std::size_t lastLevelCacheBytes()
+{
+#if defined(_SC_LEVEL3_CACHE_SIZE)
+    long l3 = sysconf(_SC_LEVEL3_CACHE_SIZE);
+    if (l3 > 0)
+        return static_cast<std::size_t>(l3);
+    long l2 = sysconf(_SC_LEVEL2_CACHE_SIZE);
+    if (l2 > 0)
+        return static_cast<std::size_t>(l2);
+#endif
+    return 0;
+}
+
+// Buffer ngẫu nhiên len byte, bắt đầu ở offset byte sau 1 biên trang
+struct SyntheticBuffer
+{
+    std::vector<uint8_t> storage;
+    uint8_t *data = nullptr;
+};
+
+SyntheticBuffer makeSyntheticBuffer(std::size_t len, std::size_t offset, uint64_t seed)
+{
+    SyntheticBuffer b;
+    b.storage.resize(len + PageSize + offset);
+    uintptr_t p = reinterpret_cast<uintptr_t>(b.storage.data());
+    b.data = b.storage.data() + ((PageSize - p % PageSize) % PageSize) + offset;
+
+    std::mt19937_64 rng(seed);
+    std::size_t i = 0;
+    for (; i + 8 <= len; i += 8)
+    {
+        uint64_t r = rng();
+        std::memcpy(b.data + i, &r, 8);
+    }
+    for (; i < len; ++i)
+        b.data[i] = static_cast<uint8_t>(rng());
+    return b;
+}
+
+// 1 kích thước message, buffer bắt đầu ở page + offset byte. workingSet > 0: các message
+// nằm liên tiếp trong buffer >= workingSet byte và được dùng vòng tròn (đo băng thông bộ nhớ);
+// workingSet = 0: luôn dùng 1 message (nằm sẵn trong cache).
+void runPerfForSize(std::size_t size,
+                    std::size_t offset,
+                    std::size_t workingSet,
+                    const uint8_t key[16],
+                    const uint8_t iv[16],
+                    const std::string &mode,
+                    Measure measure,
+                    int rounds_per_block,
+                    double sampleMs,
+                    int blocks,
+                    HwCounters *counters,
+                    PerfResult &outResult)
+{
+    const std::size_t messages = workingSet > size ? (workingSet + size - 1) / size : 1;
+    const std::size_t span = messages * size;
+    SyntheticBuffer buf = makeSyntheticBuffer(span, offset, size);
+
+    std::string label = formatSize(size);
+    if (offset)
+        label += "+" + std::to_string(offset);
+    if (messages > 1)
+        label += " ws" + formatSize(span);
+
+    runPerfForBuffer("Buffer", label, buf.data, size, span, key, iv, mode, measure, rounds_per_block,
+                     sampleMs, blocks, counters, outResult);
+}
+
+// ==== latency từng message (--latency) ====
+
+// Kích thước mặc định: 16 B .. 64 KB, mỗi bước x4
+const std::vector<std::size_t> DefaultLatencySizes = {16, 64, 256, 1024, 4096, 16384, 65536};
+
+// Mã hoá (enc) từng message size byte cho tới khi đủ maxSamples mẫu hoặc hết maxSeconds,
+// mỗi mẫu là 1 lần gọi, ghi vào histogram (ns). Buffer và key schedule chuẩn bị trước;
+// message nằm sẵn trong cache (đo độ trễ của phần mã hoá, không phải của bộ nhớ).
+// Đồng hồ: rdtsc nếu có (rẻ hơn steady_clock nhiều), trừ đi chi phí của chính phép đo.
+void runLatencyForSize(std::size_t size,
+                       const uint8_t key[16],
+                       const uint8_t iv[16],
+                       const std::string &mode,
+                       uint64_t maxSamples,
+                       double maxSeconds,
+                       std::vector<PerfResult> &results)
+{
+    using clock = std::chrono::steady_clock;
+
+    AES128 aes(key);
+    std::mt19937_64 rng(size);
+    std::vector<uint8_t> in(size), out(size + GcmTagSize);
+    for (auto &b : in)
+        b = static_cast<uint8_t>(rng());
+
+    auto encryptMessage = [&]()
+    {
+        if (mode == "ctr")
+        {
+            ctrCrypt(aes, iv, 0, in.data(), out.data(), size);
+        }
+        else if (mode == "gcm")
+        {
+            GcmEncryptor enc(aes, iv, 12);
+            std::size_t n = enc.update(in.data(), size, out.data());
+            enc.final(out.data() + n);
+        }
+        else
+        {
+            cbcEncryptNoPad(in.data(), size, out.data(), aes, iv);
+        }
+    };
+
+    const bool tsc = cycleCounterAvailable();
+    const double ghz = tsc ? cycleCounterGHz() : 1.0;
+    auto now = [&]() -> uint64_t
+    {
+        if (tsc)
+            return readCycleCounter();
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                         clock::now().time_since_epoch())
+                                         .count());
+    };
+
+    // chi phí của 2 lần đọc đồng hồ liền nhau (lấy min)
+    uint64_t overhead = ~uint64_t(0);
+    for (int i = 0; i < 10000; ++i)
+    {
+        uint64_t t0 = now();
+        uint64_t t1 = now();
+        overhead = std::min(overhead, t1 - t0);
+    }
+
+    // warm-up ~0.2 s
+    auto start = clock::now();
+    while (clock::now() - start < std::chrono::milliseconds(200))
+        encryptMessage();
+
+    LatencyHistogram hist;
+    start = clock::now();
+    for (uint64_t i = 0; i < maxSamples; ++i)
+    {
+        uint64_t t0 = now();
+        encryptMessage();
+        uint64_t t1 = now();
+        uint64_t ticks = t1 - t0 > overhead ? t1 - t0 - overhead : 0;
+        hist.record(static_cast<uint64_t>(static_cast<double>(ticks) / ghz + 0.5));
+
+        if ((i & 1023) == 1023 &&
+            std::chrono::duration<double>(clock::now() - start).count() >= maxSeconds)
+            break;
+    }
+
+    const uint64_t n = hist.count();
+    const double mean_ns = hist.mean();
+    const double sd_ns = hist.stddev();
+    const double margin = n > 1 ? studentTQuantile(0.975, static_cast<double>(n - 1)) * sd_ns /
+                                      std::sqrt(static_cast<double>(n))
+                                : 0.0;
+
+    PerfResult res;
+    res.filename = std::to_string(size) + " B";
+    res.backend = AES128::backendName(AES128::defaultBackend());
+    res.mode = mode + "-latency";
+    res.size_bytes = size;
+    res.rounds_per_block = 1;
+    res.blocks = static_cast<int>(std::min<uint64_t>(n, 2147483647));
+    res.stats = Stats{mean_ns / 1e6, hist.percentile(0.5) / 1e6, sd_ns / 1e6,
+                      (mean_ns - margin) / 1e6, (mean_ns + margin) / 1e6};
+    res.throughput_MBps = static_cast<double>(size) / (1024.0 * 1024.0) / (mean_ns / 1e9);
+    res.latency_buckets = hist.buckets();
+    res.p50_ns = hist.percentile(0.50);
+    res.p90_ns = hist.percentile(0.90);
+    res.p99_ns = hist.percentile(0.99);
+    res.p999_ns = hist.percentile(0.999);
+    res.max_ns = static_cast<double>(hist.max());
+    results.push_back(res);
+
+    double lo99, hi99;
+    hist.percentileCi(0.99, lo99, hi99);
+    std::cout << std::right << std::setw(8) << size << std::setw(10) << n << std::fixed
+              << std::setprecision(1) << std::setw(10) << mean_ns << std::setw(10) << res.p50_ns
+              << std::setw(10) << res.p90_ns << std::setw(10) << res.p99_ns << std::setw(10)
+              << res.p999_ns << std::setw(12) << res.max_ns << "   [" << lo99 << ", " << hi99 << "]\n";
+    std::cout.unsetf(std::ios::floatfield);
+    std::cout << std::setprecision(6);
+}
+
+// ==== scaling đa luồng (--threads 1,2,4,...) ====
+
+// CPU được phép chạy (theo affinity của process), để pin thread i vào CPU thứ i
+std::vector<int> allowedCpus()
+{
+    std::vector<int> cpus;
+#if defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) == 0)
+    {
+        for (int c = 0; c < CPU_SETSIZE; ++c)
+        {
+            if (CPU_ISSET(c, &set))
+                cpus.push_back(c);
+        }
+    }
+#endif
+    return cpus;
+}
+
+bool pinCurrentThread(int cpu)
+{
+#if defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+    (void)cpu;
+    return false;
+#endif
+}
+
+// Chạy work(t) trên nthreads thread cùng xuất phát; trả về ms từ lúc xuất phát
+// tới khi thread chậm nhất xong. pinCpus không rỗng: thread t chạy trên pinCpus[t % size].
+template <typename Work>
+double runTogether(int nthreads, const std::vector<int> &pinCpus, Work work)
+{
+    using clock = std::chrono::steady_clock;
+    std::atomic<int> ready{0};
+    std::atomic<bool> go{false};
+    std::vector<clock::time_point> ends(nthreads);
+    std::vector<std::thread> threads;
+
+    for (int t = 0; t < nthreads; ++t)
+    {
+        threads.emplace_back([&, t]()
+                             {
+                                 if (!pinCpus.empty())
+                                     pinCurrentThread(pinCpus[t % pinCpus.size()]);
+                                 ++ready;
+                                 while (!go.load(std::memory_order_acquire))
+                                     std::this_thread::yield();
+                                 work(t);
+                                 ends[t] = clock::now(); });
+    }
+    while (ready.load() < nthreads)
+        std::this_thread::yield();
+    auto start = clock::now();
+    go.store(true, std::memory_order_release);
+    for (auto &th : threads)
+        th.join();
+
+    auto last = *std::max_element(ends.begin(), ends.end());
+    return std::chrono::duration<double, std::milli>(last - start).count();
+}
+
+// Mỗi file, mỗi số thread, 2 workload (CBC không padding, key schedule dùng chung):
+//   cbc-streams: mỗi thread enc + dec buffer riêng (như N request độc lập)
+//   cbc-pardec : 1 chain CBC, ciphertext chia đều cho N thread giải mã song song
+// rounds lượt mỗi mẫu được chọn để mỗi thread xử lý ~ScalingBytesPerSample byte.
+void runScalingForFile(const std::string &filename,
+                       const uint8_t key[16],
+                       const uint8_t iv[16],
+                       const std::vector<int> &threadCounts,
+                       const std::vector<int> &pinCpus,
+                       int blocks,
+                       std::vector<PerfResult> &results)
+{
+    const std::size_t ScalingBytesPerSample = 64 * 1024 * 1024;
+
+    std::vector<uint8_t> data = readWholeFile(filename);
+    const std::size_t size = data.size();
+    if (size == 0 || size % 16 != 0)
+    {
+        throw std::runtime_error("File " + filename +
+                                 " size must be non-empty and multiple of 16 bytes");
+    }
+    const int rounds = static_cast<int>(std::max<std::size_t>(1, ScalingBytesPerSample / size));
+    const std::string backend = AES128::backendName(AES128::defaultBackend());
+
+    AES128 aes(key);
+    std::vector<uint8_t> chain(size);
+    cbcEncryptNoPad(data.data(), size, chain.data(), aes, iv);
+
+    std::cout << "\n=== Scaling: " << filename << " (" << size << " bytes, "
+              << rounds << " rounds / thread / sample) ===\n";
+    std::cout << std::left << std::setw(14) << "Workload" << std::right << std::setw(8) << "Threads"
+              << std::setw(14) << "MB/s" << std::setw(14) << "MB/s/thread" << std::setw(12) << "Efficiency"
+              << "\n";
+
+    for (const std::string workload : {"cbc-streams", "cbc-pardec"})
+    {
+        double basePerThread = 0;
+        for (int n : threadCounts)
+        {
+            // buffer cấp trước ngoài vùng đo
+            std::vector<std::vector<uint8_t>> ct(n, std::vector<uint8_t>(size));
+            std::vector<std::vector<uint8_t>> pt(n, std::vector<uint8_t>(size));
+            std::vector<uint8_t> plain(size);
+
+            auto streams = [&](int t)
+            {
+                for (int r = 0; r < rounds; ++r)
+                {
+                    cbcEncryptNoPad(data.data(), size, ct[t].data(), aes, iv);
+                    cbcDecryptNoPad(ct[t].data(), size, pt[t].data(), aes, iv);
+                }
+            };
+            // block [first, last) của chain; IV = ciphertext block ngay trước
+            auto pardec = [&](int t)
+            {
+                const std::size_t nblocks = size / AES128::BlockSize;
+                std::size_t first = nblocks * t / n, last = nblocks * (t + 1) / n;
+                if (first == last)
+                    return;
+                const uint8_t *prev = first == 0 ? iv : chain.data() + (first - 1) * AES128::BlockSize;
+                for (int r = 0; r < rounds; ++r)
+                {
+                    cbcDecryptNoPad(chain.data() + first * AES128::BlockSize,
+                                    (last - first) * AES128::BlockSize,
+                                    plain.data() + first * AES128::BlockSize, aes, prev);
+                }
+            };
+            const bool isStreams = workload == "cbc-streams";
+            auto sample = [&]()
+            {
+                return isStreams ? runTogether(n, pinCpus, streams) : runTogether(n, pinCpus, pardec);
+            };
+
+            sample(); // warm-up: tạo thread, nạp cache / TLB
+            std::vector<double> samples_ms;
+            for (int b = 0; b < blocks; ++b)
+                samples_ms.push_back(sample());
+
+            if (!isStreams && plain != data)
+            {
+                throw std::runtime_error("Parallel CBC decrypt produced wrong plaintext");
+            }
+
+            Stats st = computeStats(samples_ms);
+            // streams: mỗi thread xử lý enc + dec; pardec: cả nhóm giải mã 1 buffer
+            double bytes = static_cast<double>(rounds) * static_cast<double>(size) *
+                           (isStreams ? n : 1);
+            double mbps = bytes / (1024.0 * 1024.0) / (st.mean_ms / 1000.0);
+            double perThread = mbps / n;
+            if (basePerThread == 0)
+                basePerThread = perThread;
+
+            PerfResult res;
+            res.filename = filename;
+            res.backend = backend;
+            res.mode = workload;
+            res.size_bytes = size;
+            res.rounds_per_block = rounds;
+            res.blocks = blocks;
+            res.stats = st;
+            res.samples_ms = samples_ms;
+            res.throughput_MBps = mbps;
+            res.threads = n;
+            res.efficiency = perThread / basePerThread;
+            results.push_back(res);
+
+            std::cout << std::left << std::setw(14) << workload << std::right << std::setw(8) << n
+                      << std::fixed << std::setprecision(1) << std::setw(14) << mbps
+                      << std::setw(14) << perThread << std::setprecision(3) << std::setw(12)
+                      << res.efficiency << "\n";
+            std::cout.unsetf(std::ios::floatfield);
+            std::cout << std::setprecision(6);
+        }
+    }
+}
+
+// ==== I/O benchmark (--io-bench) ====
+
+// Mã hoá CBC nfiles file size byte bằng cipherFilesBulk, mỗi backend I/O 1 lượt đo.
+// File tạm nằm trong dir, bị xoá sau khi đo. Throughput = byte input / giây.
+// Lưu ý: file vừa ghi còn trong page cache, muốn đo đĩa thật thì tăng tổng dung lượng
+// vượt RAM hoặc drop cache giữa các lượt.
+void runIoBench(const uint8_t key[16], const uint8_t iv[16],
+                const std::vector<IoBackend> &ioBackends,
+                std::size_t nfiles, std::size_t size, int samples,
+                const std::string &dir, std::vector<PerfResult> &results)
+{
+    std::vector<BulkFileJob> jobs;
+    std::mt19937_64 rng(12345);
+    std::vector<uint8_t> data(size);
+    for (std::size_t i = 0; i < nfiles; ++i)
+    {
+        BulkFileJob job;
+        job.inPath = dir + "/aes_perf_io_" + std::to_string(i) + ".bin";
+        job.outPath = job.inPath + ".enc";
+        for (auto &b : data)
+            b = static_cast<uint8_t>(rng());
+        OutputFile out(job.inPath, size);
+        std::copy(data.begin(), data.end(), out.data());
+        out.commit(size);
+        jobs.push_back(job);
+    }
+
+    AES128 aes(key);
+    CipherFactory factory = [&]()
+    { return makePipelineCipher(std::make_shared<CbcEncryptor>(aes, iv)); };
+
+    const std::string label = std::to_string(nfiles) + " files x " + std::to_string(size) + " B";
+    std::cout << "\n=== I/O: " << label << " (CBC enc, dir " << dir << ") ===\n";
+
+    for (IoBackend b : ioBackends)
+    {
+        BulkIoOptions opt;
+        opt.backend = b;
+        cipherFilesBulk(jobs, factory, opt); // warm-up: page cache, tạo file output
+
+        std::vector<double> samples_ms;
+        for (int i = 0; i < samples; ++i)
+        {
+            BulkIoResult r = cipherFilesBulk(jobs, factory, opt);
+            samples_ms.push_back(r.seconds * 1000.0);
+            std::cout << "  " << ioBackendName(b) << " sample " << (i + 1) << ": "
+                      << r.seconds * 1000.0 << " ms\n";
+        }
+
+        Stats st = computeStats(samples_ms);
+        double totalMB = static_cast<double>(nfiles) * static_cast<double>(size) / (1024.0 * 1024.0);
+
+        PerfResult res;
+        res.filename = label;
+        res.backend = AES128::backendName(AES128::defaultBackend());
+        res.mode = std::string("cbc-io-") + ioBackendName(b);
+        res.measure = "e2e";
+        res.size_bytes = nfiles * size;
+        res.rounds_per_block = 1;
+        res.blocks = samples;
+        res.threads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+        res.stats = st;
+        res.samples_ms = samples_ms;
+        res.throughput_MBps = totalMB / (st.mean_ms / 1000.0);
+        results.push_back(res);
+
+        std::cout << "  " << ioBackendName(b) << ": mean " << st.mean_ms << " ms, 95% CI ["
+                  << st.ci_low_ms << ", " << st.ci_high_ms << "] ms, "
+                  << res.throughput_MBps << " MB/s\n";
+    }
+
+    for (const auto &job : jobs)
+    {
+        std::remove(job.inPath.c_str());
+        std::remove(job.outPath.c_str());
+    }
+}
+
 // ==== ghi CSV ====
 
 void writeCsv(const std::string &path,
@@ -231,7 +1076,22 @@ void writeCsv(const std::string &path,
 
     // Header
     ofs << "File,SizeBytes,RoundsPerBlock,Blocks,"
-        << "MeanMs,MedianMs,StddevMs,CILowMs,CIHighMs,ThroughputMBps\n";
+        << "MeanMs,MedianMs,StddevMs,CILowMs,CIHighMs,ThroughputMBps,"
+        << "Backend,Mode,"
+        << "EncMeanMs,DecMeanMs,EncNsPerBlock,DecNsPerBlock,EncCyclesPerByte,DecCyclesPerByte,"
+        << "KeyExpNs,KeyExpCycles,PadNs,PadCyclesPerByte,TscGHz,"
+        << "Threads,PerThreadMBps,ScalingEfficiency,"
+        << "P50Ns,P90Ns,P99Ns,P999Ns,MaxNs,"
+        << "IPC,HwCyclesPerByte,L1DMissesPerBlock,BranchMissesPerBlock,"
+        << "Measure\n";
+
+    // phase không đo (vd. pad của ctr / gcm): để trống, không ghi 0
+    auto phaseField = [&](const PhaseResult &p, double value)
+    {
+        ofs << ",";
+        if (p.measured)
+            ofs << value;
+    };
 
     for (const auto &r : results)
     {
@@ -245,19 +1105,477 @@ void writeCsv(const std::string &path,
             << "," << r.stats.ci_low_ms
             << "," << r.stats.ci_high_ms
             << "," << r.throughput_MBps
+            << "," << r.backend
+            << "," << r.mode
+            << "," << r.enc_mean_ms
+            << "," << r.dec_mean_ms;
+        phaseField(r.enc, r.enc.ns_per_block);
+        phaseField(r.dec, r.dec.ns_per_block);
+        phaseField(r.enc, r.enc.cycles_per_byte);
+        phaseField(r.dec, r.dec.cycles_per_byte);
+        phaseField(r.keyexp, r.keyexp.ns_per_op);
+        phaseField(r.keyexp, r.keyexp.cycles_per_op);
+        phaseField(r.pad, r.pad.ns_per_op);
+        phaseField(r.pad, r.pad.cycles_per_byte);
+        ofs << "," << cycleCounterGHz()
+            << "," << r.threads
+            << "," << r.throughput_MBps / r.threads
+            << "," << r.efficiency
+            << "," << r.p50_ns
+            << "," << r.p90_ns
+            << "," << r.p99_ns
+            << "," << r.p999_ns
+            << "," << r.max_ns
+            << "," << r.ipc
+            << "," << r.hw_cycles_per_byte
+            << "," << r.l1d_misses_per_block
+            << "," << r.branch_misses_per_block
+            << "," << r.measure
             << "\n";
     }
 
     std::cout << "\nCSV results written to: " << path << "\n";
 }
 
+// ==== ghi JSON (--json) ====
+
+std::string jsonString(const std::string &s)
+{
+    std::string out = "\"";
+    for (char c : s)
+    {
+        unsigned char u = static_cast<unsigned char>(c);
+        if (c == '"' || c == '\\')
+        {
+            out += '\\';
+            out += c;
+        }
+        else if (u < 0x20)
+        {
+            char buf[8];
+            std::snprintf(buf, sizeof(buf), "\\u%04x", u);
+            out += buf;
+        }
+        else
+        {
+            out += c;
+        }
+    }
+    return out + "\"";
+}
+
+// JSON không có NaN / Inf
+std::string jsonNumber(double v)
+{
+    if (!std::isfinite(v))
+        return "null";
+    std::ostringstream oss;
+    oss << std::setprecision(10) << v;
+    return oss.str();
+}
+
+// Toàn bộ kết quả + môi trường chạy, để so sánh giữa các máy.
+// writeCsv giữ nguyên định dạng cũ; file JSON có thêm mọi mẫu (block) và histogram latency.
+void writeJson(const std::string &path,
+               int argc, char *argv[],
+               const std::vector<PerfResult> &results)
+{
+    std::ofstream ofs(path);
+    if (!ofs)
+    {
+        throw std::runtime_error("Cannot open JSON file for writing: " + path);
+    }
+
+    const PerfEnvironment env = capturePerfEnvironment();
+    std::string command;
+    for (int i = 0; i < argc; ++i)
+    {
+        if (i)
+            command += ' ';
+        command += argv[i];
+    }
+    auto flag = [](bool b)
+    { return b ? "true" : "false"; };
+
+    ofs << "{\n"
+        << "  \"tool\": \"aes_perf\",\n"
+        << "  \"command\": " << jsonString(command) << ",\n"
+        << "  \"environment\": {\n"
+        << "    \"timestamp\": " << jsonString(env.timestamp) << ",\n"
+        << "    \"hostname\": " << jsonString(env.hostname) << ",\n"
+        << "    \"os\": " << jsonString(env.os) << ",\n"
+        << "    \"cpu_model\": " << jsonString(env.cpu_model) << ",\n"
+        << "    \"logical_cpus\": " << env.logical_cpus << ",\n"
+        << "    \"cpu_flags\": {\"aes\": " << flag(env.aesni) << ", \"pclmul\": " << flag(env.pclmul)
+        << ", \"avx2\": " << flag(env.avx2) << ", \"sse4_1\": " << flag(env.sse41) << "},\n"
+        << "    \"governor\": " << jsonString(env.governor) << ",\n"
+        << "    \"tsc_ghz\": " << jsonNumber(cycleCounterGHz()) << ",\n"
+        << "    \"compiler\": " << jsonString(env.compiler) << ",\n"
+        << "    \"build_flags\": " << jsonString(env.build_flags) << ",\n"
+        << "    \"build_flags_known\": " << flag(env.build_flags_known) << ",\n"
+        << "    \"git_hash\": " << jsonString(env.git_hash) << ",\n"
+        << "    \"git_hash_known\": " << flag(env.git_hash_known) << "\n"
+        << "  },\n"
+        << "  \"results\": [";
+
+    for (std::size_t i = 0; i < results.size(); ++i)
+    {
+        const PerfResult &r = results[i];
+        auto phase = [&](const PhaseResult &p) -> std::string
+        {
+            if (!p.measured)
+                return "null";
+            return "{\"ns_per_op\": " + jsonNumber(p.ns_per_op) + ", \"ns_per_block\": " +
+                   jsonNumber(p.ns_per_block) + ", \"cycles_per_op\": " + jsonNumber(p.cycles_per_op) +
+                   ", \"cycles_per_byte\": " + jsonNumber(p.cycles_per_byte) + "}";
+        };
+
+        ofs << (i ? "," : "") << "\n    {\n"
+            << "      \"name\": " << jsonString(r.filename) << ",\n"
+            << "      \"backend\": " << jsonString(r.backend) << ",\n"
+            << "      \"mode\": " << jsonString(r.mode) << ",\n"
+            << "      \"measure\": " << jsonString(r.measure) << ",\n"
+            << "      \"size_bytes\": " << r.size_bytes << ",\n"
+            << "      \"rounds_per_block\": " << r.rounds_per_block << ",\n"
+            << "      \"blocks\": " << r.blocks << ",\n"
+            << "      \"threads\": " << r.threads << ",\n"
+            << "      \"stats\": {\"mean_ms\": " << jsonNumber(r.stats.mean_ms)
+            << ", \"median_ms\": " << jsonNumber(r.stats.median_ms)
+            << ", \"stddev_ms\": " << jsonNumber(r.stats.stddev_ms)
+            << ", \"ci95_low_ms\": " << jsonNumber(r.stats.ci_low_ms)
+            << ", \"ci95_high_ms\": " << jsonNumber(r.stats.ci_high_ms) << "},\n"
+            << "      \"throughput_mbps\": " << jsonNumber(r.throughput_MBps) << ",\n"
+            << "      \"scaling_efficiency\": " << jsonNumber(r.efficiency) << ",\n"
+            << "      \"phases\": {\"enc\": " << phase(r.enc) << ", \"dec\": " << phase(r.dec)
+            << ", \"keyexp\": " << phase(r.keyexp) << ", \"pad\": " << phase(r.pad) << "},\n"
+            << "      \"counters\": {\"ipc\": " << jsonNumber(r.ipc)
+            << ", \"cycles_per_byte\": " << jsonNumber(r.hw_cycles_per_byte)
+            << ", \"l1d_misses_per_block\": " << jsonNumber(r.l1d_misses_per_block)
+            << ", \"branch_misses_per_block\": " << jsonNumber(r.branch_misses_per_block) << "},\n"
+            << "      \"latency_ns\": {\"p50\": " << jsonNumber(r.p50_ns) << ", \"p90\": " << jsonNumber(r.p90_ns)
+            << ", \"p99\": " << jsonNumber(r.p99_ns) << ", \"p999\": " << jsonNumber(r.p999_ns)
+            << ", \"max\": " << jsonNumber(r.max_ns) << "},\n";
+
+        ofs << "      \"samples_ms\": [";
+        for (std::size_t k = 0; k < r.samples_ms.size(); ++k)
+            ofs << (k ? ", " : "") << jsonNumber(r.samples_ms[k]);
+        ofs << "],\n";
+
+        // --latency: mỗi mẫu 1 lần gọi, quá nhiều để ghi từng cái; ghi histogram [ns, số mẫu]
+        ofs << "      \"latency_histogram\": [";
+        for (std::size_t k = 0; k < r.latency_buckets.size(); ++k)
+            ofs << (k ? ", " : "") << "[" << jsonNumber(r.latency_buckets[k].first) << ", "
+                << r.latency_buckets[k].second << "]";
+        ofs << "]\n    }";
+    }
+    ofs << "\n  ]\n}\n";
+
+    std::cout << "\nJSON results written to: " << path << "\n";
+}
+
+// ==== so sánh với baseline (--baseline) ====
+
+// 1 dòng kết quả của lần chạy trước (chỉ các cột cần cho so sánh)
+struct BaselineRow
+{
+    std::string filename;
+    std::size_t size_bytes = 0;
+    std::string backend; // rỗng: file cũ không có cột Backend, khớp mọi backend
+    std::string mode = "cbc";
+    std::string measure; // cột Measure; file cũ không có cột này: xem readBaselineCsv
+    double rounds_per_block = 0;
+    double blocks = 0;
+    double mean_ms = 0;
+    double stddev_ms = 0;
+};
+
+// Tách 1 dòng CSV; field trong "..." được giữ nguyên dấu phẩy, "" = dấu nháy
+std::vector<std::string> splitCsvLine(const std::string &line)
+{
+    std::vector<std::string> fields(1);
+    bool quoted = false;
+    for (std::size_t i = 0; i < line.size(); ++i)
+    {
+        char c = line[i];
+        if (quoted)
+        {
+            if (c == '"' && i + 1 < line.size() && line[i + 1] == '"')
+            {
+                fields.back() += '"';
+                ++i;
+            }
+            else if (c == '"')
+                quoted = false;
+            else
+                fields.back() += c;
+        }
+        else if (c == '"')
+            quoted = true;
+        else if (c == ',')
+            fields.emplace_back();
+        else if (c != '\r')
+            fields.back() += c;
+    }
+    return fields;
+}
+
+// Đọc bảng kết quả đầu tiên của file CSV (từ writeCsv hoặc file ghép tay kiểu perf_results.csv):
+// cột tìm theo tên ở dòng header, cột không tên (",,,") và cột lạ bị bỏ qua, bảng kết thúc
+// ở dòng trống. Dòng thiếu số liệu bị bỏ qua.
+std::vector<BaselineRow> readBaselineCsv(const std::string &path)
+{
+    std::ifstream ifs(path);
+    if (!ifs)
+    {
+        throw std::runtime_error("Cannot open baseline CSV: " + path);
+    }
+
+    std::string line;
+    if (!std::getline(ifs, line))
+    {
+        throw std::runtime_error("Baseline CSV is empty: " + path);
+    }
+    std::vector<std::string> header = splitCsvLine(line);
+    auto column = [&](const std::string &name) -> int
+    {
+        for (std::size_t i = 0; i < header.size(); ++i)
+        {
+            if (header[i] == name)
+                return static_cast<int>(i);
+        }
+        return -1;
+    };
+    const int cFile = column("File"), cSize = column("SizeBytes"), cRounds = column("RoundsPerBlock"),
+              cBlocks = column("Blocks"), cMean = column("MeanMs"), cStddev = column("StddevMs"),
+              cBackend = column("Backend"), cMode = column("Mode"), cMeasure = column("Measure");
+    // Không có cột Measure: có cột KeyExpNs thì file ghi sau khi tách phase (MeanMs = enc + dec,
+    // như e2e bây giờ); không có thì là bản đầu, MeanMs gồm cả mở rộng khoá mỗi round: "legacy",
+    // không khớp measure nào
+    const std::string defaultMeasure = column("KeyExpNs") >= 0 ? "e2e" : "legacy";
+    if (cSize < 0 || cRounds < 0 || cBlocks < 0 || cMean < 0 || cStddev < 0)
+    {
+        throw std::runtime_error("Baseline CSV lacks SizeBytes/RoundsPerBlock/Blocks/MeanMs/StddevMs columns: " + path);
+    }
+
+    std::vector<BaselineRow> rows;
+    while (std::getline(ifs, line))
+    {
+        std::vector<std::string> f = splitCsvLine(line);
+        bool blank = true;
+        for (const auto &x : f)
+            blank = blank && x.find_first_not_of(" \t") == std::string::npos;
+        if (blank)
+            break; // hết bảng kết quả
+
+        auto text = [&](int c) -> std::string
+        { return c >= 0 && c < static_cast<int>(f.size()) ? f[c] : std::string(); };
+        auto number = [&](int c, double &out) -> bool
+        {
+            std::string t = text(c);
+            char *end = nullptr;
+            out = std::strtod(t.c_str(), &end);
+            return !t.empty() && end && *end == '\0';
+        };
+
+        BaselineRow row;
+        double size = 0;
+        if (!number(cSize, size) || !number(cRounds, row.rounds_per_block) || !number(cBlocks, row.blocks) ||
+            !number(cMean, row.mean_ms) || !number(cStddev, row.stddev_ms) || size <= 0 ||
+            row.rounds_per_block <= 0 || row.mean_ms <= 0)
+        {
+            std::cerr << "Warning: skipping baseline row: " << line << "\n";
+            continue;
+        }
+        row.size_bytes = static_cast<std::size_t>(size);
+        row.filename = text(cFile);
+        row.backend = text(cBackend);
+        if (!text(cMode).empty())
+            row.mode = text(cMode);
+        row.measure = text(cMeasure).empty() ? defaultMeasure : text(cMeasure);
+        rows.push_back(row);
+    }
+    if (rows.empty())
+    {
+        throw std::runtime_error("No usable rows in baseline CSV: " + path);
+    }
+    return rows;
+}
+
+// So sánh từng (size, backend, mode, measure) với baseline bằng Welch t-test trên thời gian / byte
+// (chuẩn hoá theo RoundsPerBlock * SizeBytes nên 2 lần chạy khác số round vẫn so được).
+// Regression: throughput giảm quá thresholdPct % và p < alpha. Trả về số regression,
+// matched = số kết quả tìm được dòng baseline để so.
+int compareWithBaseline(const std::vector<PerfResult> &results,
+                        const std::vector<BaselineRow> &baseline,
+                        double thresholdPct, double alpha, int &matched)
+{
+    matched = 0;
+    std::cout << "\n=== Baseline comparison (threshold " << thresholdPct << "%, alpha " << alpha << ") ===\n";
+    std::cout << std::left << std::setw(24) << "File" << std::setw(10) << "Backend" << std::setw(8) << "Mode"
+              << std::right << std::setw(12) << "Base MB/s" << std::setw(12) << "Now MB/s"
+              << std::setw(10) << "Change" << std::setw(10) << "p" << "  Verdict\n";
+
+    int regressions = 0;
+    for (const auto &r : results)
+    {
+        // ưu tiên dòng cùng tên (vd. 64K và 64K+1 cùng size), rồi dòng ghi rõ backend
+        // hơn dòng không có cột Backend
+        const BaselineRow *base = nullptr;
+        int bestScore = -1;
+        for (const auto &b : baseline)
+        {
+            if (b.size_bytes == r.size_bytes && b.mode == r.mode && b.measure == r.measure &&
+                (b.backend.empty() || b.backend == r.backend))
+            {
+                int score = (b.filename == r.filename ? 2 : 0) + (b.backend.empty() ? 0 : 1);
+                if (score > bestScore)
+                {
+                    base = &b;
+                    bestScore = score;
+                }
+            }
+        }
+
+        std::cout << std::left << std::setw(24) << r.filename << std::setw(10) << r.backend
+                  << std::setw(8) << r.mode << std::right;
+        if (!base)
+        {
+            std::cout << std::setw(12) << "-" << std::fixed << std::setprecision(1) << std::setw(12)
+                      << r.throughput_MBps << std::setw(10) << "-" << std::setw(10) << "-" << "  no baseline\n";
+            std::cout.unsetf(std::ios::floatfield);
+            std::cout << std::setprecision(6);
+            continue;
+        }
+        ++matched;
+
+        // ms / byte của 2 lần chạy
+        const double baseScale = base->rounds_per_block * static_cast<double>(base->size_bytes);
+        const double nowScale = static_cast<double>(r.rounds_per_block) * static_cast<double>(r.size_bytes);
+        WelchResult w = welchTTest(r.stats.mean_ms / nowScale, r.stats.stddev_ms / nowScale, r.blocks,
+                                   base->mean_ms / baseScale, base->stddev_ms / baseScale, base->blocks);
+        const double baseMBps = baseScale / (1024.0 * 1024.0) / (base->mean_ms / 1000.0);
+        const double change = (r.throughput_MBps / baseMBps - 1.0) * 100.0;
+        // không tính được p (quá ít mẫu): chỉ dựa vào ngưỡng
+        const bool significant = std::isnan(w.p) || w.p < alpha;
+
+        std::string verdict = "ok";
+        if (change < -thresholdPct && significant)
+        {
+            verdict = "REGRESSION";
+            ++regressions;
+        }
+        else if (change > thresholdPct && significant)
+            verdict = "improved";
+
+        std::cout << std::fixed << std::setprecision(1) << std::setw(12) << baseMBps << std::setw(12)
+                  << r.throughput_MBps << std::showpos << std::setw(9) << change << "%" << std::noshowpos;
+        if (std::isnan(w.p))
+            std::cout << std::setw(10) << "n/a";
+        else
+            std::cout << std::setprecision(4) << std::setw(10) << w.p;
+        std::cout << "  " << verdict << "\n";
+        std::cout.unsetf(std::ios::floatfield);
+        std::cout << std::setprecision(6);
+    }
+    std::cout << matched << " of " << results.size() << " result(s) matched a baseline row\n";
+    return regressions;
+}
+
+// ==== bảng so sánh backend ====
+
+// Mỗi file 1 dòng, mỗi backend 1 cột throughput (MB/s)
+void printBackendSummary(const std::vector<std::string> &files,
+                         const std::vector<std::string> &backends,
+                         const std::vector<PerfResult> &results)
+{
+    std::cout << "\n=== Throughput by backend (MB/s, enc+dec) ===\n";
+    std::cout << std::left << std::setw(24) << "File";
+    for (const auto &b : backends)
+        std::cout << std::right << std::setw(12) << b;
+    std::cout << "\n";
+
+    for (const auto &f : files)
+    {
+        std::cout << std::left << std::setw(24) << f;
+        for (const auto &b : backends)
+        {
+            double mbps = 0.0;
+            for (const auto &r : results)
+            {
+                if (r.filename == f && r.backend == b)
+                    mbps = r.throughput_MBps;
+            }
+            std::cout << std::right << std::setw(12) << std::fixed
+                      << std::setprecision(1) << mbps;
+        }
+        std::cout << "\n";
+    }
+    std::cout.unsetf(std::ios::floatfield);
+    std::cout << std::setprecision(6);
+}
+
+// "a,b,c" -> {"a", "b", "c"}
+std::vector<std::string> splitList(const std::string &s)
+{
+    std::vector<std::string> items;
+    std::size_t start = 0;
+    while (start <= s.size())
+    {
+        std::size_t comma = s.find(',', start);
+        if (comma == std::string::npos)
+            comma = s.size();
+        if (comma > start)
+            items.push_back(s.substr(start, comma - start));
+        start = comma + 1;
+    }
+    return items;
+}
+
 // ==== main perf ====
 
 void printUsagePerf()
 {
     std::cout
         << "Usage:\n"
-        << "  aes_perf --key-hex <32 hex> --iv-hex <32 hex> [--csv result.csv] file1.bin [file2.bin ...]\n"
+        << "  aes_perf --key-hex <32 hex> --iv-hex <32 hex> [--csv result.csv] [--backend <b>[,<b>...]] [--mode <m>] file1.bin [file2.bin ...]\n"
+        << "\n  --backend auto|byte|ttable|aesni|bitslice\n"
+        << "                                     AES engine(s) to benchmark (default: auto);\n"
+        << "                                     a list such as ttable,bitslice prints a side-by-side table\n"
+        << "  --mode cbc|ctr|gcm                 cipher mode (default: cbc; gcm dùng 12 byte đầu của iv)\n"
+        << "\n  aes_perf --key-hex <32 hex> --iv-hex <32 hex> --sizes 16,64,1K,...,64M [--misalign N]\n"
+        << "           [--working-set auto|<size>] [other options above] [file1.bin ...]\n"
+        << "                                     benchmark random in-memory buffers instead of (or next to)\n"
+        << "                                     files; each size runs page-aligned and at page + N bytes\n"
+        << "                                     (default 1, 0 = aligned only)\n"
+        << "  --working-set auto|<size>          cycle through messages in a buffer of this size (auto =\n"
+        << "                                     4 x last-level cache) to measure memory-bound throughput\n"
+        << "  --measure kernel|e2e               kernel (default): preallocated output, one key schedule;\n"
+        << "                                     e2e: per-call key expansion, padding and new vectors\n"
+        << "  --sample-ms <ms>                   calibrate rounds per block to this time (default 200)\n"
+        << "  --rounds N                         fixed rounds per block instead (1000 = old default)\n"
+        << "  --json out.json                    also write every sample, the stats and the environment (CPU,\n"
+        << "                                     flags, compiler, build flags, governor, git hash) as JSON\n"
+        << "  --baseline old.csv                 compare with an earlier CSV (Welch t-test per size / backend /\n"
+        << "                                     mode); exit code 2 if throughput drops by more than\n"
+        << "                                     --regression-threshold percent (default 5) with p < --alpha (0.05)\n"
+        << "                                     exit code 3 if no result matched a baseline row\n"
+        << "  --counters                         Linux: count cycles, instructions, L1D and branch misses\n"
+        << "                                     (perf_event_open) around each block; prints IPC and misses\n"
+        << "                                     per 16-byte block\n"
+        << "\n  aes_perf --key-hex <32 hex> --iv-hex <32 hex> --io-bench [--io blocking,uring] [--io-files N]\n"
+        << "           [--io-size <bytes>] [--io-dir <dir>] [--csv result.csv]\n"
+        << "                                     CBC-encrypt N temporary files (default 16 x 4 MB) with each\n"
+        << "                                     bulk I/O backend and compare throughput\n"
+        << "\n  aes_perf --key-hex <32 hex> --iv-hex <32 hex> --threads 1,2,4,8 [--pin] [--csv result.csv] file1.bin ...\n"
+        << "                                     CBC scaling: independent enc+dec streams (one per thread) and one\n"
+        << "                                     chain decrypted in parallel; prints MB/s, MB/s per thread and\n"
+        << "                                     efficiency vs the smallest thread count\n"
+        << "  --pin                              pin thread i to the i-th allowed CPU (Linux)\n"
+        << "\n  aes_perf --key-hex <32 hex> --iv-hex <32 hex> --latency [--sizes 16,64,...] [--mode <m>]\n"
+        << "           [--latency-samples N] [--latency-seconds S] [--csv result.csv]\n"
+        << "                                     time every single message encryption (default 16 B .. 64 KB,\n"
+        << "                                     up to 1000000 samples or 5 s per size); prints mean, p50, p90,\n"
+        << "                                     p99, p99.9, max (ns) and the 95% CI of p99\n"
         << "\nExample:\n"
         << "  aes_perf --key-hex 00112233445566778899aabbccddeeff \\\n"
         << "           --iv-hex  000102030405060708090a0b0c0d0e0f \\\n"
@@ -276,7 +1594,30 @@ int main(int argc, char *argv[])
     std::string keyHex;
     std::string ivHex;
     std::string csvPath;
+    std::string jsonPath;
+    std::string backendName = "auto";
+    std::string mode = "cbc";
     std::vector<std::string> files;
+    bool ioBench = false;
+    std::string ioList = "blocking,uring";
+    std::size_t ioFiles = 16;
+    std::size_t ioSize = 4 * 1024 * 1024;
+    std::string ioDir = ".";
+    std::string threadList;
+    bool latency = false;
+    bool useCounters = false;
+    std::string baselinePath;
+    double regressionThreshold = 5.0;
+    double alpha = 0.05;
+    std::string sizeList;
+    uint64_t latencySamples = 1000000;
+    double latencySeconds = 5.0;
+    bool pin = false;
+    std::size_t misalign = 1;
+    std::string measureArg = "kernel";
+    int rounds_per_block = 0; // 0: hiệu chỉnh theo sampleMs
+    double sampleMs = 200.0;
+    std::string workingSetArg;
 
     for (int i = 1; i < argc; ++i)
     {
@@ -294,6 +1635,98 @@ int main(int argc, char *argv[])
         {
             csvPath = argv[++i];
         }
+        else if (arg == "--json" && i + 1 < argc)
+        {
+            jsonPath = argv[++i];
+        }
+        else if (arg == "--backend" && i + 1 < argc)
+        {
+            backendName = argv[++i];
+        }
+        else if (arg == "--mode" && i + 1 < argc)
+        {
+            mode = argv[++i];
+        }
+        else if (arg == "--io-bench")
+        {
+            ioBench = true;
+        }
+        else if (arg == "--io" && i + 1 < argc)
+        {
+            ioList = argv[++i];
+        }
+        else if (arg == "--io-files" && i + 1 < argc)
+        {
+            ioFiles = static_cast<std::size_t>(std::strtoull(argv[++i], nullptr, 10));
+        }
+        else if (arg == "--io-size" && i + 1 < argc)
+        {
+            ioSize = static_cast<std::size_t>(std::strtoull(argv[++i], nullptr, 10));
+        }
+        else if (arg == "--io-dir" && i + 1 < argc)
+        {
+            ioDir = argv[++i];
+        }
+        else if (arg == "--threads" && i + 1 < argc)
+        {
+            threadList = argv[++i];
+        }
+        else if (arg == "--baseline" && i + 1 < argc)
+        {
+            baselinePath = argv[++i];
+        }
+        else if (arg == "--regression-threshold" && i + 1 < argc)
+        {
+            regressionThreshold = std::atof(argv[++i]);
+        }
+        else if (arg == "--alpha" && i + 1 < argc)
+        {
+            alpha = std::atof(argv[++i]);
+        }
+        else if (arg == "--counters")
+        {
+            useCounters = true;
+        }
+        else if (arg == "--latency")
+        {
+            latency = true;
+        }
+        else if (arg == "--sizes" && i + 1 < argc)
+        {
+            sizeList = argv[++i];
+        }
+        else if (arg == "--latency-samples" && i + 1 < argc)
+        {
+            latencySamples = std::strtoull(argv[++i], nullptr, 10);
+        }
+        else if (arg == "--latency-seconds" && i + 1 < argc)
+        {
+            latencySeconds = std::atof(argv[++i]);
+        }
+        else if (arg == "--pin")
+        {
+            pin = true;
+        }
+        else if (arg == "--measure" && i + 1 < argc)
+        {
+            measureArg = argv[++i];
+        }
+        else if (arg == "--rounds" && i + 1 < argc)
+        {
+            rounds_per_block = std::atoi(argv[++i]);
+        }
+        else if (arg == "--sample-ms" && i + 1 < argc)
+        {
+            sampleMs = std::atof(argv[++i]);
+        }
+        else if (arg == "--misalign" && i + 1 < argc)
+        {
+            misalign = static_cast<std::size_t>(std::strtoull(argv[++i], nullptr, 10));
+        }
+        else if (arg == "--working-set" && i + 1 < argc)
+        {
+            workingSetArg = argv[++i];
+        }
         else if (arg.rfind("--", 0) == 0)
         {
             std::cerr << "Unknown option: " << arg << "\n";
@@ -307,12 +1740,18 @@ int main(int argc, char *argv[])
         }
     }
 
-    if (keyHex.empty() || ivHex.empty() || files.empty())
+    if (keyHex.empty() || ivHex.empty() || (files.empty() && sizeList.empty() && !ioBench && !latency))
     {
         std::cerr << "Missing key/iv or files.\n";
         printUsagePerf();
         return 1;
     }
+    if (mode != "cbc" && mode != "ctr" && mode != "gcm")
+    {
+        std::cerr << "Unknown mode: " << mode << "\n";
+        printUsagePerf();
+        return 1;
+    }
 
     try
     {
@@ -321,23 +1760,327 @@ int main(int argc, char *argv[])
         parseHexKeyOrIv(keyHex, key);
         parseHexKeyOrIv(ivHex, iv);
 
-        const int rounds_per_block = 1000;
+        // kiểm tra mọi backend trước khi chạy (báo lỗi sớm)
+        std::vector<AES128::Backend> backends;
+        for (const auto &name : splitList(backendName))
+        {
+            AES128::Backend b = AES128::parseBackend(name);
+            AES128::setDefaultBackend(b);
+            backends.push_back(AES128::defaultBackend());
+        }
+        if (backends.empty())
+        {
+            throw std::runtime_error("Empty --backend list");
+        }
+
+        if (ioBench)
+        {
+            if (ioFiles == 0 || ioSize == 0)
+            {
+                throw std::runtime_error("--io-files and --io-size must be non-zero");
+            }
+            std::vector<IoBackend> ioBackends;
+            for (const auto &name : splitList(ioList))
+            {
+                IoBackend b = parseIoBackend(name);
+                if (b == IoBackend::Auto)
+                    b = ioUringAvailable() ? IoBackend::IoUring : IoBackend::Blocking;
+                ioBackends.push_back(b);
+            }
+            AES128::setDefaultBackend(backends.front());
+
+            std::vector<PerfResult> ioResults;
+            runIoBench(key, iv, ioBackends, ioFiles, ioSize, 10, ioDir, ioResults);
+            if (!csvPath.empty())
+            {
+                writeCsv(csvPath, ioResults);
+            }
+            if (!jsonPath.empty())
+            {
+                writeJson(jsonPath, argc, argv, ioResults);
+            }
+            return 0;
+        }
+
+        if ((useCounters || !baselinePath.empty()) && (latency || !threadList.empty()))
+        {
+            throw std::runtime_error("--counters and --baseline work with the file benchmark only");
+        }
+        if (!(alpha > 0 && alpha < 1) || regressionThreshold < 0)
+        {
+            throw std::runtime_error("--alpha must be in (0, 1) and --regression-threshold >= 0");
+        }
+        // đọc baseline trước khi chạy: file sai thì báo lỗi ngay, không chờ hết benchmark
+        std::vector<BaselineRow> baseline;
+        if (!baselinePath.empty())
+        {
+            baseline = readBaselineCsv(baselinePath);
+            // chỉ so 2 kết quả cùng measure: baseline không có dòng nào như vậy thì dừng luôn
+            std::string found;
+            bool anyMatch = false;
+            for (const auto &row : baseline)
+            {
+                anyMatch = anyMatch || row.measure == measureArg;
+                if (found.find(row.measure) == std::string::npos)
+                    found += (found.empty() ? "" : ", ") + row.measure;
+            }
+            if (!anyMatch)
+            {
+                throw std::runtime_error(
+                    "Baseline " + baselinePath + " has no rows with Measure " + measureArg + " (found: " + found +
+                    "). Rerun with the matching --measure, or regenerate the baseline (\"legacy\" rows time key "
+                    "expansion inside MeanMs and match no measure)");
+            }
+        }
+
+        if (latency)
+        {
+            std::vector<std::size_t> sizes = DefaultLatencySizes;
+            if (!sizeList.empty())
+            {
+                sizes.clear();
+                for (const auto &item : splitList(sizeList))
+                    sizes.push_back(parseSize(item));
+            }
+            for (std::size_t size : sizes)
+            {
+                if (size == 0 || size % 16 != 0)
+                {
+                    throw std::runtime_error("Latency sizes must be non-zero multiples of 16");
+                }
+            }
+            if (latencySamples == 0 || latencySeconds <= 0)
+            {
+                throw std::runtime_error("--latency-samples and --latency-seconds must be positive");
+            }
+
+            std::vector<PerfResult> latencyResults;
+            for (AES128::Backend b : backends)
+            {
+                AES128::setDefaultBackend(b);
+                std::cout << "\n##### AES backend: " << AES128::backendName(b) << " (" << mode
+                          << " enc latency, ns) #####\n";
+                std::cout << std::right << std::setw(8) << "Size" << std::setw(10) << "Samples"
+                          << std::setw(10) << "Mean" << std::setw(10) << "p50" << std::setw(10) << "p90"
+                          << std::setw(10) << "p99" << std::setw(10) << "p99.9" << std::setw(12) << "Max"
+                          << "   p99 95% CI\n";
+                for (std::size_t size : sizes)
+                    runLatencyForSize(size, key, iv, mode, latencySamples, latencySeconds, latencyResults);
+            }
+            if (!csvPath.empty())
+            {
+                writeCsv(csvPath, latencyResults);
+            }
+            if (!jsonPath.empty())
+            {
+                writeJson(jsonPath, argc, argv, latencyResults);
+            }
+            return 0;
+        }
+
+        if (!threadList.empty())
+        {
+            if (mode != "cbc")
+            {
+                throw std::runtime_error("--threads benchmarks CBC only");
+            }
+            if (files.empty())
+            {
+                throw std::runtime_error("--threads needs input files");
+            }
+            std::vector<int> threadCounts;
+            for (const auto &item : splitList(threadList))
+            {
+                int n = std::atoi(item.c_str());
+                if (n <= 0)
+                {
+                    throw std::runtime_error("Invalid thread count: " + item);
+                }
+                threadCounts.push_back(n);
+            }
+            if (threadCounts.empty())
+            {
+                throw std::runtime_error("Empty --threads list");
+            }
+            // efficiency so với số thread nhỏ nhất: chạy theo thứ tự tăng dần
+            std::sort(threadCounts.begin(), threadCounts.end());
+            threadCounts.erase(std::unique(threadCounts.begin(), threadCounts.end()), threadCounts.end());
+
+            std::vector<int> pinCpus;
+            if (pin)
+            {
+                pinCpus = allowedCpus();
+                if (pinCpus.empty())
+                    std::cerr << "Warning: thread pinning not supported here, running unpinned\n";
+                else
+                    std::cout << "Pinning threads to " << pinCpus.size() << " allowed CPUs\n";
+            }
+            unsigned hw = std::thread::hardware_concurrency();
+            if (hw > 0 && *std::max_element(threadCounts.begin(), threadCounts.end()) > static_cast<int>(hw))
+            {
+                std::cerr << "Warning: more threads than the " << hw << " hardware threads\n";
+            }
+
+            std::vector<PerfResult> scaling;
+            for (AES128::Backend b : backends)
+            {
+                AES128::setDefaultBackend(b);
+                std::cout << "\n##### AES backend: " << AES128::backendName(b) << " #####\n";
+                for (const auto &f : files)
+                    runScalingForFile(f, key, iv, threadCounts, pinCpus, 10, scaling);
+            }
+            if (!csvPath.empty())
+            {
+                writeCsv(csvPath, scaling);
+            }
+            if (!jsonPath.empty())
+            {
+                writeJson(jsonPath, argc, argv, scaling);
+            }
+            return 0;
+        }
+
+        // --sizes: workload tổng hợp (kiểm tra trước khi chạy)
+        std::vector<std::size_t> syntheticSizes;
+        for (const auto &item : splitList(sizeList))
+        {
+            std::size_t size = parseSize(item);
+            if (size == 0 || size % 16 != 0)
+            {
+                throw std::runtime_error("--sizes must be non-zero multiples of 16: " + item);
+            }
+            syntheticSizes.push_back(size);
+        }
+        std::size_t workingSet = 0;
+        if (workingSetArg == "auto")
+        {
+            std::size_t llc = lastLevelCacheBytes();
+            if (llc == 0)
+            {
+                llc = 32 * 1024 * 1024;
+                std::cerr << "Warning: last-level cache size unknown, assuming 32 MB\n";
+            }
+            workingSet = 4 * llc;
+        }
+        else if (!workingSetArg.empty())
+        {
+            workingSet = parseSize(workingSetArg);
+        }
+        if (workingSet && syntheticSizes.empty())
+        {
+            throw std::runtime_error("--working-set needs --sizes");
+        }
+        if (measureArg != "kernel" && measureArg != "e2e")
+        {
+            throw std::runtime_error("Unknown --measure: " + measureArg);
+        }
+        const Measure measure = measureArg == "e2e" ? Measure::EndToEnd : Measure::Kernel;
+        if (rounds_per_block < 0 || !(sampleMs > 0))
+        {
+            throw std::runtime_error("--rounds must be >= 0 and --sample-ms positive");
+        }
+
+        std::vector<std::size_t> offsets = {0};
+        if (misalign)
+            offsets.push_back(misalign);
+
+        std::cout << "Mode: " << mode << ", measure: " << measureName(measure) << "\n";
+        if (workingSet)
+        {
+            std::cout << "Working set: " << workingSet << " bytes (last-level cache "
+                      << lastLevelCacheBytes() << " bytes)\n";
+        }
+
+        std::unique_ptr<HwCounters> counters;
+        if (useCounters)
+        {
+            counters.reset(new HwCounters());
+            if (!counters->available())
+            {
+                throw std::runtime_error("--counters: " + counters->error());
+            }
+            if (!counters->error().empty())
+            {
+                std::cerr << "Warning: " << counters->error() << " (reported as n/a)\n";
+            }
+        }
+        if (cycleCounterAvailable())
+        {
+            std::cout << "Cycle counter: rdtsc, " << cycleCounterGHz()
+                      << " GHz (calibrated against steady_clock, reference cycles)\n";
+        }
+        else
+        {
+            std::cout << "Cycle counter: not available on this CPU (cycles reported as 0)\n";
+        }
+
         const int blocks = 10;
 
         std::vector<PerfResult> allResults;
-        allResults.reserve(files.size());
+        allResults.reserve(files.size() * backends.size());
 
-        for (const auto &f : files)
+        std::vector<std::string> backendNames;
+        std::vector<std::string> labels; // file / buffer, theo thứ tự chạy
+        for (AES128::Backend b : backends)
         {
-            PerfResult res;
-            runPerfForFile(f, key, iv, rounds_per_block, blocks, res);
-            allResults.push_back(res);
+            AES128::setDefaultBackend(b);
+            backendNames.push_back(AES128::backendName(b));
+            std::cout << "\n##### AES backend: " << backendNames.back() << " #####\n";
+
+            for (const auto &f : files)
+            {
+                PerfResult res;
+                runPerfForFile(f, key, iv, mode, measure, rounds_per_block, sampleMs, blocks, counters.get(), res);
+                allResults.push_back(res);
+            }
+            for (std::size_t size : syntheticSizes)
+            {
+                for (std::size_t offset : offsets)
+                {
+                    PerfResult res;
+                    runPerfForSize(size, offset, workingSet, key, iv, mode, measure, rounds_per_block, sampleMs,
+                                   blocks, counters.get(), res);
+                    allResults.push_back(res);
+                }
+            }
+            if (labels.empty())
+            {
+                for (const auto &r : allResults)
+                    labels.push_back(r.filename);
+            }
+        }
+
+        if (backends.size() > 1)
+        {
+            printBackendSummary(labels, backendNames, allResults);
         }
 
         if (!csvPath.empty())
         {
             writeCsv(csvPath, allResults);
         }
+        if (!jsonPath.empty())
+        {
+            writeJson(jsonPath, argc, argv, allResults);
+        }
+
+        if (!baseline.empty())
+        {
+            int matched = 0;
+            int regressions = compareWithBaseline(allResults, baseline, regressionThreshold, alpha, matched);
+            if (matched == 0)
+            {
+                // không so được gì thì không được coi là pass
+                std::cerr << "No result matched a row of " << baselinePath
+                          << " (0 of " << allResults.size() << " compared)\n";
+                return 3;
+            }
+            if (regressions > 0)
+            {
+                std::cerr << regressions << " throughput regression(s) against " << baselinePath << "\n";
+                return 2;
+            }
+        }
     }
     catch (const std::exception &ex)
     {
@@ -0,0 +1,162 @@
+#include "perf_counters.h"
+
+#include <cerrno>
+#include <cstring>
+
+#if defined(__linux__)
+#define HW_COUNTERS_PERF_EVENT 1
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+const char *HwCounters::name(HwCounter c)
+{
+    switch (c)
+    {
+    case HwCounter::Cycles:
+        return "cycles";
+    case HwCounter::Instructions:
+        return "instructions";
+    case HwCounter::L1dMisses:
+        return "L1D misses";
+    case HwCounter::BranchMisses:
+        return "branch misses";
+    default:
+        return "?";
+    }
+}
+
+#ifdef HW_COUNTERS_PERF_EVENT
+
+static int openCounter(HwCounter c)
+{
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    switch (c)
+    {
+    case HwCounter::Cycles:
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = PERF_COUNT_HW_CPU_CYCLES;
+        break;
+    case HwCounter::Instructions:
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+        break;
+    case HwCounter::L1dMisses:
+        attr.type = PERF_TYPE_HW_CACHE;
+        attr.config = PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                      (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+        break;
+    default:
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = PERF_COUNT_HW_BRANCH_MISSES;
+        break;
+    }
+    // pid 0, cpu -1: thread hiện tại trên mọi CPU
+    return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+}
+
+HwCounters::HwCounters()
+{
+    for (int i = 0; i < N; ++i)
+    {
+        values[i] = 0;
+        fds[i] = openCounter(static_cast<HwCounter>(i));
+        if (fds[i] < 0 && lastError.empty())
+        {
+            lastError = std::string("perf_event_open(") + name(static_cast<HwCounter>(i)) +
+                        "): " + std::strerror(errno);
+            if (errno == EACCES || errno == EPERM)
+                lastError += " (see /proc/sys/kernel/perf_event_paranoid)";
+            else if (errno == ENOENT || errno == EOPNOTSUPP)
+                lastError += " (no hardware PMU exposed, e.g. inside a VM)";
+        }
+    }
+}
+
+HwCounters::~HwCounters()
+{
+    for (int fd : fds)
+    {
+        if (fd >= 0)
+            close(fd);
+    }
+}
+
+void HwCounters::start()
+{
+    for (int fd : fds)
+    {
+        if (fd >= 0)
+        {
+            ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+            ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+    }
+}
+
+void HwCounters::stop()
+{
+    for (int i = 0; i < N; ++i)
+    {
+        if (fds[i] >= 0)
+            ioctl(fds[i], PERF_EVENT_IOC_DISABLE, 0);
+    }
+    for (int i = 0; i < N; ++i)
+    {
+        values[i] = 0;
+        uint64_t data[3]; // value, time_enabled, time_running
+        if (fds[i] < 0 || read(fds[i], data, sizeof(data)) != static_cast<ssize_t>(sizeof(data)))
+            continue;
+        values[i] = static_cast<double>(data[0]);
+        if (data[2] > 0 && data[2] < data[1])
+            values[i] *= static_cast<double>(data[1]) / static_cast<double>(data[2]);
+    }
+}
+
+#else
+
+HwCounters::HwCounters()
+{
+    for (int i = 0; i < N; ++i)
+    {
+        fds[i] = -1;
+        values[i] = 0;
+    }
+    lastError = "hardware counters need Linux perf_event_open";
+}
+
+HwCounters::~HwCounters() {}
+
+void HwCounters::start() {}
+
+void HwCounters::stop() {}
+
+#endif // HW_COUNTERS_PERF_EVENT
+
+bool HwCounters::available() const
+{
+    for (int fd : fds)
+    {
+        if (fd >= 0)
+            return true;
+    }
+    return false;
+}
+
+bool HwCounters::has(HwCounter c) const
+{
+    return fds[static_cast<int>(c)] >= 0;
+}
+
+double HwCounters::value(HwCounter c) const
+{
+    return values[static_cast<int>(c)];
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+// ===== Bộ đếm hiệu năng phần cứng cho aes_perf --counters =====
+// Linux: perf_event_open, chỉ đếm user space của thread hiện tại.
+// Mỗi counter mở riêng (không group) nên CPU / VM thiếu 1 event vẫn dùng được các event còn lại;
+// khi kernel phải multiplex, giá trị được scale theo time_enabled / time_running.
+// Nền tảng khác hoặc perf_event_paranoid chặn: available() = false, error() cho biết lý do.
+
+enum class HwCounter
+{
+    Cycles,
+    Instructions,
+    L1dMisses, // L1D read miss
+    BranchMisses,
+    Count
+};
+
+class HwCounters
+{
+public:
+    HwCounters();
+    ~HwCounters();
+
+    HwCounters(const HwCounters &) = delete;
+    HwCounters &operator=(const HwCounters &) = delete;
+
+    bool available() const; // mở được ít nhất 1 counter
+    bool has(HwCounter c) const;
+    const std::string &error() const { return lastError; }
+
+    // reset + bật / tắt mọi counter đã mở
+    void start();
+    void stop();
+
+    // Giá trị giữa start() và stop() gần nhất; 0 nếu counter không mở được
+    double value(HwCounter c) const;
+
+    static const char *name(HwCounter c);
+
+private:
+    static const int N = static_cast<int>(HwCounter::Count);
+    int fds[N];
+    double values[N];
+    std::string lastError;
+};
@@ -0,0 +1,110 @@
+#include "perf_env.h"
+
+#include <ctime>
+#include <fstream>
+#include <thread>
+
+#include "cpu_features.h"
+
+#if defined(__linux__) || defined(__APPLE__)
+#define PERF_ENV_POSIX 1
+#include <sys/utsname.h>
+#include <unistd.h>
+#endif
+
+// Dòng đầu của file (bỏ khoảng trắng cuối), rỗng nếu không đọc được
+static std::string readFirstLine(const char *path)
+{
+    std::ifstream ifs(path);
+    std::string line;
+    if (!ifs || !std::getline(ifs, line))
+        return std::string();
+    line.erase(line.find_last_not_of(" \t\r\n") + 1);
+    return line;
+}
+
+static std::string cpuModel()
+{
+    std::string brand = cpuBrandString();
+    if (!brand.empty())
+        return brand;
+
+    // không phải x86: Linux ghi tên CPU trong /proc/cpuinfo
+    std::ifstream ifs("/proc/cpuinfo");
+    std::string line;
+    while (std::getline(ifs, line))
+    {
+        if (line.rfind("model name", 0) == 0 || line.rfind("Model", 0) == 0)
+        {
+            std::size_t colon = line.find(':');
+            if (colon != std::string::npos)
+            {
+                std::size_t start = line.find_first_not_of(" \t", colon + 1);
+                return start == std::string::npos ? std::string() : line.substr(start);
+            }
+        }
+    }
+    return std::string();
+}
+
+static std::string compilerVersion()
+{
+#if defined(__clang__)
+    return std::string("clang ") + __clang_version__;
+#elif defined(__GNUC__)
+    return std::string("gcc ") + __VERSION__;
+#elif defined(_MSC_VER)
+    return "msvc " + std::to_string(_MSC_FULL_VER);
+#else
+    return "unknown";
+#endif
+}
+
+PerfEnvironment capturePerfEnvironment()
+{
+    PerfEnvironment env;
+    env.cpu_model = cpuModel();
+    env.logical_cpus = std::thread::hardware_concurrency();
+
+    const CpuFeatures &f = cpuFeatures();
+    env.aesni = f.aesni;
+    env.pclmul = f.pclmul;
+    env.avx2 = f.avx2;
+    env.sse41 = f.sse41;
+
+    env.compiler = compilerVersion();
+    // compiler không cho biết dòng lệnh build và binary không biết mình build từ commit nào:
+    // chỉ tin giá trị build.sh / lệnh build truyền vào, không đoán lúc chạy
+#if defined(AES_PERF_BUILD_FLAGS)
+    env.build_flags = AES_PERF_BUILD_FLAGS;
+#endif
+    env.build_flags_known = !env.build_flags.empty();
+    env.governor = readFirstLine("/sys/devices/system/cpu/cpu0/cpufreq/scaling_governor");
+#if defined(AES_PERF_GIT_HASH)
+    env.git_hash = AES_PERF_GIT_HASH;
+#endif
+    env.git_hash_known = !env.git_hash.empty();
+
+#ifdef PERF_ENV_POSIX
+    struct utsname u;
+    if (uname(&u) == 0)
+    {
+        env.os = std::string(u.sysname) + " " + u.release + " " + u.machine;
+    }
+    char host[256] = {};
+    if (gethostname(host, sizeof(host) - 1) == 0)
+    {
+        env.hostname = host;
+    }
+#elif defined(_WIN32)
+    env.os = "Windows";
+#endif
+
+    std::time_t now = std::time(nullptr);
+    char ts[32] = {};
+    if (std::strftime(ts, sizeof(ts), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now)))
+    {
+        env.timestamp = ts;
+    }
+    return env;
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <string>
+
+// ===== Thông tin môi trường cho aes_perf --json =====
+// Đủ để so sánh kết quả giữa các máy: CPU, số core, tính năng CPU, compiler, cờ build,
+// CPU governor và git hash. Trường không lấy được thì để rỗng.
+// Cờ build và git hash chỉ có khi build với -DAES_PERF_BUILD_FLAGS / -DAES_PERF_GIT_HASH
+// (build.sh truyền sẵn); không có thì để rỗng và *_known = false.
+
+struct PerfEnvironment
+{
+    std::string cpu_model;   // CPUID brand string, không có thì "model name" trong /proc/cpuinfo
+    unsigned logical_cpus = 0;
+    bool aesni = false;
+    bool pclmul = false;
+    bool avx2 = false;
+    bool sse41 = false;
+    std::string compiler;    // vd. "gcc 13.2.0"
+    std::string build_flags; // -DAES_PERF_BUILD_FLAGS="..." khi build
+    bool build_flags_known = false;
+    std::string governor;    // cpu0 scaling_governor (Linux)
+    std::string git_hash;    // -DAES_PERF_GIT_HASH="..." khi build
+    bool git_hash_known = false;
+    std::string os;          // uname: sysname release machine
+    std::string hostname;
+    std::string timestamp;   // UTC, ISO 8601
+};
+
+PerfEnvironment capturePerfEnvironment();
@@ -0,0 +1,302 @@
+#include "perf_stats.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+
+Stats computeStats(const std::vector<double> &samples_ms)
+{
+    const std::size_t n = samples_ms.size();
+    if (n == 0)
+    {
+        throw std::runtime_error("No samples to compute stats");
+    }
+
+    // mean
+    double sum = std::accumulate(samples_ms.begin(), samples_ms.end(), 0.0);
+    double mean = sum / static_cast<double>(n);
+
+    // median
+    std::vector<double> sorted = samples_ms;
+    std::sort(sorted.begin(), sorted.end());
+    double median;
+    if (n % 2 == 0)
+    {
+        median = 0.5 * (sorted[n / 2 - 1] + sorted[n / 2]);
+    }
+    else
+    {
+        median = sorted[n / 2];
+    }
+
+    // sample stddev (1 mẫu: không có độ lệch, CI suy biến về mean)
+    if (n == 1)
+    {
+        return Stats{mean, median, 0.0, mean, mean};
+    }
+    double sq_sum = 0.0;
+    for (double x : samples_ms)
+    {
+        double diff = x - mean;
+        sq_sum += diff * diff;
+    }
+    double stddev = std::sqrt(sq_sum / static_cast<double>(n - 1));
+
+    // 95% CI: mean ± t(0.975, n-1) * std/sqrt(n)
+    double t_val = studentTQuantile(0.975, static_cast<double>(n - 1));
+    double margin = t_val * stddev / std::sqrt(static_cast<double>(n));
+    double ci_low = mean - margin;
+    double ci_high = mean + margin;
+
+    return Stats{mean, median, stddev, ci_low, ci_high};
+}
+
+// ===== Student t =====
+
+// Phân số liên tục của hàm beta không đầy đủ (Lentz), hội tụ nhanh khi x < (a+1)/(a+b+2)
+static double betaContinuedFraction(double a, double b, double x)
+{
+    const double tiny = 1e-300;
+    double c = 1.0;
+    double d = 1.0 - (a + b) * x / (a + 1.0);
+    if (std::fabs(d) < tiny)
+        d = tiny;
+    d = 1.0 / d;
+    double h = d;
+    // số vòng cần ~ sqrt(max(a, b)): a, b cỡ triệu (CDF nhị thức của histogram latency)
+    const int maxIter = 300 + static_cast<int>(10.0 * std::sqrt(a + b));
+    for (int m = 1; m <= maxIter; ++m)
+    {
+        double m2 = 2.0 * m;
+        double aa = m * (b - m) * x / ((a + m2 - 1.0) * (a + m2));
+        d = 1.0 + aa * d;
+        c = 1.0 + aa / c;
+        d = 1.0 / (std::fabs(d) < tiny ? tiny : d);
+        c = std::fabs(c) < tiny ? tiny : c;
+        h *= d * c;
+
+        aa = -(a + m) * (a + b + m) * x / ((a + m2) * (a + m2 + 1.0));
+        d = 1.0 + aa * d;
+        c = 1.0 + aa / c;
+        d = 1.0 / (std::fabs(d) < tiny ? tiny : d);
+        c = std::fabs(c) < tiny ? tiny : c;
+        double delta = d * c;
+        h *= delta;
+        if (std::fabs(delta - 1.0) < 1e-15)
+            break;
+    }
+    return h;
+}
+
+// Hàm beta không đầy đủ chuẩn hoá I_x(a, b)
+static double incompleteBeta(double a, double b, double x)
+{
+    if (x <= 0.0)
+        return 0.0;
+    if (x >= 1.0)
+        return 1.0;
+    double front = std::exp(std::lgamma(a + b) - std::lgamma(a) - std::lgamma(b) +
+                            a * std::log(x) + b * std::log1p(-x));
+    if (x < (a + 1.0) / (a + b + 2.0))
+        return front * betaContinuedFraction(a, b, x) / a;
+    return 1.0 - front * betaContinuedFraction(b, a, 1.0 - x) / b;
+}
+
+// P(B <= k), B ~ Binomial(n, q): = 1 - I_q(k + 1, n - k)
+static double binomialCdf(double k, double n, double q)
+{
+    if (k < 0)
+        return 0.0;
+    if (k >= n)
+        return 1.0;
+    return 1.0 - incompleteBeta(k + 1.0, n - k, q);
+}
+
+double studentTCdf(double t, double df)
+{
+    if (df <= 0)
+    {
+        throw std::runtime_error("Student t needs df > 0");
+    }
+    // P(|T| > |t|) = I_{df/(df+t^2)}(df/2, 1/2)
+    double tail = 0.5 * incompleteBeta(0.5 * df, 0.5, df / (df + t * t));
+    return t >= 0 ? 1.0 - tail : tail;
+}
+
+double studentTQuantile(double p, double df)
+{
+    if (!(p > 0.0 && p < 1.0))
+    {
+        throw std::runtime_error("Quantile probability must be in (0, 1)");
+    }
+    if (p < 0.5)
+        return -studentTQuantile(1.0 - p, df);
+
+    // CDF tăng đơn điệu: mở rộng cận trên rồi chia đôi (đủ chính xác cho CI, ~1e-12)
+    double lo = 0.0, hi = 1.0;
+    while (studentTCdf(hi, df) < p && hi < 1e12)
+        hi *= 2.0;
+    for (int i = 0; i < 200 && hi - lo > 1e-12 * hi; ++i)
+    {
+        double mid = 0.5 * (lo + hi);
+        if (studentTCdf(mid, df) < p)
+            lo = mid;
+        else
+            hi = mid;
+    }
+    return 0.5 * (lo + hi);
+}
+
+WelchResult welchTTest(double mean1, double sd1, double n1,
+                       double mean2, double sd2, double n2)
+{
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    if (n1 < 2 || n2 < 2)
+        return WelchResult{nan, nan, nan};
+
+    double v1 = sd1 * sd1 / n1;
+    double v2 = sd2 * sd2 / n2;
+    double diff = mean1 - mean2;
+    if (v1 + v2 == 0)
+    {
+        // không có độ lệch: khác nhau là chắc chắn, bằng nhau thì không có bằng chứng
+        return WelchResult{diff == 0 ? 0.0 : (diff > 0 ? HUGE_VAL : -HUGE_VAL), n1 + n2 - 2,
+                           diff == 0 ? 1.0 : 0.0};
+    }
+    double t = diff / std::sqrt(v1 + v2);
+    // bậc tự do Welch–Satterthwaite
+    double df = (v1 + v2) * (v1 + v2) / (v1 * v1 / (n1 - 1) + v2 * v2 / (n2 - 1));
+    double p = 2.0 * (1.0 - studentTCdf(std::fabs(t), df));
+    return WelchResult{t, df, std::min(1.0, std::max(0.0, p))};
+}
+
+// ===== LatencyHistogram =====
+
+LatencyHistogram::LatencyHistogram() : counts(Buckets, 0) {}
+
+int LatencyHistogram::indexOf(uint64_t value)
+{
+    if (value < 2 * Half)
+        return static_cast<int>(value);
+    int bits = 64;
+    while (!(value >> (bits - 1)))
+        --bits;
+    int shift = bits - SubBits;
+    return shift * Half + static_cast<int>(value >> shift);
+}
+
+double LatencyHistogram::midpointOf(int index)
+{
+    if (index < 2 * Half)
+        return index;
+    int shift = index / Half - 1;
+    uint64_t sub = static_cast<uint64_t>(index % Half + Half);
+    double low = std::ldexp(static_cast<double>(sub), shift);
+    double width = std::ldexp(1.0, shift);
+    return low + 0.5 * (width - 1.0);
+}
+
+void LatencyHistogram::record(uint64_t value)
+{
+    ++counts[indexOf(value)];
+    if (total == 0 || value < minValue)
+        minValue = value;
+    if (value > maxValue)
+        maxValue = value;
+    ++total;
+    double v = static_cast<double>(value);
+    sum += v;
+    sumSq += v * v;
+}
+
+double LatencyHistogram::mean() const
+{
+    return total ? sum / static_cast<double>(total) : 0.0;
+}
+
+double LatencyHistogram::stddev() const
+{
+    if (total < 2)
+        return 0.0;
+    double n = static_cast<double>(total);
+    double var = (sumSq - sum * sum / n) / (n - 1.0);
+    return var > 0 ? std::sqrt(var) : 0.0;
+}
+
+double LatencyHistogram::valueAtRank(uint64_t rank) const
+{
+    if (total == 0)
+        return 0.0;
+    rank = std::min(std::max<uint64_t>(rank, 1), total);
+    if (rank == total)
+        return static_cast<double>(maxValue);
+    uint64_t seen = 0;
+    for (int i = 0; i < Buckets; ++i)
+    {
+        seen += counts[i];
+        if (seen >= rank)
+        {
+            // giá trị đại diện không vượt ra ngoài [min, max] đã thấy
+            double v = midpointOf(i);
+            return std::min(std::max(v, static_cast<double>(minValue)), static_cast<double>(maxValue));
+        }
+    }
+    return static_cast<double>(maxValue);
+}
+
+double LatencyHistogram::percentile(double q) const
+{
+    double rank = std::ceil(q * static_cast<double>(total));
+    return valueAtRank(static_cast<uint64_t>(rank));
+}
+
+void LatencyHistogram::percentileCi(double q, double &low, double &high) const
+{
+    if (total == 0)
+    {
+        low = high = 0.0;
+        return;
+    }
+    const double n = static_cast<double>(total);
+    // P(B <= r - 1) tăng theo rank r: chia đôi trên [1, n]
+    auto below = [&](uint64_t r)
+    { return binomialCdf(static_cast<double>(r) - 1.0, n, q); };
+
+    uint64_t lo = 1, hi = total; // rank dưới: r lớn nhất với below(r) <= 0.025
+    while (lo < hi)
+    {
+        uint64_t mid = lo + (hi - lo + 1) / 2;
+        if (below(mid) <= 0.025)
+            lo = mid;
+        else
+            hi = mid - 1;
+    }
+    const uint64_t lowRank = lo;
+
+    lo = 1, hi = total; // rank trên: r nhỏ nhất với below(r) >= 0.975
+    while (lo < hi)
+    {
+        uint64_t mid = lo + (hi - lo) / 2;
+        if (below(mid) >= 0.975)
+            hi = mid;
+        else
+            lo = mid + 1;
+    }
+    const uint64_t highRank = lo;
+
+    low = valueAtRank(lowRank);
+    high = valueAtRank(highRank);
+}
+
+std::vector<std::pair<double, uint64_t>> LatencyHistogram::buckets() const
+{
+    std::vector<std::pair<double, uint64_t>> out;
+    for (int i = 0; i < Buckets; ++i)
+    {
+        if (counts[i])
+            out.emplace_back(midpointOf(i), counts[i]);
+    }
+    return out;
+}
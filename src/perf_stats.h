@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// ===== Thống kê cho aes_perf =====
+
+struct Stats
+{
+    double mean_ms;
+    double median_ms;
+    double stddev_ms;
+    double ci_low_ms; // 95% CI của mean (Student t, df = n - 1)
+    double ci_high_ms;
+};
+
+Stats computeStats(const std::vector<double> &samples_ms);
+
+// Phân phối Student t với df bậc tự do (df > 0, không cần nguyên)
+double studentTCdf(double t, double df);
+double studentTQuantile(double p, double df); // 0 < p < 1
+
+// Welch t-test 2 phía từ mean / stddev / số mẫu của 2 nhóm (không cần mẫu gốc,
+// phương sai 2 nhóm không cần bằng nhau). p = NaN nếu nhóm nào có < 2 mẫu.
+struct WelchResult
+{
+    double t;
+    double df;
+    double p;
+};
+
+WelchResult welchTTest(double mean1, double sd1, double n1,
+                       double mean2, double sd2, double n2);
+
+// ===== Histogram latency kiểu HDR =====
+// Bucket theo log2, mỗi lũy thừa của 2 chia 64 sub-bucket: sai số tương đối < 1/64,
+// bộ nhớ cố định (~30 KB) cho mọi giá trị uint64, ghi 1 mẫu là O(1).
+// Giá trị 0..127 được lưu chính xác.
+class LatencyHistogram
+{
+public:
+    LatencyHistogram();
+
+    void record(uint64_t value);
+
+    uint64_t count() const { return total; }
+    uint64_t min() const { return total ? minValue : 0; }
+    uint64_t max() const { return maxValue; }
+    double mean() const;
+    double stddev() const;
+
+    // Giá trị tại phân vị q (0..1): giữa bucket chứa mẫu thứ ceil(q * count)
+    double percentile(double q) const;
+
+    // 95% CI của phân vị q, không giả định phân phối: số mẫu nhỏ hơn phân vị thật
+    // ~ Binomial(n, q). Rank dưới l lớn nhất với P(B <= l-1) <= 2.5%, rank trên u nhỏ nhất
+    // với P(B <= u-1) >= 97.5% (CDF nhị thức chính xác qua hàm beta không đầy đủ), nên
+    // [X(l), X(u)] phủ >= 95% với mọi n (n quá nhỏ thì bị chặn ở mẫu đầu / cuối).
+    void percentileCi(double q, double &low, double &high) const;
+
+    // Các bucket có mẫu: (giá trị giữa bucket, số mẫu), theo thứ tự tăng dần
+    std::vector<std::pair<double, uint64_t>> buckets() const;
+
+private:
+    static const int SubBits = 7; // 2^7 = 128: 0..127 chính xác, sau đó 64 sub-bucket / lũy thừa 2
+    static const int Half = 1 << (SubBits - 1);
+    static const int Buckets = (64 - SubBits + 2) * Half;
+
+    std::vector<uint64_t> counts;
+    uint64_t total = 0;
+    uint64_t minValue = 0;
+    uint64_t maxValue = 0;
+    double sum = 0;
+    double sumSq = 0;
+
+    static int indexOf(uint64_t value);
+    static double midpointOf(int index);
+    double valueAtRank(uint64_t rank) const; // rank 1..count
+};
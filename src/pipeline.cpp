@@ -0,0 +1,222 @@
+#include "pipeline.h"
+#include "file_io.h"
+
+#include <chrono>
+#include <exception>
+#include <istream>
+#include <mutex>
+#include <ostream>
+#include <stdexcept>
+#include <thread>
+
+using Clock = std::chrono::steady_clock;
+
+static double secondsSince(Clock::time_point start)
+{
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+BufferPool::BufferPool(std::size_t count, std::size_t chunkSize, std::size_t outSlack)
+    : buffers(count), chunk(chunkSize)
+{
+    if (count == 0 || chunkSize == 0)
+    {
+        throw std::runtime_error("BufferPool: count and chunk size must be non-zero");
+    }
+    for (auto &b : buffers)
+    {
+        b.in.resize(chunkSize);
+        b.out.resize(chunkSize + outSlack);
+    }
+}
+
+namespace
+{
+
+// Trạng thái chung của 3 tầng: ring nối các tầng + cờ huỷ khi 1 tầng lỗi
+struct PipelineState
+{
+    SpscRing<PipeBuffer *> freeRing;   // writer -> reader
+    SpscRing<PipeBuffer *> filledRing; // reader -> cipher
+    SpscRing<PipeBuffer *> doneRing;   // cipher -> writer
+    std::atomic<bool> aborted{false};
+    std::mutex errorMutex;
+    std::exception_ptr error;
+
+    explicit PipelineState(std::size_t n) : freeRing(n), filledRing(n), doneRing(n) {}
+
+    void fail()
+    {
+        std::lock_guard<std::mutex> lock(errorMutex);
+        if (!error)
+            error = std::current_exception();
+        aborted.store(true, std::memory_order_release);
+    }
+};
+
+// Lấy 1 phần tử, chờ nếu ring rỗng: spin ngắn -> yield -> sleep.
+// Thời gian chờ cộng vào stall; trả false nếu pipeline bị huỷ.
+bool popWait(SpscRing<PipeBuffer *> &ring, PipeBuffer *&item,
+             const std::atomic<bool> &aborted, double &stall)
+{
+    if (ring.tryPop(item))
+        return true;
+
+    auto start = Clock::now();
+    for (unsigned spins = 0;; ++spins)
+    {
+        if (ring.tryPop(item))
+            break;
+        if (aborted.load(std::memory_order_acquire))
+        {
+            stall += secondsSince(start);
+            return false;
+        }
+        if (spins < 64)
+            continue;
+        if (spins < 1024)
+            std::this_thread::yield();
+        else
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+    }
+    stall += secondsSince(start);
+    return true;
+}
+
+// Mỗi ring có sức chứa >= số buffer nên push không bao giờ đầy
+void push(SpscRing<PipeBuffer *> &ring, PipeBuffer *item)
+{
+    if (!ring.tryPush(item))
+        throw std::logic_error("pipeline ring overflow");
+}
+
+void readerStage(PipelineState &st, std::istream &in, PipelineStats &stats)
+{
+    try
+    {
+        for (;;)
+        {
+            PipeBuffer *b;
+            if (!popWait(st.freeRing, b, st.aborted, stats.readStall))
+                return;
+
+            auto start = Clock::now();
+            b->inLen = readFull(in, b->in.data(), b->in.size());
+            b->last = b->inLen < b->in.size() ||
+                      in.peek() == std::char_traits<char>::eof();
+            stats.bytesIn += b->inLen;
+            stats.readBusy += secondsSince(start);
+
+            push(st.filledRing, b);
+            if (b->last)
+                return;
+        }
+    }
+    catch (...)
+    {
+        st.fail();
+    }
+}
+
+void cipherStage(PipelineState &st, const PipelineCipher &cipher, PipelineStats &stats)
+{
+    try
+    {
+        for (;;)
+        {
+            PipeBuffer *b;
+            if (!popWait(st.filledRing, b, st.aborted, stats.cipherStall))
+                return;
+
+            auto start = Clock::now();
+            b->outLen = cipher.update(b->in.data(), b->inLen, b->out.data());
+            if (b->last)
+                b->outLen += cipher.final(b->out.data() + b->outLen);
+            stats.cipherBusy += secondsSince(start);
+
+            push(st.doneRing, b);
+            if (b->last)
+                return;
+        }
+    }
+    catch (...)
+    {
+        st.fail();
+    }
+}
+
+void writerStage(PipelineState &st, std::ostream &out, PipelineStats &stats)
+{
+    try
+    {
+        for (;;)
+        {
+            PipeBuffer *b;
+            if (!popWait(st.doneRing, b, st.aborted, stats.writeStall))
+                return;
+
+            auto start = Clock::now();
+            out.write(reinterpret_cast<const char *>(b->out.data()),
+                      static_cast<std::streamsize>(b->outLen));
+            if (b->last)
+                out.flush();
+            if (!out)
+                throw std::runtime_error("Error writing output");
+            stats.bytesOut += b->outLen;
+            stats.writeBusy += secondsSince(start);
+
+            if (b->last)
+                return;
+            push(st.freeRing, b);
+        }
+    }
+    catch (...)
+    {
+        st.fail();
+    }
+}
+
+} // namespace
+
+PipelineStats runPipeline(const PipelineCipher &cipher, std::istream &in, std::ostream &out,
+                          std::size_t chunkSize, std::size_t buffers)
+{
+    if (chunkSize == 0 || chunkSize % 16 != 0)
+    {
+        throw std::runtime_error("Pipeline chunk size must be a non-zero multiple of 16");
+    }
+
+    // update() có thể trả thêm 1 block giữ lại từ lần trước, final() thêm 1 block padding
+    BufferPool pool(buffers, chunkSize, 32);
+    PipelineState st(pool.count());
+    for (std::size_t i = 0; i < pool.count(); ++i)
+        push(st.freeRing, pool.at(i));
+
+    PipelineStats stats;
+    stats.chunkSize = chunkSize;
+    stats.buffers = pool.count();
+
+    // mỗi tầng chỉ ghi vào bản stats riêng, gộp lại sau khi join
+    PipelineStats readStats, cipherStats, writeStats;
+    auto start = Clock::now();
+    std::thread reader(readerStage, std::ref(st), std::ref(in), std::ref(readStats));
+    std::thread worker(cipherStage, std::ref(st), std::cref(cipher), std::ref(cipherStats));
+    std::thread writer(writerStage, std::ref(st), std::ref(out), std::ref(writeStats));
+    reader.join();
+    worker.join();
+    writer.join();
+    stats.total = secondsSince(start);
+
+    if (st.error)
+        std::rethrow_exception(st.error);
+
+    stats.readBusy = readStats.readBusy;
+    stats.readStall = readStats.readStall;
+    stats.bytesIn = readStats.bytesIn;
+    stats.cipherBusy = cipherStats.cipherBusy;
+    stats.cipherStall = cipherStats.cipherStall;
+    stats.writeBusy = writeStats.writeBusy;
+    stats.writeStall = writeStats.writeStall;
+    stats.bytesOut = writeStats.bytesOut;
+    return stats;
+}
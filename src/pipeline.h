@@ -0,0 +1,138 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iosfwd>
+#include <memory>
+#include <vector>
+
+// ===== Pipeline 3 tầng: đọc -> mã hoá -> ghi =====
+// Mỗi tầng 1 thread, buffer cố định lấy từ BufferPool và chuyền qua SpscRing,
+// nên đọc đĩa, AES và ghi đĩa chạy chồng lên nhau.
+
+// Hàng đợi vòng 1 producer / 1 consumer, không khoá (chỉ atomic head/tail)
+template <class T>
+class SpscRing
+{
+public:
+    // capacity được làm tròn lên luỹ thừa của 2
+    explicit SpscRing(std::size_t capacity)
+    {
+        std::size_t n = 1;
+        while (n < capacity)
+            n <<= 1;
+        slots.resize(n);
+        mask = n - 1;
+    }
+
+    // chỉ gọi từ thread producer
+    bool tryPush(const T &value)
+    {
+        std::size_t t = tail.load(std::memory_order_relaxed);
+        if (t - head.load(std::memory_order_acquire) == slots.size())
+            return false; // đầy
+        slots[t & mask] = value;
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    // chỉ gọi từ thread consumer
+    bool tryPop(T &value)
+    {
+        std::size_t h = head.load(std::memory_order_relaxed);
+        if (h == tail.load(std::memory_order_acquire))
+            return false; // rỗng
+        value = slots[h & mask];
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+private:
+    std::vector<T> slots;
+    std::size_t mask = 0;
+    // head/tail ở 2 cache line khác nhau để producer và consumer không tranh nhau
+    alignas(64) std::atomic<std::size_t> head{0};
+    alignas(64) std::atomic<std::size_t> tail{0};
+};
+
+// 1 buffer trong pipeline: reader ghi in, cipher ghi out, writer ghi out ra file
+struct PipeBuffer
+{
+    std::vector<uint8_t> in;
+    std::vector<uint8_t> out;
+    std::size_t inLen = 0;
+    std::size_t outLen = 0;
+    bool last = false; // buffer cuối: cipher gọi thêm final()
+};
+
+// Cấp phát sẵn count buffer, tái sử dụng suốt pipeline (không cấp phát lúc chạy)
+class BufferPool
+{
+public:
+    BufferPool(std::size_t count, std::size_t chunkSize, std::size_t outSlack);
+
+    std::size_t count() const { return buffers.size(); }
+    std::size_t chunkSize() const { return chunk; }
+    PipeBuffer *at(std::size_t i) { return &buffers[i]; }
+
+private:
+    std::vector<PipeBuffer> buffers;
+    std::size_t chunk;
+};
+
+// Thời gian (giây) của từng tầng: busy = làm việc, stall = chờ tầng khác
+struct PipelineStats
+{
+    double readBusy = 0, readStall = 0;     // reader chờ buffer trống
+    double cipherBusy = 0, cipherStall = 0; // cipher chờ dữ liệu đọc
+    double writeBusy = 0, writeStall = 0;   // writer chờ dữ liệu đã mã hoá
+    double total = 0;
+    uint64_t bytesIn = 0;
+    uint64_t bytesOut = 0;
+    std::size_t chunkSize = 0;
+    std::size_t buffers = 0;
+};
+
+// Hàm cipher dạng update/final (CbcEncryptor, GcmDecryptor, CtrCipher...)
+struct PipelineCipher
+{
+    std::function<std::size_t(const uint8_t *, std::size_t, uint8_t *)> update;
+    std::function<std::size_t(uint8_t *)> final;
+};
+
+constexpr std::size_t PipelineChunkSize = 1024 * 1024;
+constexpr std::size_t PipelineBuffers = 4;
+
+// Chạy pipeline tới hết input. Tầng nào lỗi thì các tầng khác dừng,
+// exception được ném lại ở thread gọi hàm.
+PipelineStats runPipeline(const PipelineCipher &cipher, std::istream &in, std::ostream &out,
+                          std::size_t chunkSize = PipelineChunkSize,
+                          std::size_t buffers = PipelineBuffers);
+
+template <class Cipher>
+PipelineStats runPipeline(Cipher &cipher, std::istream &in, std::ostream &out,
+                          std::size_t chunkSize = PipelineChunkSize,
+                          std::size_t buffers = PipelineBuffers)
+{
+    PipelineCipher ops;
+    ops.update = [&cipher](const uint8_t *src, std::size_t len, uint8_t *dst)
+    { return cipher.update(src, len, dst); };
+    ops.final = [&cipher](uint8_t *dst)
+    { return cipher.final(dst); };
+    const PipelineCipher &constOps = ops; // gọi bản không template ở trên
+    return runPipeline(constOps, in, out, chunkSize, buffers);
+}
+
+// PipelineCipher sở hữu cipher (dùng khi mỗi file cần 1 cipher riêng, vd. cipherFilesBulk)
+template <class Cipher>
+PipelineCipher makePipelineCipher(std::shared_ptr<Cipher> cipher)
+{
+    PipelineCipher ops;
+    ops.update = [cipher](const uint8_t *src, std::size_t len, uint8_t *dst)
+    { return cipher->update(src, len, dst); };
+    ops.final = [cipher](uint8_t *dst)
+    { return cipher->final(dst); };
+    return ops;
+}
@@ -0,0 +1,824 @@
+#include "server.h"
+#include "cbc.h"
+#include "ctr.h"
+#include "gcm.h"
+#include "key_cache.h"
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#if defined(__linux__)
+#define SERVER_EPOLL 1
+#include <csignal>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+using Clock = std::chrono::steady_clock;
+
+// ===== frame =====
+
+static void putLe32(uint8_t *p, uint32_t v)
+{
+    for (int i = 0; i < 4; ++i)
+        p[i] = static_cast<uint8_t>(v >> (8 * i));
+}
+
+static uint32_t getLe32(const uint8_t *p)
+{
+    uint32_t v = 0;
+    for (int i = 0; i < 4; ++i)
+        v |= static_cast<uint32_t>(p[i]) << (8 * i);
+    return v;
+}
+
+void encodeRequestHeader(const WireRequest &req, uint8_t out[WireRequestHeaderSize])
+{
+    std::memset(out, 0, WireRequestHeaderSize);
+    putLe32(out, req.length);
+    out[4] = static_cast<uint8_t>(req.op);
+    out[5] = static_cast<uint8_t>(req.mode);
+    putLe32(out + 8, req.id);
+    std::memcpy(out + 12, req.key, 16);
+    std::memcpy(out + 28, req.iv, 16);
+}
+
+WireRequest decodeRequestHeader(const uint8_t in[WireRequestHeaderSize])
+{
+    WireRequest req;
+    req.length = getLe32(in);
+    if (req.length > WireMaxPayload)
+    {
+        throw std::runtime_error("Request payload too large");
+    }
+    if (in[4] != static_cast<uint8_t>(WireOp::Encrypt) && in[4] != static_cast<uint8_t>(WireOp::Decrypt))
+    {
+        throw std::runtime_error("Invalid request op");
+    }
+    if (in[5] > static_cast<uint8_t>(WireMode::Gcm) || in[6] != 0 || in[7] != 0)
+    {
+        throw std::runtime_error("Invalid request mode");
+    }
+    req.op = static_cast<WireOp>(in[4]);
+    req.mode = static_cast<WireMode>(in[5]);
+    req.id = getLe32(in + 8);
+    std::memcpy(req.key, in + 12, 16);
+    std::memcpy(req.iv, in + 28, 16);
+    return req;
+}
+
+static void encodeResponseHeader(uint32_t length, uint8_t status, uint32_t id,
+                                 uint8_t out[WireResponseHeaderSize])
+{
+    std::memset(out, 0, WireResponseHeaderSize);
+    putLe32(out, length);
+    out[4] = status;
+    putLe32(out + 8, id);
+}
+
+std::size_t processWireRequest(const WireRequest &req, const AES128 &aes,
+                               const uint8_t *in, uint8_t *out)
+{
+    const std::size_t len = req.length;
+    bool enc = req.op == WireOp::Encrypt;
+    switch (req.mode)
+    {
+    case WireMode::Cbc:
+        return enc ? cbcEncrypt(in, len, out, len + AES128::BlockSize, aes, req.iv)
+                   : cbcDecrypt(in, len, out, aes, req.iv);
+    case WireMode::CbcNoPad:
+        if (len % AES128::BlockSize != 0)
+        {
+            throw std::runtime_error("No-pad payload size must be multiple of 16");
+        }
+        if (enc)
+            cbcEncryptNoPad(in, len, out, aes, req.iv);
+        else
+            cbcDecryptNoPad(in, len, out, aes, req.iv);
+        return len;
+    case WireMode::Ctr:
+        ctrCrypt(aes, req.iv, 0, in, out, len);
+        return len;
+    case WireMode::Gcm:
+        if (enc)
+        {
+            GcmEncryptor c(aes, req.iv, 12);
+            std::size_t n = c.update(in, len, out);
+            return n + c.final(out + n);
+        }
+        else
+        {
+            GcmDecryptor c(aes, req.iv, 12);
+            std::size_t n = c.update(in, len, out);
+            return n + c.final(out + n);
+        }
+    }
+    throw std::runtime_error("Invalid request mode");
+}
+
+#ifdef SERVER_EPOLL
+
+// ===== server =====
+
+namespace
+{
+
+volatile std::sig_atomic_t g_signalled = 0;
+
+extern "C" void onStopSignal(int)
+{
+    g_signalled = 1;
+}
+
+using Buffer = std::vector<uint8_t>;
+
+// Buffer tái sử dụng (chỉ thread epoll cấp / trả, không cần lock).
+// Buffer giữ nguyên capacity nên request cỡ tương tự không cấp phát lại.
+class BufferPool
+{
+public:
+    std::unique_ptr<Buffer> acquire(std::size_t size)
+    {
+        std::unique_ptr<Buffer> b;
+        if (!spare.empty())
+        {
+            b = std::move(spare.back());
+            spare.pop_back();
+        }
+        else
+        {
+            b.reset(new Buffer);
+        }
+        b->resize(size);
+        return b;
+    }
+
+    void release(std::unique_ptr<Buffer> b)
+    {
+        // buffer quá lớn không giữ lại (1 request 16 MB không chiếm bộ nhớ mãi)
+        if (b && spare.size() < MaxSpare && b->capacity() <= MaxKeptBytes)
+            spare.push_back(std::move(b));
+    }
+
+private:
+    static const std::size_t MaxSpare = 256;
+    static const std::size_t MaxKeptBytes = 1024 * 1024;
+    std::vector<std::unique_ptr<Buffer>> spare;
+};
+
+struct Connection
+{
+    int fd = -1;
+    uint64_t id = 0;
+
+    uint8_t header[WireRequestHeaderSize];
+    std::size_t headerGot = 0;
+    WireRequest req;
+    std::unique_ptr<Buffer> payload; // != nullptr: đang đọc payload
+    std::size_t payloadGot = 0;
+
+    std::deque<std::unique_ptr<Buffer>> outQueue; // response (header + data) chờ ghi
+    std::size_t outOffset = 0;
+    unsigned inFlight = 0;    // request đang ở worker
+    uint32_t events = 0;      // interest đang đăng ký với epoll
+    bool peerClosed = false;  // hết input: đóng sau khi trả hết response
+};
+
+// Kết quả của worker gửi về thread epoll
+struct Completion
+{
+    uint64_t connId;
+    std::unique_ptr<Buffer> in;
+    std::unique_ptr<Buffer> out; // response hoàn chỉnh
+    bool ok;
+    std::size_t bytesOut;
+};
+
+const unsigned MaxInFlightPerConnection = 64;
+const uint64_t ListenTag = 0;
+const uint64_t WakeTag = 1; // id connection bắt đầu từ 2
+
+class Server
+{
+public:
+    explicit Server(const ServeOptions &opt)
+        : opt(opt), keys(opt.keyCacheSize), pool(opt.threads)
+    {
+        listenFd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (listenFd < 0)
+        {
+            throw std::runtime_error("Cannot create Unix socket");
+        }
+        sockaddr_un addr;
+        std::memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        if (opt.socketPath.empty() || opt.socketPath.size() >= sizeof(addr.sun_path))
+        {
+            ::close(listenFd);
+            throw std::runtime_error("Invalid socket path: " + opt.socketPath);
+        }
+        std::memcpy(addr.sun_path, opt.socketPath.c_str(), opt.socketPath.size());
+        int rc = ::bind(listenFd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr));
+        if (rc != 0 && errno == EADDRINUSE && staleSocket(addr))
+        {
+            // file socket còn lại từ server đã chết: xoá rồi bind lại
+            ::unlink(opt.socketPath.c_str());
+            rc = ::bind(listenFd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr));
+        }
+        if (rc != 0 || ::listen(listenFd, 128) != 0)
+        {
+            int err = errno;
+            ::close(listenFd);
+            throw std::runtime_error("Cannot listen on " + opt.socketPath + ": " + std::strerror(err));
+        }
+
+        epollFd = ::epoll_create1(EPOLL_CLOEXEC);
+        wakeFd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (epollFd < 0 || wakeFd < 0)
+        {
+            cleanup();
+            throw std::runtime_error("epoll / eventfd setup failed");
+        }
+        addFd(listenFd, EPOLLIN, ListenTag);
+        addFd(wakeFd, EPOLLIN, WakeTag);
+    }
+
+    ~Server()
+    {
+        // worker còn chạy có thể ghi wakeFd / completions: chờ xong rồi mới đóng
+        try
+        {
+            pool.wait();
+        }
+        catch (...)
+        {
+        }
+        for (auto &c : conns)
+            ::close(c.second->fd);
+        cleanup();
+    }
+
+    ServeStats run()
+    {
+        epoll_event events[64];
+        while (!g_signalled && !(opt.stop && opt.stop->load()))
+        {
+            int n = ::epoll_wait(epollFd, events, 64, 100);
+            if (n < 0)
+            {
+                if (errno == EINTR)
+                    continue;
+                throw std::runtime_error("epoll_wait failed");
+            }
+            for (int i = 0; i < n; ++i)
+            {
+                uint64_t tag = events[i].data.u64;
+                if (tag == ListenTag)
+                    acceptAll();
+                else if (tag == WakeTag)
+                    drainCompletions();
+                else
+                    onConnectionEvent(tag, events[i].events);
+            }
+        }
+        pool.wait();
+        drainCompletions();
+
+        stats.keysExpanded = keys.expanded();
+        stats.keysReused = keys.reused();
+        return stats;
+    }
+
+private:
+    ServeOptions opt;
+    KeyScheduleCache keys;
+    BufferPool buffers;
+    int listenFd = -1;
+    int epollFd = -1;
+    int wakeFd = -1;
+    uint64_t nextConnId = 2;
+    std::map<uint64_t, std::unique_ptr<Connection>> conns;
+    ServeStats stats;
+
+    std::mutex completionMutex;
+    std::vector<Completion> completions;
+
+    // khai báo cuối: huỷ trước (join worker) khi các thành viên trên còn sống
+    ThreadPool pool;
+
+    // true nếu không còn server nào nghe trên đường dẫn này
+    static bool staleSocket(const sockaddr_un &addr)
+    {
+        int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd < 0)
+            return false;
+        bool stale = ::connect(fd, reinterpret_cast<const sockaddr *>(&addr), sizeof(addr)) != 0 &&
+                     errno == ECONNREFUSED;
+        ::close(fd);
+        return stale;
+    }
+
+    void cleanup()
+    {
+        if (wakeFd >= 0)
+            ::close(wakeFd);
+        if (epollFd >= 0)
+            ::close(epollFd);
+        if (listenFd >= 0)
+        {
+            ::close(listenFd);
+            ::unlink(opt.socketPath.c_str());
+        }
+    }
+
+    void addFd(int fd, uint32_t events, uint64_t tag)
+    {
+        epoll_event ev;
+        std::memset(&ev, 0, sizeof(ev));
+        ev.events = events;
+        ev.data.u64 = tag;
+        if (::epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &ev) != 0)
+        {
+            throw std::runtime_error("epoll_ctl failed");
+        }
+    }
+
+    void acceptAll()
+    {
+        for (;;)
+        {
+            int fd = ::accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (fd < 0)
+            {
+                if (errno == EINTR || errno == ECONNABORTED)
+                    continue;
+                return; // EAGAIN, hoặc hết fd: thử lại lần sau
+            }
+            std::unique_ptr<Connection> c(new Connection);
+            c->fd = fd;
+            c->id = nextConnId++;
+            c->events = EPOLLIN;
+            addFd(fd, c->events, c->id);
+            conns[c->id] = std::move(c);
+            ++stats.connections;
+        }
+    }
+
+    void closeConnection(Connection &c)
+    {
+        ::close(c.fd); // tự gỡ khỏi epoll
+        for (auto &b : c.outQueue)
+            buffers.release(std::move(b));
+        buffers.release(std::move(c.payload));
+        conns.erase(c.id); // c bị huỷ ở đây
+    }
+
+    // Đăng ký lại epoll: ngừng đọc khi quá nhiều request đang chạy, chờ ghi khi còn response
+    void updateInterest(Connection &c)
+    {
+        uint32_t want = 0;
+        if (!c.peerClosed && c.inFlight < MaxInFlightPerConnection)
+            want |= EPOLLIN;
+        if (!c.outQueue.empty())
+            want |= EPOLLOUT;
+        if (want == c.events)
+            return;
+        epoll_event ev;
+        std::memset(&ev, 0, sizeof(ev));
+        ev.events = want;
+        ev.data.u64 = c.id;
+        ::epoll_ctl(epollFd, EPOLL_CTL_MOD, c.fd, &ev);
+        c.events = want;
+    }
+
+    void onConnectionEvent(uint64_t id, uint32_t events)
+    {
+        auto it = conns.find(id);
+        if (it == conns.end())
+            return;
+        Connection &c = *it->second;
+
+        if (events & (EPOLLERR | EPOLLHUP) && !(events & EPOLLIN))
+        {
+            closeConnection(c);
+            return;
+        }
+        if ((events & EPOLLOUT) && !flush(c))
+            return;
+        if ((events & EPOLLIN) && !readRequests(c))
+            return;
+        if (!maybeClose(c))
+            updateInterest(c);
+    }
+
+    // false nếu connection đã bị đóng
+    bool maybeClose(Connection &c)
+    {
+        if (c.peerClosed && c.inFlight == 0 && c.outQueue.empty())
+        {
+            closeConnection(c);
+            return false;
+        }
+        return true;
+    }
+
+    // Đọc mọi request đã tới; false nếu connection đã bị đóng
+    bool readRequests(Connection &c)
+    {
+        while (c.inFlight < MaxInFlightPerConnection)
+        {
+            uint8_t *dst;
+            std::size_t want;
+            if (!c.payload)
+            {
+                dst = c.header + c.headerGot;
+                want = WireRequestHeaderSize - c.headerGot;
+            }
+            else
+            {
+                dst = c.payload->data() + c.payloadGot;
+                want = c.req.length - c.payloadGot;
+            }
+
+            ssize_t n = ::read(c.fd, dst, want);
+            if (n < 0)
+            {
+                if (errno == EINTR)
+                    continue;
+                if (errno == EAGAIN || errno == EWOULDBLOCK)
+                    return true;
+                closeConnection(c);
+                return false;
+            }
+            if (n == 0)
+            {
+                // client đóng chiều ghi: trả nốt response rồi đóng
+                c.peerClosed = true;
+                if (c.headerGot > 0 || c.payload)
+                {
+                    closeConnection(c); // frame dở dang
+                    return false;
+                }
+                return true;
+            }
+
+            if (!c.payload)
+            {
+                c.headerGot += static_cast<std::size_t>(n);
+                if (c.headerGot < WireRequestHeaderSize)
+                    continue;
+                try
+                {
+                    c.req = decodeRequestHeader(c.header);
+                }
+                catch (const std::exception &)
+                {
+                    closeConnection(c); // header sai: không đồng bộ lại được stream
+                    return false;
+                }
+                c.payload = buffers.acquire(c.req.length);
+                c.payloadGot = 0;
+            }
+            else
+            {
+                c.payloadGot += static_cast<std::size_t>(n);
+            }
+
+            if (c.payload && c.payloadGot == c.req.length)
+            {
+                dispatch(c);
+                c.headerGot = 0;
+            }
+        }
+        return true;
+    }
+
+    void dispatch(Connection &c)
+    {
+        ++c.inFlight;
+        ++stats.requests;
+        stats.bytesIn += c.req.length;
+
+        WireRequest req = c.req;
+        uint64_t connId = c.id;
+        auto in = std::make_shared<std::unique_ptr<Buffer>>(std::move(c.payload));
+        auto out = std::make_shared<std::unique_ptr<Buffer>>(
+            buffers.acquire(WireResponseHeaderSize + req.length + AES128::BlockSize));
+
+        pool.submit([this, req, connId, in, out]()
+                    {
+                        Buffer &ob = **out;
+                        bool ok = true;
+                        std::size_t n = 0;
+                        try
+                        {
+                            std::shared_ptr<const AES128> aes = keys.get(req.key);
+                            n = processWireRequest(req, *aes, (*in)->data(), ob.data() + WireResponseHeaderSize);
+                        }
+                        catch (const std::exception &ex)
+                        {
+                            ok = false;
+                            std::string msg = ex.what();
+                            n = std::min(msg.size(), ob.size() - WireResponseHeaderSize);
+                            if (n < msg.size())
+                            {
+                                ob.resize(WireResponseHeaderSize + msg.size());
+                                n = msg.size();
+                            }
+                            std::memcpy(ob.data() + WireResponseHeaderSize, msg.data(), n);
+                        }
+                        encodeResponseHeader(static_cast<uint32_t>(n), ok ? 0 : 1, req.id, ob.data());
+                        ob.resize(WireResponseHeaderSize + n);
+
+                        {
+                            std::lock_guard<std::mutex> lock(completionMutex);
+                            completions.push_back(Completion{connId, std::move(*in), std::move(*out), ok, n});
+                        }
+                        uint64_t one = 1;
+                        if (::write(wakeFd, &one, sizeof(one)) < 0)
+                        {
+                            // eventfd chỉ lỗi khi bộ đếm tràn: thread epoll vẫn được đánh thức
+                        } });
+    }
+
+    void drainCompletions()
+    {
+        uint64_t value;
+        while (::read(wakeFd, &value, sizeof(value)) > 0)
+        {
+        }
+
+        std::vector<Completion> done;
+        {
+            std::lock_guard<std::mutex> lock(completionMutex);
+            done.swap(completions);
+        }
+        for (auto &d : done)
+        {
+            buffers.release(std::move(d.in));
+            if (d.ok)
+                stats.bytesOut += d.bytesOut;
+            else
+                ++stats.errors;
+
+            auto it = conns.find(d.connId);
+            if (it == conns.end())
+            {
+                buffers.release(std::move(d.out)); // client đã ngắt
+                continue;
+            }
+            Connection &c = *it->second;
+            --c.inFlight;
+            c.outQueue.push_back(std::move(d.out));
+            // ghi ngay: thường xong luôn, không cần chờ EPOLLOUT.
+            // epoll level-triggered: bật lại EPOLLIN là đọc tiếp phần request còn trong socket.
+            if (flush(c) && maybeClose(c))
+                updateInterest(c);
+        }
+    }
+
+    // Ghi response đang chờ; false nếu connection đã bị đóng
+    bool flush(Connection &c)
+    {
+        while (!c.outQueue.empty())
+        {
+            Buffer &b = *c.outQueue.front();
+            ssize_t n = ::send(c.fd, b.data() + c.outOffset, b.size() - c.outOffset, MSG_NOSIGNAL);
+            if (n < 0)
+            {
+                if (errno == EINTR)
+                    continue;
+                if (errno == EAGAIN || errno == EWOULDBLOCK)
+                    return true;
+                closeConnection(c);
+                return false;
+            }
+            c.outOffset += static_cast<std::size_t>(n);
+            if (c.outOffset == b.size())
+            {
+                buffers.release(std::move(c.outQueue.front()));
+                c.outQueue.pop_front();
+                c.outOffset = 0;
+            }
+        }
+        return true;
+    }
+};
+
+} // namespace
+
+ServeStats runServer(const ServeOptions &options, std::ostream &log)
+{
+    g_signalled = 0;
+    if (!options.stop)
+    {
+        // chạy như daemon: Ctrl-C / kill dừng vòng epoll, xoá file socket
+        struct sigaction sa;
+        std::memset(&sa, 0, sizeof(sa));
+        sa.sa_handler = onStopSignal; // không SA_RESTART: epoll_wait trả EINTR ngay
+        sigemptyset(&sa.sa_mask);
+        ::sigaction(SIGINT, &sa, nullptr);
+        ::sigaction(SIGTERM, &sa, nullptr);
+    }
+
+    Server server(options);
+    log << "Listening on " << options.socketPath << " (backend "
+        << AES128::backendName(AES128::defaultBackend()) << ")\n";
+    return server.run();
+}
+
+// ===== load generator =====
+
+static void sendAll(int fd, const uint8_t *p, std::size_t len)
+{
+    while (len > 0)
+    {
+        ssize_t n = ::send(fd, p, len, MSG_NOSIGNAL);
+        if (n < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            throw std::runtime_error("send failed");
+        }
+        p += n;
+        len -= static_cast<std::size_t>(n);
+    }
+}
+
+static void recvAll(int fd, uint8_t *p, std::size_t len)
+{
+    while (len > 0)
+    {
+        ssize_t n = ::recv(fd, p, len, 0);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            throw std::runtime_error("Connection closed by server");
+        p += n;
+        len -= static_cast<std::size_t>(n);
+    }
+}
+
+static int connectUnix(const std::string &path)
+{
+    sockaddr_un addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (path.empty() || path.size() >= sizeof(addr.sun_path))
+    {
+        throw std::runtime_error("Invalid socket path: " + path);
+    }
+    std::memcpy(addr.sun_path, path.c_str(), path.size());
+    int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0 || ::connect(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0)
+    {
+        if (fd >= 0)
+            ::close(fd);
+        throw std::runtime_error("Cannot connect to " + path);
+    }
+    return fd;
+}
+
+LoadGenResult runLoadGen(const LoadGenOptions &opt)
+{
+    if (opt.connections == 0 || opt.requests == 0)
+    {
+        throw std::runtime_error("Load generator needs at least 1 connection and 1 request");
+    }
+    if (opt.payloadSize > WireMaxPayload ||
+        (opt.mode == WireMode::CbcNoPad && opt.payloadSize % AES128::BlockSize != 0))
+    {
+        throw std::runtime_error("Invalid payload size for load generator");
+    }
+
+    std::vector<std::vector<double>> latencies(opt.connections);
+    std::vector<std::string> errors(opt.connections);
+
+    auto worker = [&](unsigned t)
+    {
+        try
+        {
+            int fd = connectUnix(opt.socketPath);
+            std::size_t count = opt.requests / opt.connections +
+                                (t < opt.requests % opt.connections ? 1 : 0);
+
+            WireRequest req;
+            req.length = static_cast<uint32_t>(opt.payloadSize);
+            req.op = WireOp::Encrypt;
+            req.mode = opt.mode;
+            // mỗi connection 1 key: server phải giữ nhiều key trong LRU
+            for (int i = 0; i < 16; ++i)
+            {
+                req.key[i] = static_cast<uint8_t>(t * 16 + i);
+                req.iv[i] = static_cast<uint8_t>(0xA0 + i);
+            }
+            AES128 aes(req.key);
+
+            std::vector<uint8_t> frame(WireRequestHeaderSize + opt.payloadSize);
+            for (std::size_t i = 0; i < opt.payloadSize; ++i)
+                frame[WireRequestHeaderSize + i] = static_cast<uint8_t>(i * 7 + t);
+            std::vector<uint8_t> expected(opt.payloadSize + AES128::BlockSize);
+            expected.resize(processWireRequest(req, aes, frame.data() + WireRequestHeaderSize,
+                                               expected.data()));
+            std::vector<uint8_t> reply(expected.size());
+
+            latencies[t].reserve(count);
+            for (std::size_t r = 0; r < count; ++r)
+            {
+                req.id = static_cast<uint32_t>(r);
+                encodeRequestHeader(req, frame.data());
+
+                auto t0 = Clock::now();
+                sendAll(fd, frame.data(), frame.size());
+                uint8_t head[WireResponseHeaderSize];
+                recvAll(fd, head, sizeof(head));
+                uint32_t len = getLe32(head);
+                if (len > WireMaxPayload)
+                {
+                    throw std::runtime_error("Invalid response length");
+                }
+                reply.resize(len);
+                recvAll(fd, reply.data(), len);
+                latencies[t].push_back(std::chrono::duration<double, std::micro>(Clock::now() - t0).count());
+
+                if (head[4] != 0)
+                {
+                    throw std::runtime_error("Server error: " + std::string(reply.begin(), reply.end()));
+                }
+                if (getLe32(head + 8) != req.id || reply != expected)
+                {
+                    throw std::runtime_error("Response mismatch");
+                }
+            }
+            ::close(fd);
+        }
+        catch (const std::exception &ex)
+        {
+            errors[t] = ex.what();
+        }
+    };
+
+    auto start = Clock::now();
+    std::vector<std::thread> threads;
+    for (unsigned t = 0; t < opt.connections; ++t)
+        threads.emplace_back(worker, t);
+    for (auto &th : threads)
+        th.join();
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    for (const auto &e : errors)
+    {
+        if (!e.empty())
+            throw std::runtime_error(e);
+    }
+
+    std::vector<double> all;
+    for (const auto &l : latencies)
+        all.insert(all.end(), l.begin(), l.end());
+    std::sort(all.begin(), all.end());
+    auto pct = [&](double q)
+    {
+        std::size_t rank = static_cast<std::size_t>(std::ceil(q * static_cast<double>(all.size())));
+        return all[std::min(all.size(), std::max<std::size_t>(rank, 1)) - 1];
+    };
+
+    LoadGenResult res;
+    res.requests = all.size();
+    res.seconds = seconds;
+    res.p50Us = pct(0.50);
+    res.p90Us = pct(0.90);
+    res.p99Us = pct(0.99);
+    res.maxUs = all.back();
+    return res;
+}
+
+#else
+
+ServeStats runServer(const ServeOptions &, std::ostream &)
+{
+    throw std::runtime_error("aes_tool serve needs Linux (epoll + Unix domain sockets)");
+}
+
+LoadGenResult runLoadGen(const LoadGenOptions &)
+{
+    throw std::runtime_error("aes_tool loadgen needs Linux (Unix domain sockets)");
+}
+
+#endif // SERVER_EPOLL
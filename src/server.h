@@ -0,0 +1,106 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+
+#include "aes.h"
+
+// ===== aes_tool serve: server mã hoá qua Unix domain socket =====
+//
+// Mỗi request / response là 1 frame nhị phân (số nguyên little-endian):
+//
+//   request  (44 byte header): length u32 | op u8 | mode u8 | 2 byte 0 | id u32 | key[16] | iv[16]
+//            theo sau là length byte payload
+//   response (12 byte header): length u32 | status u8 | 3 byte 0 | id u32
+//            theo sau là length byte: output nếu status = 0, thông báo lỗi nếu status = 1
+//
+// op: 1 = enc, 2 = dec. mode: 0 = CBC + PKCS#7, 1 = CBC no-pad, 2 = CTR,
+// 3 = GCM (nonce = 12 byte đầu của iv, không AAD, output enc = ct || tag).
+// Client có thể gửi nhiều request liên tiếp; response có thể về không theo thứ tự, ghép bằng id.
+
+constexpr std::size_t WireRequestHeaderSize = 44;
+constexpr std::size_t WireResponseHeaderSize = 12;
+constexpr uint32_t WireMaxPayload = 16 * 1024 * 1024;
+
+enum class WireOp : uint8_t
+{
+    Encrypt = 1,
+    Decrypt = 2
+};
+
+enum class WireMode : uint8_t
+{
+    Cbc = 0,
+    CbcNoPad = 1,
+    Ctr = 2,
+    Gcm = 3
+};
+
+struct WireRequest
+{
+    uint32_t length = 0;
+    WireOp op = WireOp::Encrypt;
+    WireMode mode = WireMode::Cbc;
+    uint32_t id = 0;
+    uint8_t key[16] = {};
+    uint8_t iv[16] = {};
+};
+
+void encodeRequestHeader(const WireRequest &req, uint8_t out[WireRequestHeaderSize]);
+
+// Ném std::runtime_error nếu op / mode / byte dự trữ sai hoặc length > WireMaxPayload
+WireRequest decodeRequestHeader(const uint8_t in[WireRequestHeaderSize]);
+
+// Mã hoá / giải mã payload của 1 request (dùng chung cho server và client kiểm tra).
+// out cần len + 16 byte; trả về số byte output. Ném std::runtime_error nếu dữ liệu sai.
+std::size_t processWireRequest(const WireRequest &req, const AES128 &aes,
+                               const uint8_t *in, uint8_t *out);
+
+struct ServeOptions
+{
+    std::string socketPath;
+    unsigned threads = 0;           // worker mã hoá, 0 = mọi core
+    std::size_t keyCacheSize = 1024; // số key schedule giữ trong LRU
+    // != nullptr: dừng khi cờ được bật (selftest); luôn dừng khi nhận SIGINT / SIGTERM
+    const std::atomic<bool> *stop = nullptr;
+};
+
+struct ServeStats
+{
+    uint64_t connections = 0;
+    uint64_t requests = 0;
+    uint64_t errors = 0; // request trả status lỗi
+    uint64_t bytesIn = 0;
+    uint64_t bytesOut = 0;
+    std::size_t keysExpanded = 0;
+    std::size_t keysReused = 0;
+};
+
+// Linux (epoll): chạy tới khi bị dừng, xoá file socket khi thoát.
+// Nền tảng khác: ném std::runtime_error.
+ServeStats runServer(const ServeOptions &options, std::ostream &log);
+
+// ===== load generator =====
+
+struct LoadGenOptions
+{
+    std::string socketPath;
+    unsigned connections = 4;      // mỗi connection 1 thread, gửi request tuần tự
+    std::size_t requests = 10000;  // tổng số request
+    std::size_t payloadSize = 1024;
+    WireMode mode = WireMode::Cbc;
+};
+
+struct LoadGenResult
+{
+    std::size_t requests = 0;
+    double seconds = 0;
+    double p50Us = 0, p90Us = 0, p99Us = 0, maxUs = 0;
+};
+
+// Gửi request enc, đo latency từng request (gửi -> nhận đủ response),
+// kiểm tra output với AES128 cục bộ; ném std::runtime_error nếu sai.
+LoadGenResult runLoadGen(const LoadGenOptions &options);
@@ -0,0 +1,133 @@
+#include "thread_pool.h"
+
+// worker hiện tại thuộc pool nào (nullptr: không phải worker)
+static thread_local const ThreadPool *t_pool = nullptr;
+static thread_local unsigned t_index = 0;
+
+ThreadPool::ThreadPool(unsigned threads)
+{
+    if (threads == 0)
+        threads = std::thread::hardware_concurrency();
+    if (threads == 0)
+        threads = 1;
+
+    for (unsigned i = 0; i < threads; ++i)
+        queues.push_back(std::make_unique<Queue>());
+    for (unsigned i = 0; i < threads; ++i)
+        workers.emplace_back([this, i]
+                             { workerLoop(i); });
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m);
+        stopping = true;
+    }
+    workCv.notify_all();
+    for (auto &t : workers)
+        t.join();
+}
+
+void ThreadPool::submit(std::function<void()> task)
+{
+    unsigned target = (t_pool == this)
+                          ? t_index
+                          : nextQueue.fetch_add(1, std::memory_order_relaxed) % size();
+
+    // đẩy vào hàng đợi trong lúc giữ m để queued luôn >= số task thực có
+    {
+        std::lock_guard<std::mutex> lock(m);
+        {
+            std::lock_guard<std::mutex> qlock(queues[target]->m);
+            queues[target]->tasks.push_back(std::move(task));
+        }
+        ++queued;
+        ++pending;
+    }
+    workCv.notify_one();
+}
+
+void ThreadPool::wait()
+{
+    std::unique_lock<std::mutex> lock(m);
+    idleCv.wait(lock, [this]
+                { return pending == 0; });
+    if (firstError)
+    {
+        std::exception_ptr e = firstError;
+        firstError = nullptr;
+        std::rethrow_exception(e);
+    }
+}
+
+bool ThreadPool::takeTask(unsigned self, std::function<void()> &task)
+{
+    // 1) hàng đợi của mình: lấy từ cuối
+    {
+        Queue &q = *queues[self];
+        std::lock_guard<std::mutex> lock(q.m);
+        if (!q.tasks.empty())
+        {
+            task = std::move(q.tasks.back());
+            q.tasks.pop_back();
+            return true;
+        }
+    }
+
+    // 2) steal: lấy từ đầu hàng đợi của worker khác
+    for (unsigned k = 1; k < size(); ++k)
+    {
+        Queue &q = *queues[(self + k) % size()];
+        std::lock_guard<std::mutex> lock(q.m);
+        if (!q.tasks.empty())
+        {
+            task = std::move(q.tasks.front());
+            q.tasks.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+void ThreadPool::workerLoop(unsigned self)
+{
+    t_pool = this;
+    t_index = self;
+
+    for (;;)
+    {
+        std::function<void()> task;
+        if (takeTask(self, task))
+        {
+            {
+                std::lock_guard<std::mutex> lock(m);
+                --queued;
+            }
+
+            std::exception_ptr error;
+            try
+            {
+                task();
+            }
+            catch (...)
+            {
+                error = std::current_exception();
+            }
+            task = nullptr; // huỷ capture trước khi báo xong
+
+            std::lock_guard<std::mutex> lock(m);
+            if (error && !firstError)
+                firstError = error;
+            if (--pending == 0)
+                idleCv.notify_all();
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(m);
+        workCv.wait(lock, [this]
+                    { return stopping || queued > 0; });
+        if (stopping && queued == 0)
+            return;
+    }
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Thread pool work-stealing:
+// mỗi worker có hàng đợi riêng, lấy task mới nhất của mình (LIFO, còn nóng trong cache),
+// hết việc thì lấy task cũ nhất của worker khác (FIFO).
+class ThreadPool
+{
+public:
+    // threads = 0: dùng std::thread::hardware_concurrency()
+    explicit ThreadPool(unsigned threads = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    unsigned size() const { return static_cast<unsigned>(workers.size()); }
+
+    // Gọi từ ngoài pool: chia vòng tròn cho các worker.
+    // Gọi từ trong 1 task: đẩy vào hàng đợi của chính worker đó.
+    void submit(std::function<void()> task);
+
+    // Chờ mọi task đã submit chạy xong.
+    // Task ném exception thì wait() ném lại exception đầu tiên.
+    void wait();
+
+private:
+    struct Queue
+    {
+        std::mutex m;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::vector<std::thread> workers;
+
+    std::mutex m;
+    std::condition_variable workCv; // có task mới / dừng
+    std::condition_variable idleCv; // pending về 0
+    std::size_t queued = 0;         // task còn nằm trong hàng đợi
+    std::size_t pending = 0;        // task chưa chạy xong
+    bool stopping = false;
+    std::exception_ptr firstError;
+    std::atomic<unsigned> nextQueue{0};
+
+    void workerLoop(unsigned self);
+    bool takeTask(unsigned self, std::function<void()> &task);
+};